@@ -126,14 +126,39 @@ classdef DXTImage
 			obj = DXTImage(dxtmex('PREMULTIPLY_ALPHA', struct(obj), varargin{:}));
 		end
 		
-		function obj = compress(obj, varargin)
-			obj = DXTImage(dxtmex('COMPRESS', struct(obj), varargin{:}));
+		function [varargout] = compress(obj, varargin)
+			% [obj, num_fast_blocks, formats, bits_per_texel] = compress(obj, flags...)
+			% only the requested outputs are computed
+			[varargout{1:max(nargout, 1)}] = dxtmex('COMPRESS', struct(obj), varargin{:});
+			if(iscell(varargout{1}))
+				% one variant per requested format
+				varargout{1} = cellfun(@DXTImage, varargout{1}, 'UniformOutput', false);
+			else
+				varargout{1} = DXTImage(varargout{1});
+			end
 		end
 		
 		function obj = decompress(obj, varargin)
 			obj = DXTImage(dxtmex('DECOMPRESS', struct(obj), varargin{:}));
 		end
 		
+		function obj = transcode(obj, fmt, varargin)
+			obj = DXTImage(dxtmex('TRANSCODE', struct(obj), fmt, varargin{:}));
+		end
+		
+		function job = compressAsync(obj, varargin)
+			% returns a job id right away, see DXTImage.fetchJob
+			job = dxtmex('ASYNC_COMPRESS', struct(obj), varargin{:});
+		end
+		
+		function job = decompressAsync(obj, varargin)
+			job = dxtmex('ASYNC_DECOMPRESS', struct(obj), varargin{:});
+		end
+		
+		function job = transcodeAsync(obj, fmt, varargin)
+			job = dxtmex('ASYNC_TRANSCODE', struct(obj), fmt, varargin{:});
+		end
+		
 		function obj = computeNormalMap(obj, varargin)
 			obj = DXTImage(dxtmex('COMPUTE_NORMAL_MAP', struct(obj), varargin{:}));
 		end
@@ -142,6 +167,10 @@ classdef DXTImage
 			obj = DXTImage(dxtmex('COPY_RECTANGLE', struct(obj), struct(src), varargin{:}));
 		end
 		
+		function obj = updateRegion(obj, src, varargin)
+			obj = DXTImage(dxtmex('UPDATE_REGION', struct(obj), struct(src), varargin{:}));
+		end
+		
 		function s = struct(obj)
 			m = size(obj,1);
 			n = size(obj,2);
@@ -287,6 +316,31 @@ classdef DXTImage
 			obj = DXTImage(dxtmex('READ_TGA',varargin{:}));
 		end
 		
+		function job = ddsreadAsync(varargin)
+			job = dxtmex('ASYNC_READ_DDS',varargin{:});
+		end
+		
+		function job = hdrreadAsync(varargin)
+			job = dxtmex('ASYNC_READ_HDR',varargin{:});
+		end
+		
+		function job = tgareadAsync(varargin)
+			job = dxtmex('ASYNC_READ_TGA',varargin{:});
+		end
+		
+		function done = isJobDone(job)
+			done = dxtmex('POLL', job);
+		end
+		
+		function done = waitJob(job, varargin)
+			% waitJob(job, timeout) gives up after timeout seconds
+			done = dxtmex('WAIT', job, varargin{:});
+		end
+		
+		function obj = fetchJob(job)
+			obj = DXTImage(dxtmex('FETCH', job));
+		end
+		
 		function metadata = ddsfinfo(varargin)
 			metadata = dxtmex('READ_DDS_META', varargin{:});
 		end
@@ -300,12 +354,21 @@ classdef DXTImage
 		end
 		
 		function [varargout] = computeMSE(cmp1, cmp2, varargin)
-			if(nargout == 0)
-				varargout{1} = DXTImage(dxtmex('COMPUTE_MSE', struct(cmp1), struct(cmp2), varargin{:}));
-			else
-				varargout{1:nargout} = DXTImage(dxtmex('COMPUTE_MSE', struct(cmp1), struct(cmp2), varargin{:}));
-			end
-			
+			% [mse, mseV, psnr, maxerr, map] = computeMSE(cmp1, cmp2, flags..., 'BlockSize', n)
+			% map holds the mse of each n by n block, 4 by default
+			[varargout{1:max(nargout, 1)}] = dxtmex('COMPUTE_MSE', struct(cmp1), struct(cmp2), varargin{:});
+		end
+		
+		function [varargout] = computeSSIM(cmp1, cmp2, varargin)
+			% [ssim, ssimV, map] = computeSSIM(cmp1, cmp2, flags..., 'MultiScale', tf)
+			% map holds the single-scale ssim of each pixel
+			[varargout{1:max(nargout, 1)}] = dxtmex('COMPUTE_SSIM', struct(cmp1), struct(cmp2), varargin{:});
+		end
+		
+		function report = compressionReport(src, cmp, varargin)
+			% report = compressionReport(src, cmp, flags..., 'TopK', k, 'Edges', psnr)
+			% the 4 by 4 block errors of block compressed cmp against src, binned by psnr
+			report = dxtmex('COMPRESSION_REPORT', struct(src), struct(cmp), varargin{:});
 		end
 		
 	end
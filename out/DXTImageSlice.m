@@ -40,14 +40,26 @@ classdef DXTImageSlice
 			h = imshow(toimage(obj));
 		end
 		
-		function varargout = toimage(obj)
+		function varargout = toimage(obj, varargin)
+			% TOIMAGE  Convert the slice to an image.
+			%   IMG = TOIMAGE(OBJ, 'Output', BUF) fills BUF in place
+			%   like TOMATRIX. BUF must not share data with any other variable
+			%   (for example after PREV = BUF), since those change with it.
 			nout = max(nargout,1);
-			[varargout{1:nout}] = dxtmex('TO_IMAGE', struct(obj));
-		end
-		
-		function varargout = tomatrix(obj)
+			[varargout{1:nout}] = dxtmex('TO_IMAGE', struct(obj), varargin{:});
+		end
+		
+		function varargout = tomatrix(obj, varargin)
+			% TOMATRIX  Extract the raw channels of the slice.
+			%   M = TOMATRIX(OBJ, 'Output', BUF) fills the existing array
+			%   BUF in place instead of allocating a new one. BUF must have
+			%   the size and class that TOMATRIX would otherwise return.
+			%   BUF is written without a copy, so it must not share data with
+			%   any other variable: after PREV = BUF, PREV changes as well.
+			%   M = TOMATRIX(OBJ, 'Layout', 'interleaved') returns the
+			%   channels first (C x W x H) in the same order as the pixels.
 			nout = max(nargout,1);
-			[varargout{1:nout}] = dxtmex('TO_MATRIX', struct(obj));
+			[varargout{1:nout}] = dxtmex('TO_MATRIX', struct(obj), varargin{:});
 		end
 		
 		function ddswrite(obj, varargin)
@@ -117,14 +129,39 @@ classdef DXTImageSlice
 			obj = DXTImage(dxtmex('PREMULTIPLY_ALPHA', struct(obj), varargin{:}));
 		end
 		
-		function obj = compress(obj, varargin)
-			obj = DXTImage(dxtmex('COMPRESS', struct(obj), varargin{:}));
+		function [varargout] = compress(obj, varargin)
+			% [obj, num_fast_blocks, formats, bits_per_texel] = compress(obj, flags...)
+			% only the requested outputs are computed
+			[varargout{1:max(nargout, 1)}] = dxtmex('COMPRESS', struct(obj), varargin{:});
+			if(iscell(varargout{1}))
+				% one variant per requested format
+				varargout{1} = cellfun(@DXTImage, varargout{1}, 'UniformOutput', false);
+			else
+				varargout{1} = DXTImage(varargout{1});
+			end
 		end
 		
 		function obj = decompress(obj, varargin)
 			obj = DXTImage(dxtmex('DECOMPRESS', struct(obj), varargin{:}));
 		end
 		
+		function obj = transcode(obj, fmt, varargin)
+			obj = DXTImage(dxtmex('TRANSCODE', struct(obj), fmt, varargin{:}));
+		end
+		
+		function job = compressAsync(obj, varargin)
+			% returns a job id right away, see DXTImage.fetchJob
+			job = dxtmex('ASYNC_COMPRESS', struct(obj), varargin{:});
+		end
+		
+		function job = decompressAsync(obj, varargin)
+			job = dxtmex('ASYNC_DECOMPRESS', struct(obj), varargin{:});
+		end
+		
+		function job = transcodeAsync(obj, fmt, varargin)
+			job = dxtmex('ASYNC_TRANSCODE', struct(obj), fmt, varargin{:});
+		end
+		
 		function obj = computeNormalMap(obj, varargin)
 			obj = DXTImage(dxtmex('COMPUTE_NORMAL_MAP', struct(obj), varargin{:}));
 		end
@@ -13,7 +13,7 @@ function BUILD
 	library_path = fullfile(thisfolder, 'lib', 'DirectXTex', 'DirectXTex', 'Bin', 'Desktop_2017', 'x64', 'Release');
 
 	mexflags = {'-O', '-v', '-outdir', output_path, ...
-		['-I' header_path], ['-L' library_path], '-lDirectXTex'};
+		['-I' header_path], ['-L' library_path], '-lDirectXTex', '-lut'};
 
 	if(opts.debug)
 		mexflags = [mexflags {'-g'}];
@@ -26,7 +26,17 @@ function BUILD
 		'dxtmex_maps.cpp',...
 		'dxtmex_dxtimagearray.cpp',...
 		'dxtmex_dxtimage.cpp',...
-		'dxtmex_pixel.cpp'
+		'dxtmex_pixel.cpp',...
+		'dxtmex_ddsstream.cpp',...
+		'dxtmex_compress.cpp',...
+		'dxtmex_blockops.cpp',...
+		'dxtmex_progress.cpp',...
+		'dxtmex_jobs.cpp',...
+		'dxtmex_stats.cpp',...
+		'dxtmex_trace.cpp',...
+		'dxtmex_bench.cpp',...
+		'dxtmex_simd.cpp',...
+		'dxtmex_metrics.cpp'
 		};
 
 	for i = 1:numel(sources)
@@ -0,0 +1,330 @@
+/* benchcompare baseline.json results.json [threshold] [sigma]
+ * compares the medians of two BENCHMARK runs and exits with 1 if anything got slower by more than both
+ * the relative threshold and sigma times the pooled median absolute deviation of the samples */
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+	constexpr double DEFAULT_THRESHOLD = 0.05;
+	constexpr double DEFAULT_SIGMA     = 3.0;
+
+	/* scales the MAD to a standard deviation for normally distributed samples */
+	constexpr double MAD_SCALE = 1.4826;
+
+	enum EXIT_CODE
+	{
+		EXIT_OK         = 0,
+		EXIT_REGRESSION = 1,
+		EXIT_ERROR      = 2
+	};
+
+	using Results = std::map<std::string, std::vector<double>>;
+
+	/* just enough of JSON to read what BENCHMARK writes */
+	class Parser
+	{
+	public:
+		explicit Parser(const std::string& text) : _text(text), _pos(0) {}
+
+		bool Parse(Results& results)
+		{
+			return this->ParseObject([&](const std::string& key) -> bool
+			{
+				if(key == "benchmarks")
+				{
+					return this->ParseArray([&]() -> bool {return this->ParseBenchmark(results);});
+				}
+				return this->SkipValue();
+			});
+		}
+
+	private:
+		const std::string& _text;
+		size_t             _pos;
+
+		void SkipSpace()
+		{
+			while(this->_pos < this->_text.size() && isspace(static_cast<unsigned char>(this->_text[this->_pos])))
+			{
+				this->_pos++;
+			}
+		}
+
+		bool Expect(char c)
+		{
+			this->SkipSpace();
+			if(this->_pos < this->_text.size() && this->_text[this->_pos] == c)
+			{
+				this->_pos++;
+				return true;
+			}
+			return false;
+		}
+
+		bool Peek(char c)
+		{
+			this->SkipSpace();
+			return this->_pos < this->_text.size() && this->_text[this->_pos] == c;
+		}
+
+		bool ParseString(std::string& out)
+		{
+			out.clear();
+			if(!this->Expect('"'))
+			{
+				return false;
+			}
+			while(this->_pos < this->_text.size() && this->_text[this->_pos] != '"')
+			{
+				if(this->_text[this->_pos] == '\\' && this->_pos + 1 < this->_text.size())
+				{
+					this->_pos++;
+				}
+				out.push_back(this->_text[this->_pos++]);
+			}
+			return this->Expect('"');
+		}
+
+		bool ParseNumber(double& out)
+		{
+			this->SkipSpace();
+			const char* start = this->_text.c_str() + this->_pos;
+			char* end;
+			out = strtod(start, &end);
+			if(end == start)
+			{
+				return false;
+			}
+			this->_pos += end - start;
+			return true;
+		}
+
+		template <typename F>
+		bool ParseObject(F&& on_member)
+		{
+			std::string key;
+			if(!this->Expect('{'))
+			{
+				return false;
+			}
+			if(this->Expect('}'))
+			{
+				return true;
+			}
+			do
+			{
+				if(!this->ParseString(key) || !this->Expect(':') || !on_member(key))
+				{
+					return false;
+				}
+			} while(this->Expect(','));
+			return this->Expect('}');
+		}
+
+		template <typename F>
+		bool ParseArray(F&& on_element)
+		{
+			if(!this->Expect('['))
+			{
+				return false;
+			}
+			if(this->Expect(']'))
+			{
+				return true;
+			}
+			do
+			{
+				if(!on_element())
+				{
+					return false;
+				}
+			} while(this->Expect(','));
+			return this->Expect(']');
+		}
+
+		bool SkipValue()
+		{
+			std::string str;
+			double num;
+			if(this->Peek('{'))
+			{
+				return this->ParseObject([&](const std::string&) {return this->SkipValue();});
+			}
+			else if(this->Peek('['))
+			{
+				return this->ParseArray([&] {return this->SkipValue();});
+			}
+			else if(this->Peek('"'))
+			{
+				return this->ParseString(str);
+			}
+			for(const char* literal : {"true", "false", "null"})
+			{
+				if(this->_text.compare(this->_pos, strlen(literal), literal) == 0)
+				{
+					this->_pos += strlen(literal);
+					return true;
+				}
+			}
+			return this->ParseNumber(num);
+		}
+
+		bool ParseBenchmark(Results& results)
+		{
+			std::string name;
+			std::vector<double> samples;
+			const bool is_valid = this->ParseObject([&](const std::string& key) -> bool
+			{
+				if(key == "name")
+				{
+					return this->ParseString(name);
+				}
+				else if(key == "samples")
+				{
+					return this->ParseArray([&]() -> bool
+					{
+						double sample;
+						if(!this->ParseNumber(sample))
+						{
+							return false;
+						}
+						samples.push_back(sample);
+						return true;
+					});
+				}
+				return this->SkipValue();
+			});
+			if(!is_valid || name.empty() || samples.empty())
+			{
+				return false;
+			}
+			results[name] = std::move(samples);
+			return true;
+		}
+	};
+
+	bool ReadResults(const char* path, Results& results)
+	{
+		std::ifstream in(path);
+		if(!in.is_open())
+		{
+			fprintf(stderr, "Could not open '%s'.\n", path);
+			return false;
+		}
+		std::stringstream buffer;
+		buffer << in.rdbuf();
+		const std::string text = buffer.str();
+		if(!Parser(text).Parse(results))
+		{
+			fprintf(stderr, "Could not parse '%s'.\n", path);
+			return false;
+		}
+		return true;
+	}
+
+	double Median(std::vector<double> values)
+	{
+		const size_t mid = values.size() / 2;
+		std::nth_element(values.begin(), values.begin() + mid, values.end());
+		if(values.size() % 2 == 1)
+		{
+			return values[mid];
+		}
+		const double upper = values[mid];
+		return (*std::max_element(values.begin(), values.begin() + mid) + upper) / 2.0;
+	}
+
+	double MedianAbsoluteDeviation(const std::vector<double>& values, double median)
+	{
+		std::vector<double> deviations;
+		deviations.reserve(values.size());
+		for(double value : values)
+		{
+			deviations.push_back(std::abs(value - median));
+		}
+		return Median(deviations);
+	}
+
+	bool ParseOption(const char* arg, double& out)
+	{
+		char* end;
+		out = strtod(arg, &end);
+		return end != arg && *end == '\0' && out >= 0;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	double threshold = DEFAULT_THRESHOLD;
+	double sigma = DEFAULT_SIGMA;
+	if(argc < 3 || argc > 5 || (argc > 3 && !ParseOption(argv[3], threshold)) || (argc > 4 && !ParseOption(argv[4], sigma)))
+	{
+		fprintf(stderr, "Usage: %s baseline.json results.json [threshold=%g] [sigma=%g]\n", argv[0], DEFAULT_THRESHOLD, DEFAULT_SIGMA);
+		return EXIT_ERROR;
+	}
+
+	Results baseline, current;
+	if(!ReadResults(argv[1], baseline) || !ReadResults(argv[2], current))
+	{
+		return EXIT_ERROR;
+	}
+
+	size_t num_regressions = 0;
+	printf("%-48s %12s %12s %9s %12s  %s\n", "benchmark", "base (ms)", "new (ms)", "delta", "noise (ms)", "verdict");
+	for(const auto& entry : current)
+	{
+		const auto base_iter = baseline.find(entry.first);
+		const double new_median = Median(entry.second);
+		if(base_iter == baseline.end())
+		{
+			printf("%-48s %12s %12.3f %9s %12s  new\n", entry.first.c_str(), "-", new_median * 1e3, "-", "-");
+			continue;
+		}
+
+		const double base_median = Median(base_iter->second);
+		const double base_mad = MedianAbsoluteDeviation(base_iter->second, base_median);
+		const double new_mad = MedianAbsoluteDeviation(entry.second, new_median);
+		const double delta = new_median - base_median;
+
+		/* a change only counts if it clears both the relative threshold and the run to run noise */
+		const double noise = sigma * MAD_SCALE * std::sqrt(base_mad * base_mad + new_mad * new_mad);
+		const double bound = std::max(threshold * base_median, noise);
+		const char* verdict = "ok";
+		if(delta > bound)
+		{
+			verdict = "REGRESSION";
+			num_regressions++;
+		}
+		else if(-delta > bound)
+		{
+			verdict = "improved";
+		}
+		printf("%-48s %12.3f %12.3f %+8.1f%% %12.3f  %s\n", entry.first.c_str(), base_median * 1e3, new_median * 1e3,
+		       base_median > 0? 100.0 * delta / base_median : 0.0, noise * 1e3, verdict);
+	}
+	for(const auto& entry : baseline)
+	{
+		if(current.find(entry.first) == current.end())
+		{
+			printf("%-48s %12.3f %12s %9s %12s  missing\n", entry.first.c_str(), Median(entry.second) * 1e3, "-", "-", "-");
+		}
+	}
+
+	if(num_regressions > 0)
+	{
+		printf("\n%zu regression(s) found.\n", num_regressions);
+		return EXIT_REGRESSION;
+	}
+	return EXIT_OK;
+}
@@ -0,0 +1,30 @@
+function json = runbench(output, repeats)
+%% RUNBENCH  Time the native hot paths of <strong>dxtmex</strong> on the assets in '../test'.
+%    RUNBENCH(OUTPUT) writes the JSON results to OUTPUT.
+%    RUNBENCH(OUTPUT, REPEATS) takes REPEATS samples of each benchmark (default 15).
+%
+%    Compare two runs with benchcompare, which builds from this folder:
+%       benchcompare baseline.json results.json [threshold] [sigma]
+%    It exits with a nonzero code if anything regressed beyond the noise.
+%    To refresh the baseline run RUNBENCH(fullfile('source', 'bench', 'baseline.json'))
+%    on the reference machine with a release build.
+
+	if(nargin < 2)
+		repeats = 15;
+	end
+
+	thisfolder = fileparts(which(mfilename));
+	test_path  = fullfile(thisfolder, '..', 'test');
+	assets = {
+		fullfile(test_path, 'tga', 'rgb32.tga'),...
+		fullfile(test_path, 'tga', 'TGA_24_uncompressed.tga'),...
+		fullfile(test_path, 'hdr', 'AtriumNight_oA9D.hdr'),...
+		fullfile(test_path, 'dds', 'DDS_a8b8g8r8.dds'),...
+		fullfile(test_path, 'dds', 'earth-cubemap.dds')
+		};
+
+	% dxtmex is private to the out folder
+	prev_folder = cd(fullfile(thisfolder, '..', '..', 'out', 'private'));
+	restore_folder = onCleanup(@() cd(prev_folder));
+	json = dxtmex('BENCHMARK', assets, 'Repeats', repeats, 'Output', output);
+end
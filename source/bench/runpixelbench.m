@@ -0,0 +1,16 @@
+function json = runpixelbench(output, varargin)
+%% RUNPIXELBENCH  Time channel extraction for every format <strong>dxtmex</strong> can extract.
+%    RUNPIXELBENCH(OUTPUT) writes the JSON results to OUTPUT and prints the
+%    benchmarks ranked by time per pixel, slowest first.
+%    RUNPIXELBENCH(OUTPUT, 'Width', W, 'Height', H, 'Repeats', N) sets the
+%    size of the random images (default 256x256) and the number of samples.
+%
+%    The results can be compared with benchcompare, just like RUNBENCH.
+
+	thisfolder = fileparts(which(mfilename));
+
+	% dxtmex is private to the out folder
+	prev_folder = cd(fullfile(thisfolder, '..', '..', 'out', 'private'));
+	restore_folder = onCleanup(@() cd(prev_folder));
+	json = dxtmex('BENCHMARK_PIXEL', 'Output', output, varargin{:});
+end
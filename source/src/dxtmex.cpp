@@ -4,33 +4,52 @@
 #include "DirectXTex.inl"
 #include "dxtmex_dxtimagearray.hpp"
 #include "dxtmex_flags.hpp"
+#include "dxtmex_progress.hpp"
+#include "dxtmex_jobs.hpp"
+#include "dxtmex_stats.hpp"
+#include "dxtmex_trace.hpp"
+#include "dxtmex_bench.hpp"
 
 using namespace DXTMEX;
 
 const char* MEXError::g_library_name = "dxtmex";
 
-/* The gateway function. */
-void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[])
+/* runs one directive, in starts after the directive */
+static void Dispatch(DXTImageArray::OPERATION op, int nlhs, mxArray* plhs[], int num_in, const mxArray** in)
 {
 	DXTImageArray dxtimage_array;
-	
-	if(nrhs < 1)
-	{
-		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "NotEnoughInputsError", "Not enough arguments. Please supply a directive.");
-	}
-	
-	if(!mxIsChar(prhs[0]))
-	{
-		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "InvalidDirectiveError", "The directive supplied must be of class 'char'.");
-	}
-	
-	const DXTImageArray::OPERATION op = DXTImageArray::GetOperation(prhs[0]);
-	
-	const int num_in              = nrhs-1;
-	const mxArray** in      = prhs+1;
-	
 	switch(op)
 	{
+		case DXTImageArray::OPERATION::STATS:
+		{
+			Stats::Export(nlhs, plhs);
+			return; // EARLY RETURN
+		}
+		case DXTImageArray::OPERATION::STATS_RESET:
+		{
+			Stats::Reset();
+			return; // EARLY RETURN
+		}
+		case DXTImageArray::OPERATION::TRACE_START:
+		{
+			Trace::Start(num_in, in);
+			return; // EARLY RETURN
+		}
+		case DXTImageArray::OPERATION::TRACE_STOP:
+		{
+			Trace::Stop(num_in, in);
+			return; // EARLY RETURN
+		}
+		case DXTImageArray::OPERATION::BENCHMARK:
+		{
+			Bench::Run(nlhs, plhs, num_in, in);
+			return; // EARLY RETURN
+		}
+		case DXTImageArray::OPERATION::BENCHMARK_PIXEL:
+		{
+			Bench::RunPixel(nlhs, plhs, num_in, in);
+			return; // EARLY RETURN
+		}
 		case DXTImageArray::OPERATION::READ_DDS:
 		{
 			DXTImageArray::ReadDDS(nlhs, plhs, num_in, in);
@@ -91,6 +110,36 @@ void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[])
 			DXTImageArray::WriteMatrixTGA(num_in, in);
 			return; // EARLY RETURN
 		}
+		case DXTImageArray::OPERATION::ASYNC_READ_DDS:
+		{
+			DXTImageArray::ReadAsync(DXTImage::IMAGE_TYPE::DDS, nlhs, plhs, num_in, in);
+			return; // EARLY RETURN
+		}
+		case DXTImageArray::OPERATION::ASYNC_READ_HDR:
+		{
+			DXTImageArray::ReadAsync(DXTImage::IMAGE_TYPE::HDR, nlhs, plhs, num_in, in);
+			return; // EARLY RETURN
+		}
+		case DXTImageArray::OPERATION::ASYNC_READ_TGA:
+		{
+			DXTImageArray::ReadAsync(DXTImage::IMAGE_TYPE::TGA, nlhs, plhs, num_in, in);
+			return; // EARLY RETURN
+		}
+		case DXTImageArray::OPERATION::POLL:
+		{
+			Jobs::Poll(nlhs, plhs, num_in, in);
+			return; // EARLY RETURN
+		}
+		case DXTImageArray::OPERATION::WAIT:
+		{
+			Jobs::Wait(nlhs, plhs, num_in, in);
+			return; // EARLY RETURN
+		}
+		case DXTImageArray::OPERATION::FETCH:
+		{
+			Jobs::Fetch(nlhs, plhs, num_in, in);
+			return; // EARLY RETURN
+		}
 		case DXTImageArray::OPERATION::WRITE_DDS:
 		case DXTImageArray::OPERATION::WRITE_HDR:
 		case DXTImageArray::OPERATION::WRITE_TGA:
@@ -104,12 +153,20 @@ void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[])
 		case DXTImageArray::OPERATION::PREMULTIPLY_ALPHA:
 		case DXTImageArray::OPERATION::COMPRESS:
 		case DXTImageArray::OPERATION::DECOMPRESS:
+		case DXTImageArray::OPERATION::TRANSCODE:
 		case DXTImageArray::OPERATION::COMPUTE_NORMAL_MAP:
 		case DXTImageArray::OPERATION::COPY_RECTANGLE:
+		case DXTImageArray::OPERATION::UPDATE_REGION:
 		case DXTImageArray::OPERATION::COMPUTE_MSE:
+		case DXTImageArray::OPERATION::COMPUTE_SSIM:
+		case DXTImageArray::OPERATION::COMPRESSION_REPORT:
 		case DXTImageArray::OPERATION::TO_IMAGE:
 		case DXTImageArray::OPERATION::TO_MATRIX:
+		case DXTImageArray::OPERATION::ASYNC_COMPRESS:
+		case DXTImageArray::OPERATION::ASYNC_DECOMPRESS:
+		case DXTImageArray::OPERATION::ASYNC_TRANSCODE:
 		{
+			Stats::Timer timer(Stats::PHASE::IMPORT);
 			dxtimage_array.Import(num_in, in);
 			break;
 		}
@@ -192,14 +249,19 @@ void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[])
 		}
 		case DXTImageArray::OPERATION::COMPRESS:
 		{
-			dxtimage_array.Compress(num_options, options);
-			break;
+			dxtimage_array.Compress(nlhs, plhs, num_options, options);
+			return; // EARLY RETURN
 		}
 		case DXTImageArray::OPERATION::DECOMPRESS:
 		{
 			dxtimage_array.Decompress(num_options, options);
 			break;
 		}
+		case DXTImageArray::OPERATION::TRANSCODE:
+		{
+			dxtimage_array.Transcode(num_options, options);
+			break;
+		}
 		case DXTImageArray::OPERATION::COMPUTE_NORMAL_MAP:
 		{
 			dxtimage_array.ComputeNormalMap(num_options, options);
@@ -212,10 +274,27 @@ void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[])
 			{
 				MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "NotEnoughArgumentsError", "Not enough arguments. Please supply a destination image.");
 			}
-			dxtimage_src.Import(num_options, options);
+			{
+				Stats::Timer timer(Stats::PHASE::IMPORT);
+				dxtimage_src.Import(num_options, options);
+			}
 			DXTImageArray::CopyRectangle(dxtimage_array, dxtimage_src, num_options-1, options+1);
 			break;
 		}
+		case DXTImageArray::OPERATION::UPDATE_REGION:
+		{
+			DXTImageArray dxtimage_src;
+			if(num_options < 1)
+			{
+				MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "NotEnoughArgumentsError", "Not enough arguments. Please supply an image with the new pixels.");
+			}
+			{
+				Stats::Timer timer(Stats::PHASE::IMPORT);
+				dxtimage_src.Import(num_options, options);
+			}
+			DXTImageArray::UpdateRegion(dxtimage_array, dxtimage_src, num_options-1, options+1);
+			break;
+		}
 		case DXTImageArray::OPERATION::COMPUTE_MSE:
 		{
 			DXTImageArray dxtimage_cmp;
@@ -223,8 +302,46 @@ void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[])
 			{
 				MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "NotEnoughArgumentsError", "Not enough arguments. Please supply a comparison image.");
 			}
-			dxtimage_cmp.Import(num_options, options);
-			DXTImageArray::ComputeMSE(dxtimage_array, dxtimage_cmp, nlhs, plhs, num_options, options);
+			{
+				Stats::Timer timer(Stats::PHASE::IMPORT);
+				dxtimage_cmp.Import(num_options, options);
+			}
+			DXTImageArray::ComputeMSE(dxtimage_array, dxtimage_cmp, nlhs, plhs, num_options-1, options+1);
+			return; // EARLY RETURN
+		}
+		case DXTImageArray::OPERATION::COMPUTE_SSIM:
+		{
+			DXTImageArray dxtimage_cmp;
+			if(num_options < 1)
+			{
+				MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "NotEnoughArgumentsError", "Not enough arguments. Please supply a comparison image.");
+			}
+			{
+				Stats::Timer timer(Stats::PHASE::IMPORT);
+				dxtimage_cmp.Import(num_options, options);
+			}
+			DXTImageArray::ComputeSSIM(dxtimage_array, dxtimage_cmp, nlhs, plhs, num_options-1, options+1);
+			return; // EARLY RETURN
+		}
+		case DXTImageArray::OPERATION::COMPRESSION_REPORT:
+		{
+			DXTImageArray dxtimage_cmp;
+			if(num_options < 1)
+			{
+				MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "NotEnoughArgumentsError", "Not enough arguments. Please supply the compressed image.");
+			}
+			{
+				Stats::Timer timer(Stats::PHASE::IMPORT);
+				dxtimage_cmp.Import(num_options, options);
+			}
+			DXTImageArray::CompressionReport(dxtimage_array, dxtimage_cmp, nlhs, plhs, num_options-1, options+1);
+			return; // EARLY RETURN
+		}
+		case DXTImageArray::OPERATION::ASYNC_COMPRESS:
+		case DXTImageArray::OPERATION::ASYNC_DECOMPRESS:
+		case DXTImageArray::OPERATION::ASYNC_TRANSCODE:
+		{
+			dxtimage_array.StartAsync(op, nlhs, plhs, num_options, options);
 			return; // EARLY RETURN
 		}
 		default:
@@ -236,4 +353,30 @@ void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[])
 	
 	dxtimage_array.ToExport(nlhs, plhs);
 	
-}
\ No newline at end of file
+}
+
+/* The gateway function. */
+void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[])
+{
+	MEXError::SetMainThread();
+	Progress::Reset();
+	
+	if(nrhs < 1)
+	{
+		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "NotEnoughInputsError", "Not enough arguments. Please supply a directive.");
+	}
+	
+	if(!mxIsChar(prhs[0]))
+	{
+		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "InvalidDirectiveError", "The directive supplied must be of class 'char'.");
+	}
+	
+	const DXTImageArray::OPERATION op = DXTImageArray::GetOperation(prhs[0]);
+	
+	Stats::Begin(op, nrhs-1, prhs+1);
+	{
+		Trace::Scope trace_scope(DXTImageArray::GetOperationName(op), "directive");
+		Dispatch(op, nlhs, plhs, nrhs-1, prhs+1);
+	}
+	Stats::End(nlhs, plhs);
+}
@@ -0,0 +1,452 @@
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "dxtmex_bench.hpp"
+#include "dxtmex_compress.hpp"
+#include "dxtmex_maps.hpp"
+#include "dxtmex_mexerror.hpp"
+#include "dxtmex_mexutils.hpp"
+#include "dxtmex_pixel.hpp"
+#include "dxtmex_progress.hpp"
+#include "dxtmex_simd.hpp"
+
+using namespace DXTMEX;
+
+namespace
+{
+	constexpr size_t   DEFAULT_REPEATS    = 15;
+	constexpr size_t   DEFAULT_PIXEL_SIZE = 256;
+	constexpr uint32_t PIXEL_SEED         = 5489u;
+
+	const DXGI_FORMAT EXTRACT_FORMATS[] =
+	{
+		DXGI_FORMAT_R8G8B8A8_UNORM,
+		DXGI_FORMAT_B8G8R8A8_UNORM,
+		DXGI_FORMAT_R10G10B10A2_UNORM,
+		DXGI_FORMAT_R16G16B16A16_FLOAT,
+		DXGI_FORMAT_R32G32B32A32_FLOAT,
+		DXGI_FORMAT_R11G11B10_FLOAT,
+		DXGI_FORMAT_R9G9B9E5_SHAREDEXP,
+		DXGI_FORMAT_R8_UNORM
+	};
+
+	const DXGI_FORMAT COMPRESS_FORMATS[] =
+	{
+		DXGI_FORMAT_BC1_UNORM,
+		DXGI_FORMAT_BC3_UNORM,
+		DXGI_FORMAT_BC7_UNORM
+	};
+
+	struct Result
+	{
+		std::string         name;
+		std::vector<double> samples; /* seconds */
+	};
+
+	/* one untimed warm-up, then repeats timed runs of func. cleanup runs after each sample, outside of the timing */
+	template <typename F, typename C>
+	void Time(std::vector<Result>& results, const std::string& name, size_t repeats, F&& func, C&& cleanup)
+	{
+		Result result = {name, {}};
+		func();
+		cleanup();
+		for(size_t k = 0; k < repeats; k++)
+		{
+			const auto start = std::chrono::steady_clock::now();
+			func();
+			result.samples.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+			cleanup();
+			Progress::CheckInterrupt();
+		}
+		results.push_back(std::move(result));
+	}
+
+	template <typename F>
+	void Time(std::vector<Result>& results, const std::string& name, size_t repeats, F&& func)
+	{
+		Time(results, name, repeats, func, [] {});
+	}
+
+	void CheckResult(const char* stage)
+	{
+		if(FAILED(hres))
+		{
+			MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_HRESULT, "BenchmarkError", "The %s benchmark failed.", stage);
+		}
+	}
+
+	std::string BaseName(const std::string& path)
+	{
+		const size_t pos = path.find_last_of("/\\");
+		return (pos == std::string::npos)? path : path.substr(pos + 1);
+	}
+
+	std::string Extension(const std::string& path)
+	{
+		const size_t pos = path.find_last_of('.');
+		std::string ext = (pos == std::string::npos)? "" : path.substr(pos + 1);
+		for(char& c : ext)
+		{
+			c = static_cast<char>(toupper(c));
+		}
+		return ext;
+	}
+
+	void RunAsset(std::vector<Result>& results, const mxArray* mx_filename, size_t repeats)
+	{
+		if(!mxIsChar(mx_filename))
+		{
+			MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "InputError", "Filenames must be of type 'char'.");
+		}
+		char* filename_str = mxArrayToString(mx_filename);
+		const std::string filename(filename_str);
+		mxFree(filename_str);
+		const std::string asset = BaseName(filename);
+		const std::string ext = Extension(filename);
+
+		DXTImageArray arr;
+		const mxArray* read_args[1] = {mx_filename};
+		auto read = [&]
+		{
+			arr = DXTImageArray();
+			if(ext == "DDS")
+			{
+				arr.ReadDDS(1, read_args);
+			}
+			else if(ext == "HDR")
+			{
+				arr.ReadHDR(1, read_args);
+			}
+			else if(ext == "TGA")
+			{
+				arr.ReadTGA(1, read_args);
+			}
+			else
+			{
+				MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "InvalidFileError", "Only DDS, HDR and TGA files can be benchmarked.");
+			}
+		};
+		Time(results, "read/" + asset, repeats, read);
+
+		/* marshalling across the MEX boundary */
+		mxArray* mx_exported = nullptr;
+		Time(results, "export/" + asset, repeats, [&] {arr.ToExport(1, &mx_exported);}, [&] {mxDestroyArray(mx_exported);});
+		arr.ToExport(1, &mx_exported);
+		const mxArray* import_args[1] = {mx_exported};
+		Time(results, "import/" + asset, repeats, [&] {DXTImageArray imported; imported.Import(1, import_args);});
+		mxDestroyArray(mx_exported);
+
+		/* everything past here works on an uncompressed copy of the first image */
+		DXTImage& dxtimage = arr.GetDXTImage(0);
+		const DirectX::Image* first = dxtimage.GetImage(0, 0, 0);
+		DirectX::ScratchImage decoded;
+		if(DirectX::IsCompressed(first->format))
+		{
+			hres = DirectX::Decompress(*first, DXGI_FORMAT_UNKNOWN, decoded);
+		}
+		else
+		{
+			hres = DirectX::Convert(*first, DXGI_FORMAT_R32G32B32A32_FLOAT, DirectX::TEX_FILTER_DEFAULT, DirectX::TEX_THRESHOLD_DEFAULT, decoded);
+		}
+		CheckResult("decode");
+		const DirectX::Image& source = *decoded.GetImage(0, 0, 0);
+
+		for(DXGI_FORMAT fmt : EXTRACT_FORMATS)
+		{
+			DirectX::ScratchImage converted;
+			hres = DirectX::Convert(source, fmt, DirectX::TEX_FILTER_DEFAULT, DirectX::TEX_THRESHOLD_DEFAULT, converted);
+			CheckResult("conversion");
+			mxArray* mx_out = nullptr;
+			Time(results, "extract/" + asset + "/" + g_format_map.FindStringFromID(fmt), repeats, [&]
+			{
+				DXGIPixel pixel(fmt, converted.GetImage(0, 0, 0));
+				pixel.ExtractAll(mx_out);
+			}, [&] {mxDestroyArray(mx_out);});
+		}
+
+		DirectX::ScratchImage rgba;
+		hres = DirectX::Convert(source, DXGI_FORMAT_R8G8B8A8_UNORM, DirectX::TEX_FILTER_DEFAULT, DirectX::TEX_THRESHOLD_DEFAULT, rgba);
+		CheckResult("conversion");
+		for(DXGI_FORMAT fmt : COMPRESS_FORMATS)
+		{
+			Time(results, "compress/" + asset + "/" + g_format_map.FindStringFromID(fmt), repeats, [&]
+			{
+				DirectX::ScratchImage compressed;
+				CompressionScheduler scheduler(fmt, DirectX::TEX_COMPRESS_DEFAULT, DirectX::TEX_THRESHOLD_DEFAULT);
+				scheduler.Add(rgba, compressed);
+				scheduler.Run();
+			});
+		}
+
+		Time(results, "resize/" + asset, repeats, [&]
+		{
+			DirectX::ScratchImage resized;
+			hres = DirectX::Resize(source, std::max<size_t>(source.width / 2, 1), std::max<size_t>(source.height / 2, 1), DirectX::TEX_FILTER_DEFAULT, resized);
+			CheckResult("resize");
+		});
+
+		Time(results, "mipmaps/" + asset, repeats, [&]
+		{
+			DirectX::ScratchImage mips;
+			hres = DirectX::GenerateMipMaps(source, DirectX::TEX_FILTER_DEFAULT, 0, mips);
+			CheckResult("mip generation");
+		});
+	}
+
+	std::string ToJSON(const std::vector<Result>& results, size_t repeats)
+	{
+		std::ostringstream out;
+		out.precision(9);
+		out << "{\n\"repeats\": " << repeats << ",\n\"threads\": " << std::thread::hardware_concurrency()
+		    << ",\n\"simd\": \"" << SIMD::GetLevelName(SIMD::GetLevel()) << "\",\n\"benchmarks\": [\n";
+		for(size_t i = 0; i < results.size(); i++)
+		{
+			out << "  {\"name\": \"" << results[i].name << "\", \"samples\": [";
+			for(size_t k = 0; k < results[i].samples.size(); k++)
+			{
+				out << (k == 0? "" : ", ") << results[i].samples[k];
+			}
+			out << "]}" << (i + 1 < results.size()? ",\n" : "\n");
+		}
+		out << "]\n}\n";
+		return out.str();
+	}
+
+	struct Options
+	{
+		size_t       repeats = DEFAULT_REPEATS;
+		size_t       width   = DEFAULT_PIXEL_SIZE;
+		size_t       height  = DEFAULT_PIXEL_SIZE;
+		std::wstring output;
+	};
+
+	size_t ParsePositiveScalar(const mxArray* mx_value, const char* name)
+	{
+		if(!mxIsNumeric(mx_value) || !mxIsScalar(mx_value) || mxGetScalar(mx_value) < 1)
+		{
+			MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "InvalidValueError", "%s must be a positive scalar.", name);
+		}
+		return static_cast<size_t>(mxGetScalar(mx_value));
+	}
+
+	/* key-value pairs starting at prhs[0]. the image size only applies to the pixel benchmarks */
+	void ParseOptions(int nrhs, const mxArray* prhs[], bool has_size, Options& options)
+	{
+		if((nrhs % 2) != 0)
+		{
+			MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "KeyValueError", "Invalid number of arguments. A key is likely missing a value.");
+		}
+
+		for(int j = 0; j < nrhs; j += 2)
+		{
+			if(!mxIsChar(prhs[j]))
+			{
+				MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "InvalidKeyError", "All keys must be class 'char'.");
+			}
+			MEXUtils::ToUpper(const_cast<mxArray*>(prhs[j]));
+			if(MEXUtils::CompareMEXString(prhs[j], "REPEATS"))
+			{
+				options.repeats = ParsePositiveScalar(prhs[j + 1], "Repeats");
+			}
+			else if(MEXUtils::CompareMEXString(prhs[j], "OUTPUT"))
+			{
+				DXTImageArray::ImportFilename(prhs[j + 1], options.output);
+			}
+			else if(has_size && MEXUtils::CompareMEXString(prhs[j], "WIDTH"))
+			{
+				options.width = ParsePositiveScalar(prhs[j + 1], "Width");
+			}
+			else if(has_size && MEXUtils::CompareMEXString(prhs[j], "HEIGHT"))
+			{
+				options.height = ParsePositiveScalar(prhs[j + 1], "Height");
+			}
+			else if(has_size)
+			{
+				MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "InvalidKeyError", "Unrecognized key. Valid keys are 'Width', 'Height', 'Repeats' and 'Output'.");
+			}
+			else
+			{
+				MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "InvalidKeyError", "Unrecognized key. Valid keys are 'Repeats' and 'Output'.");
+			}
+		}
+	}
+
+	void ExportResults(const std::vector<Result>& results, const Options& options, mxArray* plhs[])
+	{
+		const std::string json = ToJSON(results, options.repeats);
+		if(!options.output.empty())
+		{
+			std::ofstream out;
+			out.open(options.output, std::ios::out | std::ios::trunc);
+			out << json;
+			out.close();
+			if(out.fail())
+			{
+				MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER | MEU_SEVERITY_SYSTEM, "FileWriteError", "There was an error while writing the benchmark results.");
+			}
+		}
+		plhs[0] = mxCreateString(json.c_str());
+	}
+
+	double Median(std::vector<double> samples)
+	{
+		std::sort(samples.begin(), samples.end());
+		const size_t mid = samples.size() / 2;
+		return (samples.size() % 2 == 1)? samples[mid] : (samples[mid - 1] + samples[mid]) / 2.0;
+	}
+
+	/* the formats which DXGIPixel::SetChannels has a layout for. R1_UNORM is bit packed and never extracted per pixel */
+	bool IsExtractable(DXGI_FORMAT fmt)
+	{
+		return DirectX::IsValid(fmt) && !DirectX::IsCompressed(fmt) && !DirectX::IsPacked(fmt) && !DirectX::IsVideo(fmt)
+		       && !DirectX::IsPlanar(fmt) && !DirectX::IsPalettized(fmt) && fmt != DXGI_FORMAT_R1_UNORM;
+	}
+
+	struct OutputClass
+	{
+		mxClassID   id;
+		const char* name;
+	};
+
+	const OutputClass OUTPUT_CLASSES[] =
+	{
+		{mxINT8_CLASS,    "int8"},
+		{mxINT16_CLASS,   "int16"},
+		{mxINT32_CLASS,   "int32"},
+		{mxUINT8_CLASS,   "uint8"},
+		{mxUINT16_CLASS,  "uint16"},
+		{mxUINT32_CLASS,  "uint32"},
+		{mxSINGLE_CLASS,  "single"},
+		{mxDOUBLE_CLASS,  "double"},
+		{mxLOGICAL_CLASS, "logical"}
+	};
+
+	/* every extraction path of one format on random pixel data */
+	void RunFormat(std::vector<Result>& results, DXGI_FORMAT fmt, const Options& options, std::mt19937& rng)
+	{
+		DirectX::ScratchImage scratch;
+		hres = scratch.Initialize2D(fmt, options.width, options.height, 1, 1);
+		CheckResult("allocation");
+		std::uniform_int_distribution<int> byte_dist(0, 255);
+		for(size_t i = 0; i < scratch.GetPixelsSize(); i++)
+		{
+			scratch.GetPixels()[i] = static_cast<uint8_t>(byte_dist(rng));
+		}
+
+		const DirectX::Image* image = scratch.GetImage(0, 0, 0);
+		const std::string prefix = "pixel/" + g_format_map.FindStringFromID(fmt) + "/";
+		DXGIPixel pixel(fmt, image);
+		mxArray* mx_out = nullptr;
+		mxArray* mx_alpha = nullptr;
+		auto destroy = [&] {mxDestroyArray(mx_out);};
+
+		if(!pixel.HasUniformDatatype())
+		{
+			/* these cannot go to a single matrix, so time the channels one by one */
+			for(size_t ch = 0; ch < pixel.GetNumChannels(); ch++)
+			{
+				Time(results, prefix + "channel" + std::to_string(ch), options.repeats, [&] {pixel.ExtractChannels(ch, 0, mx_out);}, destroy);
+			}
+			return;
+		}
+
+		Time(results, prefix + "all", options.repeats, [&] {pixel.ExtractAll(mx_out);}, destroy);
+		Time(results, prefix + "rgba", options.repeats, [&] {pixel.ExtractRGBA(mx_out);}, destroy);
+
+		/* A8_UNORM has no color channels to split off */
+		if(!DirectX::HasAlpha(fmt) || pixel.GetNumChannels() > 1)
+		{
+			Time(results, prefix + "rgb", options.repeats, [&] {pixel.ExtractRGB(mx_out);}, destroy);
+			Time(results, prefix + "rgb+a", options.repeats, [&] {pixel.ExtractRGBA(mx_out, mx_alpha);}, [&]
+			{
+				mxDestroyArray(mx_out);
+				mxDestroyArray(mx_alpha);
+			});
+		}
+
+		size_t ch_idx[MAX_CHANNELS];
+		for(size_t ch = 0; ch < pixel.GetNumChannels(); ch++)
+		{
+			ch_idx[ch] = ch;
+		}
+		for(const OutputClass& out_class : OUTPUT_CLASSES)
+		{
+			Time(results, prefix + "all/" + out_class.name, options.repeats, [&]
+			{
+				pixel.ExtractChannels(ch_idx, ch_idx, pixel.GetNumChannels(), mx_out, out_class.id);
+			}, destroy);
+		}
+	}
+
+	/* slowest first, normalized by the pixel count so the sizes do not matter */
+	void PrintRanking(const std::vector<Result>& results, size_t num_pixels)
+	{
+		std::vector<std::pair<double, const std::string*>> ranked;
+		for(const Result& result : results)
+		{
+			ranked.emplace_back(Median(result.samples) * 1e9 / num_pixels, &result.name);
+		}
+		std::sort(ranked.begin(), ranked.end(), [](const std::pair<double, const std::string*>& a, const std::pair<double, const std::string*>& b)
+		{
+			return a.first > b.first;
+		});
+
+		mexPrintf("%5s  %-64s %12s\n", "rank", "benchmark", "ns/pixel");
+		for(size_t i = 0; i < ranked.size(); i++)
+		{
+			mexPrintf("%5zu  %-64s %12.3f\n", i + 1, ranked[i].second->c_str(), ranked[i].first);
+		}
+	}
+}
+
+void Bench::Run(int, mxArray* plhs[], int nrhs, const mxArray* prhs[])
+{
+	size_t i;
+	Options options;
+	if(nrhs < 1)
+	{
+		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "NotEnoughInputsError", "Not enough arguments. Please supply a file name.");
+	}
+	ParseOptions(nrhs - 1, prhs + 1, false, options);
+
+	std::vector<Result> results;
+	if(mxIsCell(prhs[0]))
+	{
+		for(i = 0; i < mxGetNumberOfElements(prhs[0]); i++)
+		{
+			RunAsset(results, mxGetCell(prhs[0], i), options.repeats);
+		}
+	}
+	else
+	{
+		RunAsset(results, prhs[0], options.repeats);
+	}
+	ExportResults(results, options, plhs);
+}
+
+void Bench::RunPixel(int, mxArray* plhs[], int nrhs, const mxArray* prhs[])
+{
+	Options options;
+	ParseOptions(nrhs, prhs, true, options);
+
+	/* fixed seed so every run extracts the same data */
+	std::mt19937 rng(PIXEL_SEED);
+	std::vector<Result> results;
+	for(int f = DXGI_FORMAT_UNKNOWN + 1; f <= DXGI_FORMAT_B4G4R4A4_UNORM; f++)
+	{
+		const auto fmt = static_cast<DXGI_FORMAT>(f);
+		if(IsExtractable(fmt))
+		{
+			RunFormat(results, fmt, options, rng);
+		}
+	}
+	PrintRanking(results, options.width * options.height);
+	ExportResults(results, options, plhs);
+}
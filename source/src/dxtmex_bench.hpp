@@ -0,0 +1,21 @@
+#pragma once
+
+#include "mex.h"
+#include "dxtmex_dxtimagearray.hpp"
+
+namespace DXTMEX
+{
+	/* native timings of the hot paths, compared between runs by source/bench/benchcompare */
+	namespace Bench
+	{
+		/* BENCHMARK(filenames, 'Repeats', n, 'Output', path) reads each DDS, HDR or TGA file and times reading, Import,
+		 * ToExport, channel extraction per format, compression, resizing and mip generation on its first image.
+		 * returns the JSON result and also writes it to path if one is given. */
+		void Run(MEXF_SIG);
+
+		/* BENCHMARK_PIXEL('Width', w, 'Height', h, 'Repeats', n, 'Output', path) fills a random image for every format
+		 * DXGIPixel supports and times ExtractAll, ExtractRGB, ExtractRGBA and extraction to each output class.
+		 * prints the results ranked by time per pixel and returns them in the same JSON layout as BENCHMARK. */
+		void RunPixel(MEXF_SIG);
+	}
+}
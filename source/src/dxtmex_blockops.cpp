@@ -0,0 +1,622 @@
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "dxtmex_blockops.hpp"
+#include "dxtmex_mexerror.hpp"
+#include "dxtmex_parallel.hpp"
+
+using namespace DXTMEX;
+
+namespace
+{
+	/* new pixel p of a block takes the selector of old pixel perm[p], pixels are in row-major order */
+	using Permutation = int[16];
+
+	struct BlockIndex
+	{
+		size_t image;
+		size_t bx;
+		size_t by;
+	};
+
+	/* a pair of equally sized endpoint fields which trade places when a subset is inverted */
+	struct EndpointPair
+	{
+		size_t first;
+		size_t second;
+		size_t bits;
+	};
+
+	uint32_t GetBits(const uint8_t* block, size_t pos, size_t num_bits)
+	{
+		uint32_t value = 0;
+		for(size_t i = 0; i < num_bits; i++, pos++)
+		{
+			value |= static_cast<uint32_t>((block[pos >> 3u] >> (pos & 7u)) & 1u) << i;
+		}
+		return value;
+	}
+
+	void SetBits(uint8_t* block, size_t pos, size_t num_bits, uint32_t value)
+	{
+		for(size_t i = 0; i < num_bits; i++, pos++)
+		{
+			const uint8_t mask = static_cast<uint8_t>(1u << (pos & 7u));
+			if(value & (1u << i))
+			{
+				block[pos >> 3u] |= mask;
+			}
+			else
+			{
+				block[pos >> 3u] &= static_cast<uint8_t>(~mask);
+			}
+		}
+	}
+
+	/* fixed width selectors, as in BC1 through BC5 */
+	void PermuteSelectors(uint8_t* block, size_t offset, size_t bits, const Permutation& perm)
+	{
+		uint32_t old_sel[16];
+		for(size_t i = 0; i < 16; i++)
+		{
+			old_sel[i] = GetBits(block, offset + i * bits, bits);
+		}
+		for(size_t i = 0; i < 16; i++)
+		{
+			SetBits(block, offset + i * bits, bits, old_sel[perm[i]]);
+		}
+	}
+
+	/* BC7 index sets drop the top bit of the anchor (pixel 0), so if the new anchor had it set the subset is inverted */
+	void PermuteAnchoredIndices(uint8_t* block, size_t offset, size_t bits, const Permutation& perm, const EndpointPair* pairs, size_t num_pairs)
+	{
+		uint32_t old_idx[16], new_idx[16];
+		old_idx[0] = GetBits(block, offset, bits - 1);
+		for(size_t i = 1; i < 16; i++)
+		{
+			old_idx[i] = GetBits(block, offset + (bits - 1) + (i - 1) * bits, bits);
+		}
+		for(size_t i = 0; i < 16; i++)
+		{
+			new_idx[i] = old_idx[perm[i]];
+		}
+
+		const uint32_t max_idx = (1u << bits) - 1;
+		if(new_idx[0] >> (bits - 1))
+		{
+			for(size_t i = 0; i < num_pairs; i++)
+			{
+				const uint32_t first = GetBits(block, pairs[i].first, pairs[i].bits);
+				SetBits(block, pairs[i].first, pairs[i].bits, GetBits(block, pairs[i].second, pairs[i].bits));
+				SetBits(block, pairs[i].second, pairs[i].bits, first);
+			}
+			for(size_t i = 0; i < 16; i++)
+			{
+				new_idx[i] = max_idx - new_idx[i];
+			}
+		}
+
+		SetBits(block, offset, bits - 1, new_idx[0]);
+		for(size_t i = 1; i < 16; i++)
+		{
+			SetBits(block, offset + (bits - 1) + (i - 1) * bits, bits, new_idx[i]);
+		}
+	}
+
+	/* only the single subset modes can be flipped, the partition tables are not symmetric */
+	bool PermuteBC7(uint8_t* block, const Permutation& perm)
+	{
+		int mode = 0;
+		while(mode < 8 && !(block[0] & (1u << mode)))
+		{
+			mode++;
+		}
+
+		switch(mode)
+		{
+			case 4:
+			{
+				static const EndpointPair color[] = {{8, 13, 5}, {18, 23, 5}, {28, 33, 5}};
+				static const EndpointPair alpha[] = {{38, 44, 6}};
+				const bool is_swapped = GetBits(block, 7, 1) != 0;
+				PermuteAnchoredIndices(block, 50, 2, perm, is_swapped? alpha : color, is_swapped? 1 : 3);
+				PermuteAnchoredIndices(block, 81, 3, perm, is_swapped? color : alpha, is_swapped? 3 : 1);
+				return true;
+			}
+			case 5:
+			{
+				static const EndpointPair color[] = {{8, 15, 7}, {22, 29, 7}, {36, 43, 7}};
+				static const EndpointPair alpha[] = {{50, 58, 8}};
+				PermuteAnchoredIndices(block, 66, 2, perm, color, 3);
+				PermuteAnchoredIndices(block, 97, 2, perm, alpha, 1);
+				return true;
+			}
+			case 6:
+			{
+				static const EndpointPair rgbap[] = {{7, 14, 7}, {21, 28, 7}, {35, 42, 7}, {49, 56, 7}, {63, 64, 1}};
+				PermuteAnchoredIndices(block, 65, 4, perm, rgbap, 5);
+				return true;
+			}
+			default:
+			{
+				return false;
+			}
+		}
+	}
+
+	bool PermuteBlock(DXGI_FORMAT fmt, uint8_t* block, const Permutation& perm)
+	{
+		switch(fmt)
+		{
+			case DXGI_FORMAT_BC1_TYPELESS:
+			case DXGI_FORMAT_BC1_UNORM:
+			case DXGI_FORMAT_BC1_UNORM_SRGB:
+			{
+				PermuteSelectors(block, 32, 2, perm);
+				return true;
+			}
+			case DXGI_FORMAT_BC2_TYPELESS:
+			case DXGI_FORMAT_BC2_UNORM:
+			case DXGI_FORMAT_BC2_UNORM_SRGB:
+			{
+				PermuteSelectors(block, 0, 4, perm);
+				PermuteSelectors(block + 8, 32, 2, perm);
+				return true;
+			}
+			case DXGI_FORMAT_BC3_TYPELESS:
+			case DXGI_FORMAT_BC3_UNORM:
+			case DXGI_FORMAT_BC3_UNORM_SRGB:
+			{
+				PermuteSelectors(block, 16, 3, perm);
+				PermuteSelectors(block + 8, 32, 2, perm);
+				return true;
+			}
+			case DXGI_FORMAT_BC4_TYPELESS:
+			case DXGI_FORMAT_BC4_UNORM:
+			case DXGI_FORMAT_BC4_SNORM:
+			{
+				PermuteSelectors(block, 16, 3, perm);
+				return true;
+			}
+			case DXGI_FORMAT_BC5_TYPELESS:
+			case DXGI_FORMAT_BC5_UNORM:
+			case DXGI_FORMAT_BC5_SNORM:
+			{
+				PermuteSelectors(block, 16, 3, perm);
+				PermuteSelectors(block + 8, 16, 3, perm);
+				return true;
+			}
+			case DXGI_FORMAT_BC7_TYPELESS:
+			case DXGI_FORMAT_BC7_UNORM:
+			case DXGI_FORMAT_BC7_UNORM_SRGB:
+			{
+				return PermuteBC7(block, perm);
+			}
+			default:
+			{
+				return false;
+			}
+		}
+	}
+
+	/* grows a rectangle outwards to whole blocks, clamped to the image */
+	DirectX::Rect AlignToBlocks(size_t x0, size_t y0, size_t x1, size_t y1, size_t width, size_t height)
+	{
+		x0 &= ~size_t(3);
+		y0 &= ~size_t(3);
+		x1 = std::min((x1 + 3) & ~size_t(3), width);
+		y1 = std::min((y1 + 3) & ~size_t(3), height);
+		return DirectX::Rect(x0, y0, x1 - x0, y1 - y0);
+	}
+	
+	/* a flipped axis must be whole blocks, or a single block where the padding stays put */
+	bool IsFlippable(size_t extent)
+	{
+		return extent < 4 || extent % 4 == 0;
+	}
+}
+
+bool BlockOps::FlipRotate(const DirectX::ScratchImage& src, DWORD fr_flags, DirectX::ScratchImage& dst)
+{
+	bool flip_h, flip_v;
+	switch(fr_flags)
+	{
+		case DirectX::TEX_FR_ROTATE0:         flip_h = false; flip_v = false; break;
+		case DirectX::TEX_FR_ROTATE180:       flip_h = true;  flip_v = true;  break;
+		case DirectX::TEX_FR_FLIP_HORIZONTAL: flip_h = true;  flip_v = false; break;
+		case DirectX::TEX_FR_FLIP_VERTICAL:   flip_h = false; flip_v = true;  break;
+		default:                              return false;
+	}
+
+	const DirectX::TexMetadata& metadata = src.GetMetadata();
+	if(!DirectX::IsCompressed(metadata.format) || metadata.format == DXGI_FORMAT_BC6H_TYPELESS || metadata.format == DXGI_FORMAT_BC6H_UF16 || metadata.format == DXGI_FORMAT_BC6H_SF16)
+	{
+		return false;
+	}
+
+	for(size_t i = 0; i < src.GetImageCount(); i++)
+	{
+		const DirectX::Image& img = src.GetImages()[i];
+		if((flip_h && !IsFlippable(img.width)) || (flip_v && !IsFlippable(img.height)))
+		{
+			return false;
+		}
+	}
+
+	DirectX::ScratchImage out;
+	hres = out.Initialize(metadata);
+	if(FAILED(hres))
+	{
+		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_HRESULT, "InitializationError", "There was an error while initializing the flipped image.");
+	}
+
+	const size_t block_size = DirectX::BitsPerPixel(metadata.format) * 2;
+	
+	/* destination blocks in a mode which cannot be permuted */
+	std::vector<BlockIndex> unpermuted;
+	for(size_t i = 0; i < src.GetImageCount(); i++)
+	{
+		const DirectX::Image& src_img = src.GetImages()[i];
+		const DirectX::Image& dst_img = out.GetImages()[i];
+		const size_t blocks_wide = (src_img.width + 3) / 4;
+		const size_t blocks_high = (src_img.height + 3) / 4;
+
+		/* only the pixels inside the image are mirrored, padding of a lone partial block stays where it is */
+		const size_t valid_w = std::min<size_t>(src_img.width, 4);
+		const size_t valid_h = std::min<size_t>(src_img.height, 4);
+		Permutation perm;
+		for(size_t r = 0; r < 4; r++)
+		{
+			for(size_t c = 0; c < 4; c++)
+			{
+				const size_t src_r = (flip_v && r < valid_h)? valid_h - 1 - r : r;
+				const size_t src_c = (flip_h && c < valid_w)? valid_w - 1 - c : c;
+				perm[r * 4 + c] = static_cast<int>(src_r * 4 + src_c);
+			}
+		}
+
+		std::vector<std::vector<size_t>> unpermuted_rows(blocks_high);
+		Parallel::For(blocks_high, [&](size_t by)
+		{
+			const uint8_t* src_row = src_img.pixels + (flip_v? blocks_high - 1 - by : by) * src_img.rowPitch;
+			uint8_t* dst_row = dst_img.pixels + by * dst_img.rowPitch;
+			for(size_t bx = 0; bx < blocks_wide; bx++)
+			{
+				uint8_t* dst_block = dst_row + bx * block_size;
+				memcpy(dst_block, src_row + (flip_h? blocks_wide - 1 - bx : bx) * block_size, block_size);
+				if(!PermuteBlock(metadata.format, dst_block, perm))
+				{
+					unpermuted_rows[by].push_back(bx);
+				}
+			}
+		});
+		for(size_t by = 0; by < blocks_high; by++)
+		{
+			for(size_t bx : unpermuted_rows[by])
+			{
+				unpermuted.push_back({i, bx, by});
+			}
+		}
+	}
+	
+	/* the rest are decoded, flipped and re-encoded one block at a time like the border of CopyRectangle */
+	std::atomic<bool> is_failed(false);
+	Parallel::For(unpermuted.size(), [&](size_t k)
+	{
+		const DirectX::Image& src_img = src.GetImages()[unpermuted[k].image];
+		const DirectX::Image& dst_img = out.GetImages()[unpermuted[k].image];
+		const size_t blocks_wide = (src_img.width + 3) / 4;
+		const size_t blocks_high = (src_img.height + 3) / 4;
+		const size_t bx = unpermuted[k].bx;
+		const size_t by = unpermuted[k].by;
+		const size_t src_bx = flip_h? blocks_wide - 1 - bx : bx;
+		const size_t src_by = flip_v? blocks_high - 1 - by : by;
+		
+		DirectX::Image block_view = src_img;
+		block_view.width  = std::min<size_t>(4, src_img.width - src_bx * 4);
+		block_view.height = std::min<size_t>(4, src_img.height - src_by * 4);
+		block_view.rowPitch = block_size;
+		block_view.slicePitch = block_size;
+		block_view.pixels = src_img.pixels + src_by * src_img.rowPitch + src_bx * block_size;
+		
+		DirectX::ScratchImage block_decoded, block_flipped, block_encoded;
+		HRESULT block_ret = DirectX::Decompress(block_view, DXGI_FORMAT_UNKNOWN, block_decoded);
+		if(SUCCEEDED(block_ret))
+		{
+			block_ret = DirectX::FlipRotate(*block_decoded.GetImage(0, 0, 0), fr_flags, block_flipped);
+		}
+		if(SUCCEEDED(block_ret))
+		{
+			block_ret = DirectX::Compress(*block_flipped.GetImage(0, 0, 0), metadata.format, DirectX::TEX_COMPRESS_DEFAULT, DirectX::TEX_THRESHOLD_DEFAULT, block_encoded);
+		}
+		if(SUCCEEDED(block_ret))
+		{
+			memcpy(dst_img.pixels + by * dst_img.rowPitch + bx * block_size, block_encoded.GetPixels(), block_size);
+		}
+		else
+		{
+			is_failed = true;
+		}
+	});
+	
+	if(is_failed)
+	{
+		return false;
+	}
+	dst = std::move(out);
+	return true;
+}
+
+HRESULT BlockOps::CopyRectangle(const DirectX::Image& src, const DirectX::Rect& rect, const DirectX::Image& dst, size_t x_offset, size_t y_offset)
+{
+	if(src.format != dst.format || !DirectX::IsCompressed(src.format))
+	{
+		return E_INVALIDARG;
+	}
+	
+	if(rect.x + rect.w > src.width || rect.y + rect.h > src.height || x_offset + rect.w > dst.width || y_offset + rect.h > dst.height)
+	{
+		return E_INVALIDARG;
+	}
+	
+	if(rect.w == 0 || rect.h == 0)
+	{
+		return S_OK;
+	}
+	
+	const size_t block_size = DirectX::BitsPerPixel(src.format) * 2;
+	const bool is_aligned = (rect.x % 4 == x_offset % 4) && (rect.y % 4 == y_offset % 4);
+	const size_t x_end = x_offset + rect.w;
+	const size_t y_end = y_offset + rect.h;
+	
+	/* (x, y) of destination blocks which have to be re-encoded */
+	std::vector<std::pair<size_t, size_t>> border;
+	for(size_t y = y_offset & ~size_t(3); y < y_end; y += 4)
+	{
+		const bool covers_rows = is_aligned && y >= y_offset && std::min(y + 4, dst.height) <= y_end;
+		for(size_t x = x_offset & ~size_t(3); x < x_end; x += 4)
+		{
+			if(covers_rows && x >= x_offset && std::min(x + 4, dst.width) <= x_end)
+			{
+				const size_t src_x = x - x_offset + rect.x;
+				const size_t src_y = y - y_offset + rect.y;
+				memcpy(dst.pixels + (y / 4) * dst.rowPitch + (x / 4) * block_size, src.pixels + (src_y / 4) * src.rowPitch + (src_x / 4) * block_size, block_size);
+			}
+			else
+			{
+				border.emplace_back(x, y);
+			}
+		}
+	}
+	
+	if(border.empty())
+	{
+		return S_OK;
+	}
+	
+	/* decode the source blocks under the rectangle once, every border block takes its pixels from here */
+	const size_t src_x0 = rect.x & ~size_t(3);
+	const size_t src_y0 = rect.y & ~size_t(3);
+	DirectX::Image src_view = src;
+	src_view.width  = rect.x + rect.w - src_x0;
+	src_view.height = rect.y + rect.h - src_y0;
+	src_view.slicePitch = src.rowPitch * ((src_view.height + 3) / 4);
+	src_view.pixels = src.pixels + (src_y0 / 4) * src.rowPitch + (src_x0 / 4) * block_size;
+	
+	DirectX::ScratchImage src_decoded;
+	HRESULT ret = DirectX::Decompress(src_view, DXGI_FORMAT_UNKNOWN, src_decoded);
+	if(FAILED(ret))
+	{
+		return ret;
+	}
+	const DirectX::Image& src_pixels = *src_decoded.GetImage(0, 0, 0);
+	const size_t pixel_size = DirectX::BitsPerPixel(src_pixels.format) / 8;
+	
+	std::atomic<HRESULT> status(S_OK);
+	Parallel::For(border.size(), [&](size_t k)
+	{
+		const size_t x = border[k].first;
+		const size_t y = border[k].second;
+		
+		DirectX::Image block_view = dst;
+		block_view.width  = std::min<size_t>(4, dst.width - x);
+		block_view.height = std::min<size_t>(4, dst.height - y);
+		block_view.rowPitch = block_size;
+		block_view.slicePitch = block_size;
+		block_view.pixels = dst.pixels + (y / 4) * dst.rowPitch + (x / 4) * block_size;
+		
+		DirectX::ScratchImage block_decoded, block_encoded;
+		HRESULT block_ret = DirectX::Decompress(block_view, src_pixels.format, block_decoded);
+		if(SUCCEEDED(block_ret))
+		{
+			const DirectX::Image& block_pixels = *block_decoded.GetImage(0, 0, 0);
+			for(size_t r = std::max(y, y_offset); r < std::min(y + block_view.height, y_end); r++)
+			{
+				const size_t c0 = std::max(x, x_offset);
+				const size_t c1 = std::min(x + block_view.width, x_end);
+				memcpy(block_pixels.pixels + (r - y) * block_pixels.rowPitch + (c0 - x) * pixel_size,
+				       src_pixels.pixels + (r - y_offset + rect.y - src_y0) * src_pixels.rowPitch + (c0 - x_offset + rect.x - src_x0) * pixel_size,
+				       (c1 - c0) * pixel_size);
+			}
+			block_ret = DirectX::Compress(block_pixels, dst.format, DirectX::TEX_COMPRESS_DEFAULT, DirectX::TEX_THRESHOLD_DEFAULT, block_encoded);
+		}
+		if(SUCCEEDED(block_ret))
+		{
+			memcpy(block_view.pixels, block_encoded.GetPixels(), block_size);
+		}
+		else
+		{
+			HRESULT expected = S_OK;
+			status.compare_exchange_strong(expected, block_ret);
+		}
+	});
+	return status;
+}
+
+HRESULT BlockOps::DecodeRegion(const DirectX::Image& img, const DirectX::Rect& rect, DirectX::ScratchImage& out)
+{
+	if(DirectX::IsCompressed(img.format))
+	{
+		const size_t block_size = DirectX::BitsPerPixel(img.format) * 2;
+		DirectX::Image view = img;
+		view.width  = rect.w;
+		view.height = rect.h;
+		view.slicePitch = img.rowPitch * ((rect.h + 3) / 4);
+		view.pixels = img.pixels + (rect.y / 4) * img.rowPitch + (rect.x / 4) * block_size;
+		return DirectX::Decompress(view, DXGI_FORMAT_UNKNOWN, out);
+	}
+	
+	const size_t bits_per_pixel = DirectX::BitsPerPixel(img.format);
+	if(DirectX::IsPlanar(img.format) || DirectX::IsPalettized(img.format) || bits_per_pixel % 8 != 0)
+	{
+		return E_INVALIDARG;
+	}
+	
+	HRESULT ret = out.Initialize2D(img.format, rect.w, rect.h, 1, 1);
+	if(FAILED(ret))
+	{
+		return ret;
+	}
+	const DirectX::Image& out_img = *out.GetImage(0, 0, 0);
+	for(size_t r = 0; r < rect.h; r++)
+	{
+		memcpy(out_img.pixels + r * out_img.rowPitch, img.pixels + (rect.y + r) * img.rowPitch + rect.x * (bits_per_pixel / 8), rect.w * (bits_per_pixel / 8));
+	}
+	return S_OK;
+}
+
+HRESULT BlockOps::EncodeRegion(const DirectX::Image& pixels, const DirectX::Image& dst, size_t x_offset, size_t y_offset)
+{
+	DirectX::ScratchImage encoded;
+	HRESULT ret;
+	if(DirectX::IsCompressed(dst.format))
+	{
+		ret = DirectX::Compress(pixels, dst.format, DirectX::TEX_COMPRESS_DEFAULT, DirectX::TEX_THRESHOLD_DEFAULT, encoded);
+	}
+	else if(pixels.format != dst.format)
+	{
+		ret = DirectX::Convert(pixels, dst.format, DirectX::TEX_FILTER_DEFAULT, DirectX::TEX_THRESHOLD_DEFAULT, encoded);
+	}
+	else
+	{
+		ret = encoded.InitializeFromImage(pixels);
+	}
+	if(FAILED(ret))
+	{
+		return ret;
+	}
+	
+	/* compressed rows are rows of blocks, so the same copy serves both */
+	const DirectX::Image& enc_img = *encoded.GetImage(0, 0, 0);
+	const bool is_compressed = DirectX::IsCompressed(dst.format);
+	const size_t unit = is_compressed? 4 : 1;
+	const size_t unit_size = is_compressed? DirectX::BitsPerPixel(dst.format) * 2 : DirectX::BitsPerPixel(dst.format) / 8;
+	const size_t num_rows = (enc_img.height + unit - 1) / unit;
+	const size_t row_size = ((enc_img.width + unit - 1) / unit) * unit_size;
+	for(size_t r = 0; r < num_rows; r++)
+	{
+		memcpy(dst.pixels + (y_offset / unit + r) * dst.rowPitch + (x_offset / unit) * unit_size, enc_img.pixels + r * enc_img.rowPitch, row_size);
+	}
+	return S_OK;
+}
+
+HRESULT BlockOps::UpdateRegion(const DirectX::ScratchImage& dst, size_t item, const DirectX::Image& pixels, size_t x_offset, size_t y_offset, DirectX::TEX_FILTER_FLAGS filter_flags)
+{
+	const DirectX::TexMetadata& metadata = dst.GetMetadata();
+	if(metadata.dimension == DirectX::TEX_DIMENSION_TEXTURE3D || item >= metadata.arraySize)
+	{
+		return E_INVALIDARG;
+	}
+	
+	if(x_offset + pixels.width > metadata.width || y_offset + pixels.height > metadata.height)
+	{
+		return E_INVALIDARG;
+	}
+	
+	/* target is the rectangle of new pixels at the current level, work holds its whole blocks before they are encoded */
+	size_t tx0 = x_offset, ty0 = y_offset, tx1 = x_offset + pixels.width, ty1 = y_offset + pixels.height;
+	DirectX::ScratchImage prev_work;
+	DirectX::Rect prev_rect;
+	for(size_t level = 0; level < metadata.mipLevels; level++)
+	{
+		const DirectX::Image& img = *dst.GetImage(level, item, 0);
+		if(level > 0)
+		{
+			tx0 /= 2;
+			ty0 /= 2;
+			tx1 = std::min((tx1 + 1) / 2, img.width);
+			ty1 = std::min((ty1 + 1) / 2, img.height);
+		}
+		
+		const DirectX::Rect aligned = AlignToBlocks(tx0, ty0, tx1, ty1, img.width, img.height);
+		DirectX::ScratchImage work;
+		HRESULT ret = DecodeRegion(img, aligned, work);
+		if(FAILED(ret))
+		{
+			return ret;
+		}
+		const DirectX::Image& work_img = *work.GetImage(0, 0, 0);
+		
+		/* the new pixels of this level, and where the target starts inside them */
+		DirectX::ScratchImage fresh;
+		const DirectX::Image* fresh_img = &pixels;
+		size_t fx = 0, fy = 0;
+		if(level == 0)
+		{
+			if(pixels.format != work_img.format)
+			{
+				ret = DirectX::Convert(pixels, work_img.format, filter_flags, DirectX::TEX_THRESHOLD_DEFAULT, fresh);
+				fresh_img = fresh.GetImage(0, 0, 0);
+			}
+		}
+		else
+		{
+			const DirectX::Image& parent = *dst.GetImage(level - 1, item, 0);
+			const DirectX::Rect src_rect = AlignToBlocks(2 * tx0 - std::min<size_t>(2 * tx0, 4), 2 * ty0 - std::min<size_t>(2 * ty0, 4), 2 * tx1 + 4, 2 * ty1 + 4, parent.width, parent.height);
+			
+			DirectX::ScratchImage parent_pixels;
+			ret = DecodeRegion(parent, src_rect, parent_pixels);
+			
+			/* take the parent's new pixels from before they were encoded so the error does not pile up down the chain */
+			const size_t ix0 = std::max(src_rect.x, prev_rect.x), ix1 = std::min(src_rect.x + src_rect.w, prev_rect.x + prev_rect.w);
+			const size_t iy0 = std::max(src_rect.y, prev_rect.y), iy1 = std::min(src_rect.y + src_rect.h, prev_rect.y + prev_rect.h);
+			if(SUCCEEDED(ret) && ix0 < ix1 && iy0 < iy1)
+			{
+				const DirectX::Rect overlap(ix0 - prev_rect.x, iy0 - prev_rect.y, ix1 - ix0, iy1 - iy0);
+				ret = DirectX::CopyRectangle(*prev_work.GetImage(0, 0, 0), overlap, *parent_pixels.GetImage(0, 0, 0), DirectX::TEX_FILTER_DEFAULT, ix0 - src_rect.x, iy0 - src_rect.y);
+			}
+			
+			/* a parent area reaching an odd edge maps onto the rest of this level */
+			const size_t out_x = src_rect.x / 2, out_y = src_rect.y / 2;
+			const size_t out_w = (src_rect.x + src_rect.w == parent.width)? img.width - out_x : src_rect.w / 2;
+			const size_t out_h = (src_rect.y + src_rect.h == parent.height)? img.height - out_y : src_rect.h / 2;
+			if(SUCCEEDED(ret))
+			{
+				ret = DirectX::Resize(*parent_pixels.GetImage(0, 0, 0), out_w, out_h, filter_flags, fresh);
+			}
+			fresh_img = fresh.GetImage(0, 0, 0);
+			fx = tx0 - out_x;
+			fy = ty0 - out_y;
+		}
+		
+		if(SUCCEEDED(ret))
+		{
+			ret = DirectX::CopyRectangle(*fresh_img, DirectX::Rect(fx, fy, tx1 - tx0, ty1 - ty0), work_img, DirectX::TEX_FILTER_DEFAULT, tx0 - aligned.x, ty0 - aligned.y);
+		}
+		if(SUCCEEDED(ret))
+		{
+			ret = EncodeRegion(work_img, img, aligned.x, aligned.y);
+		}
+		if(FAILED(ret))
+		{
+			return ret;
+		}
+		
+		prev_work = std::move(work);
+		prev_rect = aligned;
+	}
+	return S_OK;
+}
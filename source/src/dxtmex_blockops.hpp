@@ -0,0 +1,30 @@
+#pragma once
+
+#include "mex.h"
+#include "DirectXTex.h"
+
+namespace DXTMEX
+{
+	/* operations on block compressed images which only decode the blocks they have to */
+	namespace BlockOps
+	{
+		/* flips or rotates by 180 degrees by moving blocks and permuting their selectors, which is bit exact. blocks in
+		 * a mode that cannot be permuted are decoded, flipped and re-encoded on their own. returns false without
+		 * touching dst if the format or the dimensions do not allow it, or if re-encoding a block fails. */
+		bool FlipRotate(const DirectX::ScratchImage& src, DWORD fr_flags, DirectX::ScratchImage& dst);
+		
+		/* copies a rectangle between two images of the same BC format. destination blocks which are fully covered and line
+		 * up with source blocks are moved as is, only the blocks on an unaligned border are decoded, patched and re-encoded. */
+		HRESULT CopyRectangle(const DirectX::Image& src, const DirectX::Rect& rect, const DirectX::Image& dst, size_t x_offset, size_t y_offset);
+		
+		/* decodes a rectangle of img, which must be block aligned or reach the edge for compressed formats */
+		HRESULT DecodeRegion(const DirectX::Image& img, const DirectX::Rect& rect, DirectX::ScratchImage& out);
+		
+		/* encodes pixels into dst at a block aligned offset, overwriting just the blocks they cover */
+		HRESULT EncodeRegion(const DirectX::Image& pixels, const DirectX::Image& dst, size_t x_offset, size_t y_offset);
+		
+		/* replaces a rectangle of one array item with pixels and rebuilds only the blocks of each mip level below it.
+		 * the footprint halves with every level, the parent is read with a block of margin for the wider filters. */
+		HRESULT UpdateRegion(const DirectX::ScratchImage& dst, size_t item, const DirectX::Image& pixels, size_t x_offset, size_t y_offset, DirectX::TEX_FILTER_FLAGS filter_flags);
+	}
+}
@@ -0,0 +1,1130 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define DXTMEX_USE_SSE2
+#endif
+
+#include "dxtmex_compress.hpp"
+#include "dxtmex_metrics.hpp"
+#include "dxtmex_mexerror.hpp"
+#include "dxtmex_parallel.hpp"
+
+using namespace DXTMEX;
+
+namespace
+{
+	/* best endpoint pairs for reproducing a single 8-bit value, see the "single color" tables of stb_dxt and squish */
+	struct SingleColorTables
+	{
+		uint8_t bc1_5bit[256][2]; /* index 2 of BC1, 2/3 e0 + 1/3 e1 */
+		uint8_t bc1_6bit[256][2];
+		uint8_t bc7_7bit[256][2]; /* index 1 of BC7 mode 5, weight 21/64 */
+
+		SingleColorTables()
+		{
+			for(int v = 0; v < 256; v++)
+			{
+				Fill(bc1_5bit[v], 5, v, [](int e0, int e1) {return (2 * e0 + e1 + 1) / 3;});
+				Fill(bc1_6bit[v], 6, v, [](int e0, int e1) {return (2 * e0 + e1 + 1) / 3;});
+				Fill(bc7_7bit[v], 7, v, [](int e0, int e1) {return ((64 - 21) * e0 + 21 * e1 + 32) >> 6;});
+			}
+		}
+
+		template <typename F>
+		static void Fill(uint8_t (&entry)[2], int bits, int v, F interpolate)
+		{
+			int best_err = 256;
+			for(int a = 0; a < (1 << bits); a++)
+			{
+				for(int b = 0; b < (1 << bits); b++)
+				{
+					int err = std::abs(interpolate(Expand(a, bits), Expand(b, bits)) - v);
+					if(err < best_err)
+					{
+						best_err = err;
+						entry[0] = static_cast<uint8_t>(a);
+						entry[1] = static_cast<uint8_t>(b);
+					}
+				}
+			}
+		}
+
+		static int Expand(int c, int bits)
+		{
+			return (c << (8 - bits)) | (c >> (2 * bits - 8));
+		}
+	};
+
+	const SingleColorTables& GetSingleColorTables()
+	{
+		static const SingleColorTables tables;
+		return tables;
+	}
+
+	/* formats where the quality level changes the search */
+	bool IsTiered(DXGI_FORMAT fmt)
+	{
+		return fmt == DXGI_FORMAT_BC7_UNORM || fmt == DXGI_FORMAT_BC7_UNORM_SRGB || fmt == DXGI_FORMAT_BC7_TYPELESS;
+	}
+
+	bool IsFastPathSource(DXGI_FORMAT fmt)
+	{
+		switch(fmt)
+		{
+			case DXGI_FORMAT_R8G8B8A8_UNORM:
+			case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+			case DXGI_FORMAT_B8G8R8A8_UNORM:
+			case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB: return true;
+			default:                              return false;
+		}
+	}
+
+	/* what DirectXTex decodes each BC format to, a compressed source is decoded to this one tile at a time */
+	DXGI_FORMAT DecodedFormat(DXGI_FORMAT fmt)
+	{
+		switch(fmt)
+		{
+			case DXGI_FORMAT_BC1_UNORM_SRGB:
+			case DXGI_FORMAT_BC2_UNORM_SRGB:
+			case DXGI_FORMAT_BC3_UNORM_SRGB:
+			case DXGI_FORMAT_BC7_UNORM_SRGB: return DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+			case DXGI_FORMAT_BC4_UNORM:      return DXGI_FORMAT_R8_UNORM;
+			case DXGI_FORMAT_BC4_SNORM:      return DXGI_FORMAT_R8_SNORM;
+			case DXGI_FORMAT_BC5_UNORM:      return DXGI_FORMAT_R8G8_UNORM;
+			case DXGI_FORMAT_BC5_SNORM:      return DXGI_FORMAT_R8G8_SNORM;
+			case DXGI_FORMAT_BC6H_UF16:
+			case DXGI_FORMAT_BC6H_SF16:      return DXGI_FORMAT_R16G16B16A16_FLOAT;
+			default:                         return DXGI_FORMAT_R8G8B8A8_UNORM;
+		}
+	}
+
+	bool IsFastPathTarget(DXGI_FORMAT fmt)
+	{
+		switch(fmt)
+		{
+			case DXGI_FORMAT_BC1_UNORM:
+			case DXGI_FORMAT_BC1_UNORM_SRGB:
+			case DXGI_FORMAT_BC2_UNORM:
+			case DXGI_FORMAT_BC2_UNORM_SRGB:
+			case DXGI_FORMAT_BC3_UNORM:
+			case DXGI_FORMAT_BC3_UNORM_SRGB:
+			case DXGI_FORMAT_BC4_UNORM:
+			case DXGI_FORMAT_BC5_UNORM:
+			case DXGI_FORMAT_BC7_UNORM:
+			case DXGI_FORMAT_BC7_UNORM_SRGB: return true;
+			default:                         return false;
+		}
+	}
+
+	/* block is 4x4 pixels of 32 bits each */
+	bool IsUniformBlock(const uint8_t* block, size_t row_pitch)
+	{
+#ifdef DXTMEX_USE_SSE2
+		int32_t first;
+		memcpy(&first, block, sizeof(first));
+		const __m128i ref = _mm_set1_epi32(first);
+		__m128i eq = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block)), ref);
+		for(size_t r = 1; r < 4; r++)
+		{
+			eq = _mm_and_si128(eq, _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block + r * row_pitch)), ref));
+		}
+		return _mm_movemask_epi8(eq) == 0xFFFF;
+#else
+		for(size_t r = 0; r < 4; r++)
+		{
+			for(size_t c = 0; c < 4; c++)
+			{
+				if(memcmp(block, block + r * row_pitch + c * 4, 4) != 0)
+				{
+					return false;
+				}
+			}
+		}
+		return true;
+#endif
+	}
+
+	void PutBits(uint8_t* block, size_t& pos, size_t num_bits, uint32_t value)
+	{
+		for(size_t i = 0; i < num_bits; i++, pos++)
+		{
+			if(value & (1u << i))
+			{
+				block[pos >> 3u] |= static_cast<uint8_t>(1u << (pos & 7u));
+			}
+		}
+	}
+
+	void EncodeUniformBC1(const uint8_t rgba[4], float threshold, uint8_t* out)
+	{
+		uint16_t c0 = 0, c1 = 0;
+		uint32_t indices;
+		if(rgba[3] / 255.0f < threshold)
+		{
+			/* index 3 is transparent in the three color mode */
+			indices = 0xFFFFFFFF;
+		}
+		else
+		{
+			const SingleColorTables& tables = GetSingleColorTables();
+			c0 = static_cast<uint16_t>((tables.bc1_5bit[rgba[0]][0] << 11u) | (tables.bc1_6bit[rgba[1]][0] << 5u) | tables.bc1_5bit[rgba[2]][0]);
+			c1 = static_cast<uint16_t>((tables.bc1_5bit[rgba[0]][1] << 11u) | (tables.bc1_6bit[rgba[1]][1] << 5u) | tables.bc1_5bit[rgba[2]][1]);
+			if(c0 > c1)
+			{
+				indices = 0xAAAAAAAA; /* 2/3 c0 + 1/3 c1 */
+			}
+			else if(c0 < c1)
+			{
+				std::swap(c0, c1);
+				indices = 0xFFFFFFFF; /* 1/3 c0 + 2/3 c1 */
+			}
+			else
+			{
+				indices = 0;
+			}
+		}
+		memcpy(out, &c0, 2);
+		memcpy(out + 2, &c1, 2);
+		memcpy(out + 4, &indices, 4);
+	}
+
+	void EncodeUniformBC4(uint8_t value, uint8_t* out)
+	{
+		out[0] = value;
+		out[1] = value;
+		memset(out + 2, 0, 6);
+	}
+
+	void EncodeUniformBC7(const uint8_t rgba[4], uint8_t* out)
+	{
+		/* mode 5 has separate alpha, so only the color channels are interpolated */
+		const SingleColorTables& tables = GetSingleColorTables();
+		memset(out, 0, 16);
+		size_t pos = 0;
+		PutBits(out, pos, 6, 0x20);
+		PutBits(out, pos, 2, 0);
+		for(int c = 0; c < 3; c++)
+		{
+			PutBits(out, pos, 7, tables.bc7_7bit[rgba[c]][0]);
+			PutBits(out, pos, 7, tables.bc7_7bit[rgba[c]][1]);
+		}
+		PutBits(out, pos, 8, rgba[3]);
+		PutBits(out, pos, 8, rgba[3]);
+		PutBits(out, pos, 1, 1);
+		for(int i = 1; i < 16; i++)
+		{
+			PutBits(out, pos, 2, 1);
+		}
+		/* alpha indices stay zero */
+	}
+
+	void EncodeUniformBlock(DXGI_FORMAT fmt, const uint8_t rgba[4], float threshold, uint8_t* out)
+	{
+		switch(fmt)
+		{
+			case DXGI_FORMAT_BC1_UNORM:
+			case DXGI_FORMAT_BC1_UNORM_SRGB:
+			{
+				EncodeUniformBC1(rgba, threshold, out);
+				break;
+			}
+			case DXGI_FORMAT_BC2_UNORM:
+			case DXGI_FORMAT_BC2_UNORM_SRGB:
+			{
+				const uint64_t alpha = ((rgba[3] * 15u + 127u) / 255u) * 0x1111111111111111ull;
+				memcpy(out, &alpha, 8);
+				EncodeUniformBC1(rgba, 0.0f, out + 8);
+				break;
+			}
+			case DXGI_FORMAT_BC3_UNORM:
+			case DXGI_FORMAT_BC3_UNORM_SRGB:
+			{
+				EncodeUniformBC4(rgba[3], out);
+				EncodeUniformBC1(rgba, 0.0f, out + 8);
+				break;
+			}
+			case DXGI_FORMAT_BC4_UNORM:
+			{
+				EncodeUniformBC4(rgba[0], out);
+				break;
+			}
+			case DXGI_FORMAT_BC5_UNORM:
+			{
+				EncodeUniformBC4(rgba[0], out);
+				EncodeUniformBC4(rgba[1], out + 8);
+				break;
+			}
+			case DXGI_FORMAT_BC7_UNORM:
+			case DXGI_FORMAT_BC7_UNORM_SRGB:
+			default:
+			{
+				EncodeUniformBC7(rgba, out);
+				break;
+			}
+		}
+	}
+
+	/* an LZ match of a repeated field costs about a token and an offset */
+	constexpr double MATCH_BITS = 24.0;
+
+	/* 4x4 texels in RGBA8, with a mask of those inside the image */
+	struct BlockTexels
+	{
+		uint8_t rgba[16][4];
+		bool    valid[16];
+	};
+
+	struct DecodedBlock
+	{
+		uint8_t rgba[16][4];
+	};
+
+	/* an 8 byte BC1 or BC4 half of a block and the channels it stores */
+	struct BlockPart
+	{
+		size_t offset;
+		bool   is_color;
+		bool   four_color_only; /* the color half of BC2 and BC3 ignores the endpoint order */
+		int    channel;         /* for BC4 halves */
+	};
+
+	/* returns the halves rate-distortion optimization works on, none for BC7 which is handled whole */
+	size_t GetBlockParts(DXGI_FORMAT fmt, BlockPart (&parts)[2])
+	{
+		switch(fmt)
+		{
+			case DXGI_FORMAT_BC1_UNORM:
+			case DXGI_FORMAT_BC1_UNORM_SRGB: parts[0] = {0, true, false, 0}; return 1;
+			case DXGI_FORMAT_BC3_UNORM:
+			case DXGI_FORMAT_BC3_UNORM_SRGB: parts[0] = {0, false, false, 3}; parts[1] = {8, true, true, 0}; return 2;
+			case DXGI_FORMAT_BC4_UNORM:      parts[0] = {0, false, false, 0}; return 1;
+			case DXGI_FORMAT_BC5_UNORM:      parts[0] = {0, false, false, 0}; parts[1] = {8, false, false, 1}; return 2;
+			default:                         return 0;
+		}
+	}
+
+	template <typename T>
+	size_t TileBlocks(const T& tile)
+	{
+		return ((tile.src->width + 3) / 4) * ((tile.rows + 3) / 4);
+	}
+
+	bool IsRDOTarget(DXGI_FORMAT fmt)
+	{
+		BlockPart parts[2];
+		return GetBlockParts(fmt, parts) > 0 || fmt == DXGI_FORMAT_BC7_UNORM || fmt == DXGI_FORMAT_BC7_UNORM_SRGB;
+	}
+
+	/* decodes a half over a copy of the source texels, so channels it does not store cost nothing */
+	void DecodePart(const BlockPart& part, const uint8_t* data, const BlockTexels& src, uint8_t (&out)[16][4])
+	{
+		memcpy(out, src.rgba, sizeof(out));
+		if(part.is_color)
+		{
+			const uint32_t c0 = data[0] | (data[1] << 8u);
+			const uint32_t c1 = data[2] | (data[3] << 8u);
+			int pal[4][4];
+			for(int e = 0; e < 2; e++)
+			{
+				const uint32_t c = e? c1 : c0;
+				const uint32_t r = (c >> 11u) & 31u, g = (c >> 5u) & 63u, b = c & 31u;
+				pal[e][0] = static_cast<int>((r << 3u) | (r >> 2u));
+				pal[e][1] = static_cast<int>((g << 2u) | (g >> 4u));
+				pal[e][2] = static_cast<int>((b << 3u) | (b >> 2u));
+				pal[e][3] = 255;
+			}
+			const bool is_four_color = part.four_color_only || c0 > c1;
+			for(int ch = 0; ch < 3; ch++)
+			{
+				pal[2][ch] = is_four_color? (2 * pal[0][ch] + pal[1][ch] + 1) / 3 : (pal[0][ch] + pal[1][ch] + 1) / 2;
+				pal[3][ch] = is_four_color? (pal[0][ch] + 2 * pal[1][ch] + 1) / 3 : 0;
+			}
+			pal[2][3] = 255;
+			pal[3][3] = is_four_color? 255 : 0;
+
+			const uint32_t sel = data[4] | (data[5] << 8u) | (data[6] << 16u) | (static_cast<uint32_t>(data[7]) << 24u);
+			const int num_channels = part.four_color_only? 3 : 4;
+			for(int i = 0; i < 16; i++)
+			{
+				for(int ch = 0; ch < num_channels; ch++)
+				{
+					out[i][ch] = static_cast<uint8_t>(pal[(sel >> (2 * i)) & 3u][ch]);
+				}
+			}
+		}
+		else
+		{
+			const int a0 = data[0], a1 = data[1];
+			int pal[8] = {a0, a1};
+			for(int k = 1; k < 7; k++)
+			{
+				pal[k + 1] = (a0 > a1)? ((7 - k) * a0 + k * a1 + 3) / 7 : (k < 5? ((5 - k) * a0 + k * a1 + 2) / 5 : (k == 5? 0 : 255));
+			}
+
+			uint64_t sel = 0;
+			for(int b = 0; b < 6; b++)
+			{
+				sel |= static_cast<uint64_t>(data[2 + b]) << (8 * b);
+			}
+			for(int i = 0; i < 16; i++)
+			{
+				out[i][part.channel] = static_cast<uint8_t>(pal[(sel >> (3 * i)) & 7u]);
+			}
+		}
+	}
+
+	double BlockSSE(const BlockTexels& src, const uint8_t (&dec)[16][4])
+	{
+		double sse = 0;
+		for(int i = 0; i < 16; i++)
+		{
+			if(!src.valid[i])
+			{
+				continue;
+			}
+			for(int ch = 0; ch < 4; ch++)
+			{
+				const double diff = static_cast<double>(src.rgba[i][ch]) - dec[i][ch];
+				sse += diff * diff;
+			}
+		}
+		return sse;
+	}
+
+	/* the mse summed over the channels like DirectX::ComputeMSE, through the shared decode and compare pass */
+	HRESULT ComputeImageMSE(const DirectX::Image& image1, const DirectX::Image& image2, float& mse)
+	{
+		std::vector<Metrics::ErrorResult> results(1);
+		results[0].image1 = &image1;
+		results[0].image2 = &image2;
+		HRESULT hres = Metrics::ComputeError(results, DirectX::CMSE_DEFAULT, 0);
+		if(SUCCEEDED(hres))
+		{
+			mse = static_cast<float>(results[0].mse);
+		}
+		return hres;
+	}
+}
+
+constexpr size_t CompressionScheduler::TILE_BLOCKS;
+constexpr size_t CompressionScheduler::MAX_QUALITY;
+constexpr size_t CompressionScheduler::RDO_WINDOW;
+
+/* blocks scored per candidate when choosing a format */
+static constexpr size_t SAMPLE_BLOCKS = 4096;
+
+CompressionScheduler::CompressionScheduler(DXGI_FORMAT fmt, DirectX::TEX_COMPRESS_FLAGS flags, float threshold) :
+	_fmt(fmt),
+	/* tiles are already spread across the threads */
+	_flags(static_cast<DirectX::TEX_COMPRESS_FLAGS>(flags & ~DirectX::TEX_COMPRESS_PARALLEL)),
+	_threshold(threshold),
+	_fast_path(false),
+	_num_fast_blocks(0),
+	_quality(MAX_QUALITY),
+	_has_quality(false),
+	_time_budget(0),
+	_num_textures(0),
+	_rdo_lambda(0)
+{
+}
+
+void CompressionScheduler::SetFastPath(bool is_enabled)
+{
+	/* dithering and colorspace conversion change what the encoder sees, so leave those blocks to DirectXTex */
+	const uint32_t exclusive_flags = DirectX::TEX_COMPRESS_RGB_DITHER | DirectX::TEX_COMPRESS_A_DITHER | DirectX::TEX_COMPRESS_SRGB;
+	this->_fast_path = is_enabled && (this->_flags & exclusive_flags) == 0;
+}
+
+void CompressionScheduler::Add(const DirectX::ScratchImage& src, DirectX::ScratchImage& dst, DXGI_FORMAT fmt)
+{
+	const DirectX::TexMetadata& src_metadata = src.GetMetadata();
+	if(!DirectX::IsCompressed(fmt) || (DirectX::IsCompressed(src_metadata.format) && DirectX::IsTypeless(src_metadata.format)) || DirectX::IsPlanar(src_metadata.format) || DirectX::IsPalettized(src_metadata.format))
+	{
+		/* let DirectXTex handle (or reject) anything that cannot be split into block rows */
+		hres = DirectX::Compress(src.GetImages(), src.GetImageCount(), src_metadata, fmt, this->_flags, this->_threshold, dst);
+		if(FAILED(hres))
+		{
+			MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_HRESULT, "CompressError", "There was an error while compressing the image.");
+		}
+		return;
+	}
+
+	this->_num_textures++;
+
+	DirectX::TexMetadata dst_metadata = src_metadata;
+	dst_metadata.format = fmt;
+	hres = dst.Initialize(dst_metadata);
+	if(FAILED(hres))
+	{
+		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_HRESULT, "InitializationError", "There was an error while initializing the compressed image.");
+	}
+
+	if(src.GetImageCount() != dst.GetImageCount())
+	{
+		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_INTERNAL, "CompressError", "The compressed image did not have the same number of subresources as the source.");
+	}
+
+	/* a compressed source is transcoded, the encoder only ever sees its decoded tiles */
+	const DXGI_FORMAT tile_format = DirectX::IsCompressed(src_metadata.format)? DecodedFormat(src_metadata.format) : src_metadata.format;
+	const bool fast_path = this->_fast_path
+	                       && IsFastPathTarget(fmt)
+	                       && IsFastPathSource(tile_format)
+	                       && DirectX::IsSRGB(tile_format) == DirectX::IsSRGB(fmt);
+
+	for(size_t i = 0; i < src.GetImageCount(); i++)
+	{
+		const DirectX::Image* src_img = src.GetImages() + i;
+		const DirectX::Image* dst_img = dst.GetImages() + i;
+
+		const size_t blocks_wide = std::max<size_t>(1, (src_img->width + 3) / 4);
+		const size_t tile_rows = 4 * std::max<size_t>(1, TILE_BLOCKS / blocks_wide);
+		for(size_t row = 0; row < src_img->height; row += tile_rows)
+		{
+			this->_tiles.push_back({src_img, dst_img, row, std::min(tile_rows, src_img->height - row), fmt, fast_path});
+		}
+	}
+}
+
+void CompressionScheduler::SetQuality(size_t quality)
+{
+	if(quality > MAX_QUALITY)
+	{
+		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "InvalidQualityError", "The quality level must be between 0 and %d.", (int)MAX_QUALITY);
+	}
+	this->_quality = quality;
+	this->_has_quality = true;
+}
+
+DirectX::TEX_COMPRESS_FLAGS CompressionScheduler::QualityFlags(size_t quality)
+{
+	if(!this->_has_quality && this->_time_budget <= 0)
+	{
+		return this->_flags;
+	}
+
+	/* the BC7 search space grows from mode 6 only, to the default modes, to every mode including 3 subsets */
+	const uint32_t tier_flags = DirectX::TEX_COMPRESS_BC7_QUICK | DirectX::TEX_COMPRESS_BC7_USE_3SUBSETS;
+	uint32_t flags = this->_flags & ~tier_flags;
+	switch(quality)
+	{
+		case 0:  flags |= DirectX::TEX_COMPRESS_BC7_QUICK; break;
+		case 1:  break;
+		case 2:
+		default: flags |= DirectX::TEX_COMPRESS_BC7_USE_3SUBSETS; break;
+	}
+	return static_cast<DirectX::TEX_COMPRESS_FLAGS>(flags);
+}
+
+void CompressionScheduler::Run()
+{
+	const auto start = std::chrono::steady_clock::now();
+	const bool is_refining = this->_time_budget > 0 && this->_quality > 0;
+
+	/* with a budget, start the tiered formats at the fastest tier and spend the rest of the time where it helps most */
+	const DirectX::TEX_COMPRESS_FLAGS first_pass_flags = this->QualityFlags(is_refining? 0 : this->_quality);
+	const DirectX::TEX_COMPRESS_FLAGS final_flags = this->QualityFlags(this->_quality);
+
+	/* the MATLAB API may not be used from the workers, so just keep the first failure */
+	std::atomic<HRESULT> first_failure(S_OK);
+	std::atomic<size_t> num_fast_blocks(0);
+	size_t num_blocks = 0;
+	for(const Tile& tile : this->_tiles)
+	{
+		num_blocks += TileBlocks(tile);
+	}
+	Progress::AddTotal(num_blocks);
+
+	/* the variants of one source share its bands, so each band is converted to float once for all of their encodes */
+	std::vector<std::vector<size_t>> groups;
+	std::map<std::pair<const DirectX::Image*, size_t>, size_t> group_indices;
+	for(size_t i = 0; i < this->_tiles.size(); i++)
+	{
+		const Tile& tile = this->_tiles[i];
+		auto inserted = group_indices.insert({{tile.src, tile.row}, groups.size()});
+		if(inserted.second)
+		{
+			groups.emplace_back();
+		}
+		groups[inserted.first->second].push_back(i);
+	}
+
+	Parallel::For(groups.size(), [&](size_t g)
+	{
+		const std::vector<size_t>& group = groups[g];
+		DirectX::ScratchImage decoded, converted;
+		DirectX::Image shared_band;
+		DirectX::TEX_COMPRESS_FLAGS shared_flags = DirectX::TEX_COMPRESS_DEFAULT;
+		bool is_shared = false;
+		if(group.size() > 1)
+		{
+			is_shared = SUCCEEDED(this->GetFloatBand(this->_tiles[group[0]], decoded, converted, shared_band, shared_flags));
+		}
+
+		for(size_t i : group)
+		{
+			const Tile& tile = this->_tiles[i];
+			const DirectX::TEX_COMPRESS_FLAGS tile_flags = IsTiered(tile.fmt)? first_pass_flags : final_flags;
+			uint8_t* dst = tile.dst->pixels + (tile.row / 4) * tile.dst->rowPitch;
+			size_t tile_fast_blocks = 0;
+			HRESULT tile_hres;
+			if(is_shared && !tile.fast_path)
+			{
+				tile_hres = this->CompressBand(shared_band, tile.fmt, static_cast<DirectX::TEX_COMPRESS_FLAGS>(tile_flags | shared_flags), dst, tile.dst->rowPitch);
+			}
+			else
+			{
+				tile_hres = this->CompressTile(tile, tile_flags, dst, tile_fast_blocks);
+			}
+			if(FAILED(tile_hres))
+			{
+				HRESULT expected = S_OK;
+				first_failure.compare_exchange_strong(expected, tile_hres);
+			}
+			num_fast_blocks += tile_fast_blocks;
+			Progress::Advance(TileBlocks(tile));
+		}
+	});
+	this->_num_fast_blocks += num_fast_blocks.load();
+
+	hres = first_failure.load();
+	if(FAILED(hres))
+	{
+		this->_tiles.clear();
+		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_HRESULT, "CompressError", "There was an error while compressing the image.");
+	}
+
+	if(is_refining)
+	{
+		const auto budget = std::chrono::duration<double, std::milli>(this->_time_budget * this->_num_textures);
+		this->RunRefinement(start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(budget));
+	}
+
+	/* rate-distortion optimization is best effort too, a tile which fails keeps its plain encode */
+	if(this->_rdo_lambda > 0)
+	{
+		Parallel::For(this->_tiles.size(), [&](size_t i)
+		{
+			this->OptimizeTile(this->_tiles[i]);
+		});
+	}
+	this->_tiles.clear();
+}
+
+void CompressionScheduler::RunRefinement(std::chrono::steady_clock::time_point deadline)
+{
+	/* refinement is best effort, a tile which fails keeps its first pass result */
+	std::vector<float> errors(this->_tiles.size(), 0.0f);
+	Parallel::For(this->_tiles.size(), [&](size_t i)
+	{
+		const Tile& tile = this->_tiles[i];
+		if(!IsTiered(tile.fmt) || FAILED(this->ComputeTileError(tile, tile.dst->pixels + (tile.row / 4) * tile.dst->rowPitch, errors[i])))
+		{
+			errors[i] = 0.0f;
+		}
+	});
+
+	std::vector<size_t> order(this->_tiles.size());
+	for(size_t i = 0; i < order.size(); i++)
+	{
+		order[i] = i;
+	}
+	std::stable_sort(order.begin(), order.end(), [&errors](size_t a, size_t b) {return errors[a] > errors[b];});
+
+	/* tiles are claimed in order, so the worst ones are refined first */
+	const DirectX::TEX_COMPRESS_FLAGS refine_flags = this->QualityFlags(this->_quality);
+	Parallel::For(order.size(), [&](size_t i)
+	{
+		const Tile& tile = this->_tiles[order[i]];
+		if(errors[order[i]] <= 0.0f || std::chrono::steady_clock::now() >= deadline)
+		{
+			return;
+		}
+
+		uint8_t* dst = tile.dst->pixels + (tile.row / 4) * tile.dst->rowPitch;
+		const size_t dst_size = DirectX::ComputeScanlines(tile.dst->format, tile.rows) * tile.dst->rowPitch;
+		std::vector<uint8_t> refined(dst_size);
+		size_t unused_fast_blocks = 0;
+		float refined_error;
+		if(FAILED(this->CompressTile(tile, refine_flags, refined.data(), unused_fast_blocks))
+		   || FAILED(this->ComputeTileError(tile, refined.data(), refined_error)))
+		{
+			return;
+		}
+
+		if(refined_error < errors[order[i]])
+		{
+			memcpy(dst, refined.data(), dst_size);
+		}
+	});
+}
+
+HRESULT CompressionScheduler::GetSourceBand(const Tile& tile, DirectX::ScratchImage& decoded, DirectX::Image& band)
+{
+	/* BC blocks are encoded independently, so a band of block rows compresses to the same bytes */
+	band = *tile.src;
+	band.height = tile.rows;
+	if(!DirectX::IsCompressed(band.format))
+	{
+		band.pixels += tile.row * band.rowPitch;
+		band.slicePitch = band.rowPitch * band.height;
+		return S_OK;
+	}
+
+	/* rows of a compressed source are rows of blocks */
+	band.pixels += (tile.row / 4) * band.rowPitch;
+	band.slicePitch = DirectX::ComputeScanlines(band.format, band.height) * band.rowPitch;
+	HRESULT band_hres = DirectX::Decompress(band, DecodedFormat(band.format), decoded);
+	if(SUCCEEDED(band_hres))
+	{
+		band = *decoded.GetImage(0, 0, 0);
+	}
+	return band_hres;
+}
+
+HRESULT CompressionScheduler::GetFloatBand(const Tile& tile, DirectX::ScratchImage& decoded, DirectX::ScratchImage& converted, DirectX::Image& band, DirectX::TEX_COMPRESS_FLAGS& flags)
+{
+	HRESULT band_hres = this->GetSourceBand(tile, decoded, band);
+	if(FAILED(band_hres) || band.format == DXGI_FORMAT_R32G32B32A32_FLOAT)
+	{
+		return band_hres;
+	}
+
+	/* DirectX::Compress reads the stored values and only then applies the sRGB curve, so convert the stored values
+	 * and tell the encoder the input is sRGB. the encodes are then identical to those of the original band. */
+	DirectX::Image stored = band;
+	stored.format = DirectX::MakeLinear(band.format);
+	band_hres = DirectX::Convert(stored, DXGI_FORMAT_R32G32B32A32_FLOAT, DirectX::TEX_FILTER_DEFAULT, DirectX::TEX_THRESHOLD_DEFAULT, converted);
+	if(FAILED(band_hres))
+	{
+		return band_hres;
+	}
+	flags = DirectX::IsSRGB(band.format)? DirectX::TEX_COMPRESS_SRGB_IN : DirectX::TEX_COMPRESS_DEFAULT;
+	band = *converted.GetImage(0, 0, 0);
+	return S_OK;
+}
+
+HRESULT CompressionScheduler::CompressTile(const Tile& tile, DirectX::TEX_COMPRESS_FLAGS flags, uint8_t* dst, size_t& num_fast_blocks)
+{
+	DirectX::ScratchImage decoded;
+	DirectX::Image band;
+	HRESULT band_hres = this->GetSourceBand(tile, decoded, band);
+	if(FAILED(band_hres))
+	{
+		return band_hres;
+	}
+
+	if(!tile.fast_path)
+	{
+		return this->CompressBand(band, tile.fmt, flags, dst, tile.dst->rowPitch);
+	}
+
+	/* only whole blocks are considered, the edges are padded by the encoder */
+	const size_t block_size = DirectX::BitsPerPixel(tile.fmt) * 2;
+	const size_t full_blocks_wide = band.width / 4;
+	const size_t full_blocks_high = band.height / 4;
+	const bool is_bgra = (band.format == DXGI_FORMAT_B8G8R8A8_UNORM || band.format == DXGI_FORMAT_B8G8R8A8_UNORM_SRGB);
+
+	std::vector<uint8_t> is_uniform(full_blocks_wide * full_blocks_high, 0);
+	size_t tile_fast_blocks = 0;
+	for(size_t by = 0; by < full_blocks_high; by++)
+	{
+		for(size_t bx = 0; bx < full_blocks_wide; bx++)
+		{
+			const uint8_t* block = band.pixels + by * 4 * band.rowPitch + bx * 16;
+			if(IsUniformBlock(block, band.rowPitch))
+			{
+				is_uniform[by * full_blocks_wide + bx] = 1;
+				tile_fast_blocks++;
+			}
+		}
+	}
+
+	if(tile_fast_blocks == 0)
+	{
+		return this->CompressBand(band, tile.fmt, flags, dst, tile.dst->rowPitch);
+	}
+
+	const size_t blocks_high = (band.height + 3) / 4;
+	const size_t blocks_wide = (band.width + 3) / 4;
+	for(size_t by = 0; by < blocks_high; by++)
+	{
+		DirectX::Image block_row = band;
+		block_row.pixels += by * 4 * band.rowPitch;
+		block_row.height = std::min<size_t>(4, band.height - by * 4);
+		block_row.slicePitch = block_row.rowPitch * block_row.height;
+		uint8_t* dst_row = dst + by * tile.dst->rowPitch;
+
+		/* hand the runs between uniform blocks to DirectXTex */
+		size_t run_start = 0;
+		for(size_t bx = 0; bx <= blocks_wide; bx++)
+		{
+			const bool uniform = (bx < full_blocks_wide && by < full_blocks_high && is_uniform[by * full_blocks_wide + bx]);
+			if(bx < blocks_wide && !uniform)
+			{
+				continue;
+			}
+
+			if(bx > run_start)
+			{
+				DirectX::Image run = block_row;
+				run.pixels += run_start * 16;
+				run.width = std::min(band.width, bx * 4) - run_start * 4;
+				HRESULT run_hres = this->CompressBand(run, tile.fmt, flags, dst_row + run_start * block_size, tile.dst->rowPitch);
+				if(FAILED(run_hres))
+				{
+					return run_hres;
+				}
+			}
+			run_start = bx + 1;
+
+			if(uniform)
+			{
+				const uint8_t* px = block_row.pixels + bx * 16;
+				const uint8_t rgba[4] = {px[is_bgra? 2 : 0], px[1], px[is_bgra? 0 : 2], px[3]};
+				EncodeUniformBlock(tile.fmt, rgba, this->_threshold, dst_row + bx * block_size);
+			}
+		}
+	}
+
+	num_fast_blocks = tile_fast_blocks;
+	return S_OK;
+}
+
+HRESULT CompressionScheduler::CompressBand(const DirectX::Image& src, DXGI_FORMAT fmt, DirectX::TEX_COMPRESS_FLAGS flags, uint8_t* dst, size_t dst_row_pitch)
+{
+	DirectX::ScratchImage compressed;
+	HRESULT band_hres = DirectX::Compress(src, fmt, flags, this->_threshold, compressed);
+	if(FAILED(band_hres))
+	{
+		return band_hres;
+	}
+
+	const DirectX::Image* out = compressed.GetImage(0, 0, 0);
+	const size_t num_block_rows = DirectX::ComputeScanlines(out->format, out->height);
+	if(out->rowPitch > dst_row_pitch)
+	{
+		return E_UNEXPECTED;
+	}
+	for(size_t i = 0; i < num_block_rows; i++)
+	{
+		memcpy(dst + i * dst_row_pitch, out->pixels + i * out->rowPitch, out->rowPitch);
+	}
+	return S_OK;
+}
+
+HRESULT CompressionScheduler::OptimizeTile(const Tile& tile)
+{
+	if(!IsRDOTarget(tile.fmt))
+	{
+		return S_OK;
+	}
+
+	DirectX::ScratchImage decoded_src, converted_src;
+	DirectX::Image band;
+	HRESULT tile_hres = this->GetSourceBand(tile, decoded_src, band);
+	if(FAILED(tile_hres))
+	{
+		return tile_hres;
+	}
+
+	/* distortion is measured on the stored 8-bit values, so the source is brought to the same space and gamma as the target */
+	if(!IsFastPathSource(band.format) || DirectX::IsSRGB(band.format) != DirectX::IsSRGB(tile.fmt))
+	{
+		const DXGI_FORMAT rgba_format = DirectX::IsSRGB(tile.fmt)? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM;
+		tile_hres = DirectX::Convert(band, rgba_format, DirectX::TEX_FILTER_DEFAULT, this->_threshold, converted_src);
+		if(FAILED(tile_hres))
+		{
+			return tile_hres;
+		}
+		band = *converted_src.GetImage(0, 0, 0);
+	}
+	const bool is_bgra = (band.format == DXGI_FORMAT_B8G8R8A8_UNORM || band.format == DXGI_FORMAT_B8G8R8A8_UNORM_SRGB);
+
+	const size_t block_size = DirectX::BitsPerPixel(tile.fmt) * 2;
+	const size_t blocks_wide = (band.width + 3) / 4;
+	const size_t num_blocks = blocks_wide * ((band.height + 3) / 4);
+	uint8_t* cmp = tile.dst->pixels + (tile.row / 4) * tile.dst->rowPitch;
+	auto block_at = [&](size_t k) {return cmp + (k / blocks_wide) * tile.dst->rowPitch + (k % blocks_wide) * block_size;};
+
+	std::vector<BlockTexels> texels(num_blocks);
+	for(size_t k = 0; k < num_blocks; k++)
+	{
+		for(size_t i = 0; i < 16; i++)
+		{
+			const size_t x = (k % blocks_wide) * 4 + (i % 4);
+			const size_t y = (k / blocks_wide) * 4 + (i / 4);
+			texels[k].valid[i] = (x < band.width && y < band.height);
+			const uint8_t* px = band.pixels + std::min(y, band.height - 1) * band.rowPitch + std::min(x, band.width - 1) * 4;
+			texels[k].rgba[i][0] = px[is_bgra? 2 : 0];
+			texels[k].rgba[i][1] = px[1];
+			texels[k].rgba[i][2] = px[is_bgra? 0 : 2];
+			texels[k].rgba[i][3] = px[3];
+		}
+	}
+
+	const double lambda = this->_rdo_lambda;
+	BlockPart parts[2];
+	const size_t num_parts = GetBlockParts(tile.fmt, parts);
+	if(num_parts == 0)
+	{
+		/* BC7 modes and partitions are too varied to mix, so whole earlier blocks are the only candidates */
+		DirectX::Image cmp_band = *tile.dst;
+		cmp_band.pixels = cmp;
+		cmp_band.height = tile.rows;
+		cmp_band.slicePitch = DirectX::ComputeScanlines(cmp_band.format, cmp_band.height) * cmp_band.rowPitch;
+		DirectX::ScratchImage decoded_cmp;
+		tile_hres = DirectX::Decompress(cmp_band, DirectX::IsSRGB(tile.fmt)? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM, decoded_cmp);
+		if(FAILED(tile_hres))
+		{
+			return tile_hres;
+		}
+		const DirectX::Image& dec_img = *decoded_cmp.GetImage(0, 0, 0);
+		std::vector<DecodedBlock> dec(num_blocks);
+		for(size_t k = 0; k < num_blocks; k++)
+		{
+			for(size_t i = 0; i < 16; i++)
+			{
+				const size_t x = std::min((k % blocks_wide) * 4 + (i % 4), dec_img.width - 1);
+				const size_t y = std::min((k / blocks_wide) * 4 + (i / 4), dec_img.height - 1);
+				memcpy(dec[k].rgba[i], dec_img.pixels + y * dec_img.rowPitch + x * 4, 4);
+			}
+		}
+
+		for(size_t k = 1; k < num_blocks; k++)
+		{
+			const size_t first = (k > RDO_WINDOW)? k - RDO_WINDOW : 0;
+			double best_cost = BlockSSE(texels[k], dec[k].rgba) + lambda * 8.0 * block_size;
+			size_t best = k;
+			for(size_t j = first; j < k; j++)
+			{
+				const double cost = BlockSSE(texels[k], dec[j].rgba) + lambda * MATCH_BITS;
+				if(cost < best_cost)
+				{
+					best_cost = cost;
+					best = j;
+				}
+			}
+			if(best != k)
+			{
+				memcpy(block_at(k), block_at(best), block_size);
+				dec[k] = dec[best];
+			}
+		}
+		return S_OK;
+	}
+
+	/* each half may take an earlier half whole, or keep its endpoints and take the earlier selectors */
+	for(size_t k = 1; k < num_blocks; k++)
+	{
+		const size_t first = (k > RDO_WINDOW)? k - RDO_WINDOW : 0;
+		for(size_t p = 0; p < num_parts; p++)
+		{
+			const BlockPart& part = parts[p];
+			const size_t endpoint_size = part.is_color? 4 : 2;
+			uint8_t* own = block_at(k) + part.offset;
+			uint8_t dec[16][4];
+
+			DecodePart(part, own, texels[k], dec);
+			const double own_sse = BlockSSE(texels[k], dec);
+			double best_cost = own_sse + lambda * 64.0;
+			uint8_t best[8];
+			memcpy(best, own, 8);
+
+			for(size_t j = first; j < k; j++)
+			{
+				const uint8_t* other = block_at(j) + part.offset;
+				if(memcmp(other, own, 8) == 0)
+				{
+					/* already a repeat, so it is as cheap as it gets */
+					if(own_sse + lambda * MATCH_BITS < best_cost)
+					{
+						best_cost = own_sse + lambda * MATCH_BITS;
+						memcpy(best, own, 8);
+					}
+					continue;
+				}
+
+				DecodePart(part, other, texels[k], dec);
+				double cost = BlockSSE(texels[k], dec) + lambda * MATCH_BITS;
+				if(cost < best_cost)
+				{
+					best_cost = cost;
+					memcpy(best, other, 8);
+				}
+
+				uint8_t mixed[8];
+				memcpy(mixed, own, endpoint_size);
+				memcpy(mixed + endpoint_size, other + endpoint_size, 8 - endpoint_size);
+				DecodePart(part, mixed, texels[k], dec);
+				cost = BlockSSE(texels[k], dec) + lambda * (8.0 * endpoint_size + MATCH_BITS);
+				if(cost < best_cost)
+				{
+					best_cost = cost;
+					memcpy(best, mixed, 8);
+				}
+			}
+			memcpy(own, best, 8);
+		}
+	}
+	return S_OK;
+}
+
+HRESULT CompressionScheduler::ComputeTileError(const Tile& tile, const uint8_t* compressed, float& mse)
+{
+	DirectX::ScratchImage decoded;
+	DirectX::Image src_band;
+	HRESULT band_hres = this->GetSourceBand(tile, decoded, src_band);
+	if(FAILED(band_hres))
+	{
+		return band_hres;
+	}
+
+	DirectX::Image cmp_band = *tile.dst;
+	cmp_band.pixels = const_cast<uint8_t*>(compressed);
+	cmp_band.height = tile.rows;
+	cmp_band.slicePitch = DirectX::ComputeScanlines(cmp_band.format, cmp_band.height) * cmp_band.rowPitch;
+
+	return ComputeImageMSE(src_band, cmp_band, mse);
+}
+
+DXGI_FORMAT DXTMEX::SelectCompressedFormat(const DirectX::ScratchImage& src, float max_mse, DirectX::TEX_COMPRESS_FLAGS flags, float threshold)
+{
+	const DirectX::TexMetadata& metadata = src.GetMetadata();
+	if(DirectX::IsCompressed(metadata.format) || DirectX::IsPlanar(metadata.format) || DirectX::IsPalettized(metadata.format) || DirectX::IsTypeless(metadata.format))
+	{
+		return DXGI_FORMAT_UNKNOWN;
+	}
+
+	/* candidates go from smallest to largest, then by preference at the same size */
+	const bool is_srgb = DirectX::IsSRGB(metadata.format);
+	std::vector<DXGI_FORMAT> candidates;
+	candidates.push_back(is_srgb? DXGI_FORMAT_BC1_UNORM_SRGB : DXGI_FORMAT_BC1_UNORM);
+	if(DirectX::HasAlpha(metadata.format) && !src.IsAlphaAllOpaque())
+	{
+		candidates.push_back(is_srgb? DXGI_FORMAT_BC3_UNORM_SRGB : DXGI_FORMAT_BC3_UNORM);
+	}
+	candidates.push_back(is_srgb? DXGI_FORMAT_BC7_UNORM_SRGB : DXGI_FORMAT_BC7_UNORM);
+
+	/* score the candidates on an evenly spaced grid of whole blocks from the top mip */
+	const DirectX::Image* base = src.GetImage(0, 0, 0);
+	const size_t bytes_per_pixel = DirectX::BitsPerPixel(base->format) / 8;
+	const size_t blocks_wide = base->width / 4;
+	const size_t blocks_high = base->height / 4;
+
+	DirectX::ScratchImage sample;
+	const DirectX::Image* sample_img = base;
+	if(blocks_wide * blocks_high > SAMPLE_BLOCKS && DirectX::BitsPerPixel(base->format) % 8 == 0)
+	{
+		const size_t stride = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(blocks_wide * blocks_high) / SAMPLE_BLOCKS)));
+		const size_t sample_wide = (blocks_wide + stride - 1) / stride;
+		const size_t sample_high = (blocks_high + stride - 1) / stride;
+		hres = sample.Initialize2D(base->format, sample_wide * 4, sample_high * 4, 1, 1);
+		if(FAILED(hres))
+		{
+			MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_HRESULT, "InitializationError", "There was an error while initializing the sample image.");
+		}
+		sample_img = sample.GetImage(0, 0, 0);
+		for(size_t by = 0; by < sample_high; by++)
+		{
+			for(size_t bx = 0; bx < sample_wide; bx++)
+			{
+				for(size_t r = 0; r < 4; r++)
+				{
+					memcpy(sample_img->pixels + (by * 4 + r) * sample_img->rowPitch + bx * 4 * bytes_per_pixel,
+					       base->pixels + (by * stride * 4 + r) * base->rowPitch + bx * stride * 4 * bytes_per_pixel,
+					       4 * bytes_per_pixel);
+				}
+			}
+		}
+	}
+
+	/* the MATLAB API may not be used from the workers, a failed candidate just never qualifies */
+	const DirectX::TEX_COMPRESS_FLAGS sample_flags = static_cast<DirectX::TEX_COMPRESS_FLAGS>(flags & ~DirectX::TEX_COMPRESS_PARALLEL);
+	std::vector<float> errors(candidates.size(), INFINITY);
+	Parallel::For(candidates.size(), [&](size_t i)
+	{
+		DirectX::ScratchImage compressed;
+		float mse;
+		if(SUCCEEDED(DirectX::Compress(*sample_img, candidates[i], sample_flags, threshold, compressed))
+		   && SUCCEEDED(ComputeImageMSE(*sample_img, *compressed.GetImage(0, 0, 0), mse)))
+		{
+			errors[i] = mse;
+		}
+	});
+
+	for(size_t i = 0; i < candidates.size(); i++)
+	{
+		if(errors[i] <= max_mse)
+		{
+			return candidates[i];
+		}
+	}
+	return DXGI_FORMAT_UNKNOWN;
+}
+
+double DXTMEX::EstimateBitsPerTexel(const DirectX::ScratchImage& img)
+{
+	/* a greedy LZ parse with a 64 KiB window, matches cost MATCH_BITS and literals their order-0 entropy */
+	constexpr size_t MIN_MATCH = 4;
+	constexpr size_t WINDOW = 65536;
+	const uint8_t* data = img.GetPixels();
+	const size_t size = img.GetPixelsSize();
+
+	std::vector<size_t> last_seen(1u << 16u, SIZE_MAX);
+	size_t histogram[256] = {0};
+	size_t num_literals = 0, num_matches = 0;
+	for(size_t pos = 0; pos < size;)
+	{
+		size_t match_len = 0;
+		if(pos + MIN_MATCH <= size)
+		{
+			uint32_t key;
+			memcpy(&key, data + pos, sizeof(key));
+			const uint32_t hash = (key * 2654435761u) >> 16u;
+			const size_t candidate = last_seen[hash];
+			last_seen[hash] = pos;
+			if(candidate != SIZE_MAX && pos - candidate <= WINDOW)
+			{
+				while(pos + match_len < size && data[candidate + match_len] == data[pos + match_len])
+				{
+					match_len++;
+				}
+			}
+		}
+
+		if(match_len >= MIN_MATCH)
+		{
+			num_matches++;
+			pos += match_len;
+		}
+		else
+		{
+			histogram[data[pos]]++;
+			num_literals++;
+			pos++;
+		}
+	}
+
+	double literal_bits = 0;
+	for(size_t count : histogram)
+	{
+		if(count > 0)
+		{
+			literal_bits -= static_cast<double>(count) * std::log2(static_cast<double>(count) / num_literals);
+		}
+	}
+
+	size_t num_texels = 0;
+	for(size_t i = 0; i < img.GetImageCount(); i++)
+	{
+		num_texels += img.GetImages()[i].width * img.GetImages()[i].height;
+	}
+	return num_texels? (literal_bits + num_matches * MATCH_BITS) / num_texels : 0.0;
+}
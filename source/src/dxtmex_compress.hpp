@@ -0,0 +1,95 @@
+#pragma once
+
+#include <chrono>
+#include <vector>
+
+#include "mex.h"
+#include "DirectXTex.h"
+
+namespace DXTMEX
+{
+	/* compresses every subresource of a batch of images as one pool of block tiles.
+	 * block compressed sources are transcoded, each tile decodes only its own block rows. */
+	class CompressionScheduler
+	{
+	public:
+		CompressionScheduler(DXGI_FORMAT fmt, DirectX::TEX_COMPRESS_FLAGS flags, float threshold);
+
+		/* initializes dst and queues the tiles of src, call on the main thread */
+		void Add(const DirectX::ScratchImage& src, DirectX::ScratchImage& dst) {Add(src, dst, _fmt);}
+
+		/* same, but to a format other than the one the scheduler was made with */
+		void Add(const DirectX::ScratchImage& src, DirectX::ScratchImage& dst, DXGI_FORMAT fmt);
+
+		/* compresses all queued tiles, output is identical to DirectX::Compress unless the fast path is on */
+		void Run();
+
+		/* encodes uniform blocks from tables instead of the mode search. BC1-3 colors are then only within 1/255 of
+		 * DirectX::Compress, so it is off by default. applies to the tiles added after it is set. */
+		void SetFastPath(bool is_enabled);
+
+		/* number of uniform blocks which skipped the mode search */
+		size_t GetNumFastBlocks() {return _num_fast_blocks;}
+
+		/* 0 is fastest, MAX_QUALITY searches every mode and partition DirectXTex offers */
+		void SetQuality(size_t quality);
+
+		/* milliseconds per texture, tiles with the most error are refined to the set quality until it runs out */
+		void SetTimeBudget(double time_budget) {_time_budget = time_budget;}
+
+		/* after encoding, lets blocks repeat earlier selectors or blocks when the squared error it adds
+		 * (8-bit units, summed over channels) is less than lambda per bit saved. 0 turns it off. */
+		void SetRDO(double lambda) {_rdo_lambda = lambda;}
+
+		/* blocks per tile, rounded to whole block rows */
+		static constexpr size_t TILE_BLOCKS = 1024;
+
+		static constexpr size_t MAX_QUALITY = 2;
+
+		/* earlier blocks of the same tile which are tried as a match */
+		static constexpr size_t RDO_WINDOW = 64;
+
+	private:
+		struct Tile
+		{
+			const DirectX::Image* src;
+			const DirectX::Image* dst;
+			size_t                row;  /* first scanline of the tile */
+			size_t                rows;
+			DXGI_FORMAT           fmt;
+			bool                  fast_path;
+		};
+
+		DXGI_FORMAT                 _fmt;
+		DirectX::TEX_COMPRESS_FLAGS _flags;
+		float                       _threshold;
+		std::vector<Tile>           _tiles;
+		bool                        _fast_path;
+		size_t                      _num_fast_blocks;
+		size_t                      _quality;
+		bool                        _has_quality;
+		double                      _time_budget;
+		size_t                      _num_textures;
+		double                      _rdo_lambda;
+
+		DirectX::TEX_COMPRESS_FLAGS QualityFlags(size_t quality);
+		void RunRefinement(std::chrono::steady_clock::time_point deadline);
+
+		HRESULT GetSourceBand(const Tile& tile, DirectX::ScratchImage& decoded, DirectX::Image& band);
+		HRESULT GetFloatBand(const Tile& tile, DirectX::ScratchImage& decoded, DirectX::ScratchImage& converted, DirectX::Image& band, DirectX::TEX_COMPRESS_FLAGS& flags);
+		HRESULT CompressTile(const Tile& tile, DirectX::TEX_COMPRESS_FLAGS flags, uint8_t* dst, size_t& num_fast_blocks);
+		HRESULT CompressBand(const DirectX::Image& src, DXGI_FORMAT fmt, DirectX::TEX_COMPRESS_FLAGS flags, uint8_t* dst, size_t dst_row_pitch);
+		HRESULT ComputeTileError(const Tile& tile, const uint8_t* compressed, float& mse);
+		HRESULT OptimizeTile(const Tile& tile);
+	};
+
+	/* used by 'auto' when no target is given */
+	constexpr double DEFAULT_TARGET_PSNR = 40.0;
+
+	/* picks the smallest BC format whose error on a sample of blocks is at most max_mse,
+	 * returns DXGI_FORMAT_UNKNOWN if the image should stay uncompressed */
+	DXGI_FORMAT SelectCompressedFormat(const DirectX::ScratchImage& src, float max_mse, DirectX::TEX_COMPRESS_FLAGS flags, float threshold);
+
+	/* rough size after a general purpose LZ compressor, in bits per texel over all subresources */
+	double EstimateBitsPerTexel(const DirectX::ScratchImage& img);
+}
@@ -0,0 +1,197 @@
+#include <cstring>
+
+#include "dxtmex_ddsstream.hpp"
+#include "dxtmex_mexerror.hpp"
+
+using namespace DXTMEX;
+
+namespace
+{
+	/* on-disk DDS structures, see the DDS programming guide */
+	constexpr uint32_t DDS_MAGIC                = 0x20534444; /* "DDS " */
+
+	constexpr uint32_t DDSD_CAPS                = 0x00000001;
+	constexpr uint32_t DDSD_HEIGHT              = 0x00000002;
+	constexpr uint32_t DDSD_WIDTH               = 0x00000004;
+	constexpr uint32_t DDSD_PITCH               = 0x00000008;
+	constexpr uint32_t DDSD_PIXELFORMAT         = 0x00001000;
+	constexpr uint32_t DDSD_MIPMAPCOUNT         = 0x00020000;
+	constexpr uint32_t DDSD_LINEARSIZE          = 0x00080000;
+
+	constexpr uint32_t DDPF_FOURCC              = 0x00000004;
+	constexpr uint32_t DDSCAPS_TEXTURE          = 0x00001000;
+
+	constexpr uint32_t DDS_DIMENSION_TEXTURE2D  = 3;
+
+	constexpr uint32_t MakeFourCC(char c0, char c1, char c2, char c3)
+	{
+		return (uint32_t)(uint8_t)c0 | ((uint32_t)(uint8_t)c1 << 8u) | ((uint32_t)(uint8_t)c2 << 16u) | ((uint32_t)(uint8_t)c3 << 24u);
+	}
+
+#pragma pack(push, 1)
+	struct DDSPixelFormat
+	{
+		uint32_t size;
+		uint32_t flags;
+		uint32_t fourcc;
+		uint32_t rgb_bit_count;
+		uint32_t r_bit_mask;
+		uint32_t g_bit_mask;
+		uint32_t b_bit_mask;
+		uint32_t a_bit_mask;
+	};
+
+	struct DDSHeader
+	{
+		uint32_t       size;
+		uint32_t       flags;
+		uint32_t       height;
+		uint32_t       width;
+		uint32_t       pitch_or_linear_size;
+		uint32_t       depth;
+		uint32_t       mipmap_count;
+		uint32_t       reserved1[11];
+		DDSPixelFormat ddspf;
+		uint32_t       caps;
+		uint32_t       caps2;
+		uint32_t       caps3;
+		uint32_t       caps4;
+		uint32_t       reserved2;
+	};
+
+	struct DDSHeaderDXT10
+	{
+		uint32_t dxgi_format;
+		uint32_t resource_dimension;
+		uint32_t misc_flag;
+		uint32_t array_size;
+		uint32_t misc_flags2;
+	};
+#pragma pack(pop)
+}
+
+constexpr size_t DDSStreamWriter::BAND_HEIGHT;
+
+DDSStreamWriter::DDSStreamWriter(const std::wstring& filename, const DirectX::TexMetadata& metadata, DirectX::DDS_FLAGS flags) :
+	_metadata(metadata),
+	_rows_written(0)
+{
+	if(metadata.dimension != DirectX::TEX_DIMENSION_TEXTURE2D || metadata.arraySize != 1 || metadata.mipLevels != 1 || metadata.depth != 1 || metadata.IsCubemap())
+	{
+		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "StreamingError", "Streaming output is only supported for single 2D images without mipmaps.");
+	}
+
+	if(DirectX::IsPlanar(metadata.format) || DirectX::IsPalettized(metadata.format) || DirectX::IsVideo(metadata.format))
+	{
+		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "StreamingError", "Streaming output does not support planar, palettized, or video formats.");
+	}
+
+	this->_file.open(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+	if(!this->_file.is_open())
+	{
+		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_SYSTEM, "FileOpenError", "Could not open the output file for writing.");
+	}
+
+	this->WriteHeader(flags);
+}
+
+void DDSStreamWriter::WriteHeader(DirectX::DDS_FLAGS flags)
+{
+	size_t row_pitch, slice_pitch;
+	DirectX::ComputePitch(this->_metadata.format, this->_metadata.width, this->_metadata.height, row_pitch, slice_pitch);
+
+	DDSHeader header = {};
+	header.size = sizeof(DDSHeader);
+	header.flags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT;
+	header.height = (uint32_t)this->_metadata.height;
+	header.width = (uint32_t)this->_metadata.width;
+	header.mipmap_count = 1;
+	header.caps = DDSCAPS_TEXTURE;
+	header.ddspf.size = sizeof(DDSPixelFormat);
+	header.ddspf.flags = DDPF_FOURCC;
+
+	if(DirectX::IsCompressed(this->_metadata.format))
+	{
+		header.flags |= DDSD_LINEARSIZE;
+		header.pitch_or_linear_size = (uint32_t)slice_pitch;
+	}
+	else
+	{
+		header.flags |= DDSD_PITCH;
+		header.pitch_or_linear_size = (uint32_t)row_pitch;
+	}
+
+	/* keep the legacy FourCC codes for the formats older readers expect */
+	bool use_dx10 = (flags & DirectX::DDS_FLAGS_FORCE_DX10_EXT) != 0 || this->_metadata.GetAlphaMode() != DirectX::TEX_ALPHA_MODE_UNKNOWN;
+	if(!use_dx10)
+	{
+		switch(this->_metadata.format)
+		{
+			case DXGI_FORMAT_BC1_UNORM: header.ddspf.fourcc = MakeFourCC('D', 'X', 'T', '1'); break;
+			case DXGI_FORMAT_BC2_UNORM: header.ddspf.fourcc = MakeFourCC('D', 'X', 'T', '3'); break;
+			case DXGI_FORMAT_BC3_UNORM: header.ddspf.fourcc = MakeFourCC('D', 'X', 'T', '5'); break;
+			case DXGI_FORMAT_BC4_UNORM: header.ddspf.fourcc = MakeFourCC('B', 'C', '4', 'U'); break;
+			case DXGI_FORMAT_BC5_UNORM: header.ddspf.fourcc = MakeFourCC('B', 'C', '5', 'U'); break;
+			default:                    use_dx10 = true; break;
+		}
+	}
+
+	const uint32_t magic = DDS_MAGIC;
+	this->Write(&magic, sizeof(magic));
+
+	if(use_dx10)
+	{
+		header.ddspf.fourcc = MakeFourCC('D', 'X', '1', '0');
+		this->Write(&header, sizeof(header));
+
+		DDSHeaderDXT10 header_dxt10 = {};
+		header_dxt10.dxgi_format = (uint32_t)this->_metadata.format;
+		header_dxt10.resource_dimension = DDS_DIMENSION_TEXTURE2D;
+		header_dxt10.array_size = 1;
+		header_dxt10.misc_flags2 = (uint32_t)this->_metadata.GetAlphaMode();
+		this->Write(&header_dxt10, sizeof(header_dxt10));
+	}
+	else
+	{
+		this->Write(&header, sizeof(header));
+	}
+}
+
+void DDSStreamWriter::Append(const DirectX::Image& band)
+{
+	if(band.format != this->_metadata.format || band.width != this->_metadata.width)
+	{
+		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_INTERNAL, "StreamingError", "The band did not match the format or width of the output.");
+	}
+
+	if(this->_rows_written + band.height > this->_metadata.height)
+	{
+		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_INTERNAL, "StreamingError", "Too many rows were appended to the output.");
+	}
+
+	/* compressed bands are a single row of blocks */
+	this->Write(band.pixels, band.rowPitch * DirectX::ComputeScanlines(band.format, band.height));
+	this->_rows_written += band.height;
+}
+
+void DDSStreamWriter::Finish()
+{
+	if(this->_rows_written != this->_metadata.height)
+	{
+		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_INTERNAL, "StreamingError", "The output was closed after %llu of %llu rows.", this->_rows_written, this->_metadata.height);
+	}
+	this->_file.close();
+	if(this->_file.fail())
+	{
+		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_SYSTEM, "FileWriteError", "There was an error while closing the output file.");
+	}
+}
+
+void DDSStreamWriter::Write(const void* data, size_t size)
+{
+	this->_file.write(reinterpret_cast<const char*>(data), size);
+	if(this->_file.fail())
+	{
+		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_SYSTEM, "FileWriteError", "There was an error while writing to the output file.");
+	}
+}
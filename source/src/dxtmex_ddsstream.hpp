@@ -0,0 +1,34 @@
+#pragma once
+
+#include <fstream>
+#include <string>
+
+#include "mex.h"
+#include "DirectXTex.h"
+
+namespace DXTMEX
+{
+	/* writes a single 2D DDS surface one band of rows at a time */
+	class DDSStreamWriter
+	{
+	public:
+		DDSStreamWriter(const std::wstring& filename, const DirectX::TexMetadata& metadata, DirectX::DDS_FLAGS flags);
+
+		/* bands must be in the output format, span the full width, and be appended top to bottom */
+		void Append(const DirectX::Image& band);
+		void Finish();
+
+		size_t GetRowsWritten() {return _rows_written;}
+
+		/* rows per band, one block row for compressed formats */
+		static constexpr size_t BAND_HEIGHT = 4;
+
+	private:
+		std::ofstream         _file;
+		DirectX::TexMetadata  _metadata;
+		size_t                _rows_written;
+
+		void WriteHeader(DirectX::DDS_FLAGS flags);
+		void Write(const void* data, size_t size);
+	};
+}
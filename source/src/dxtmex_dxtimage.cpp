@@ -1,11 +1,18 @@
 #include "mex.h"
 #include <string>
+#include <cstring>
 #include "dxtmex_dxtimagearray.hpp"
 #include "dxtmex_mexerror.hpp"
 #include "dxtmex_mexutils.hpp"
 #include "dxtmex_maps.hpp"
 #include "dxtmex_flags.hpp"
 #include "dxtmex_pixel.hpp"
+#include "dxtmex_ddsstream.hpp"
+#include "dxtmex_parallel.hpp"
+#include "dxtmex_simd.hpp"
+#include "dxtmex_trace.hpp"
+
+#include <DirectXPackedVector.h>
 
 using namespace DXTMEX;
 
@@ -343,11 +350,11 @@ void DXTImage::PrepareImages(DXTImage & out)
 	}
 }
 
-void DXTImage::ToImage(mxArray * &mx_dxtimage_rgb, bool combine_alpha)
+void DXTImage::ToImage(mxArray * &mx_dxtimage_rgb, bool combine_alpha, mxArray* mx_target)
 {
 	DXTImage prepared_images;
 	this->PrepareImages(prepared_images);
-	prepared_images.ToImageMatrix(mx_dxtimage_rgb, combine_alpha);
+	prepared_images.ToImageMatrix(mx_dxtimage_rgb, combine_alpha, mx_target);
 }
 
 void DXTImage::ToImage(mxArray * &mx_dxtimage_rgb, mxArray * &mx_dxtimage_a)
@@ -357,12 +364,13 @@ void DXTImage::ToImage(mxArray * &mx_dxtimage_rgb, mxArray * &mx_dxtimage_a)
 	prepared_images.ToImageMatrix(mx_dxtimage_rgb, mx_dxtimage_a);
 }
 
-void DXTImage::ToImageMatrix(mxArray * &mx_dxtimage_rgb, bool combine_alpha)
+void DXTImage::ToImageMatrix(mxArray * &mx_dxtimage_rgb, bool combine_alpha, mxArray* mx_target)
 {
 	size_t i, j, k;
 	if(this->GetImageCount() == 1)
 	{
 		DXGIPixel matrix_constructor(this->GetMetadata().format, this->GetImage(0, 0, 0));
+		matrix_constructor.SetOutput(mx_target);
 		if(combine_alpha)
 		{
 			matrix_constructor.ExtractRGBA(mx_dxtimage_rgb);
@@ -440,12 +448,14 @@ void DXTImage::ToImageMatrix(mxArray * &mx_dxtimage_rgb, mxArray * &mx_dxtimage_
 }
 
 
-void DXTImage::ToMatrix(mxArray * &mx_dxtimage_out)
+void DXTImage::ToMatrix(mxArray * &mx_dxtimage_out, mxArray* mx_target, MEXToDXT::LAYOUT layout)
 {
 	size_t i, j, k;
 	if(this->GetImageCount() == 1)
 	{
 		DXGIPixel matrix_constructor(this->GetMetadata().format, this->GetImage(0, 0, 0));
+		matrix_constructor.SetOutput(mx_target);
+		matrix_constructor.SetInterleaved(layout == MEXToDXT::LAYOUT::INTERLEAVED);
 		matrix_constructor.ExtractAll(mx_dxtimage_out);
 	}
 	else
@@ -461,6 +471,7 @@ void DXTImage::ToMatrix(mxArray * &mx_dxtimage_out)
 				for(k = 0; k < depth; k++)
 				{
 					DXGIPixel matrix_constructor(metadata.format, this->GetImage(i, j, k));
+					matrix_constructor.SetInterleaved(layout == MEXToDXT::LAYOUT::INTERLEAVED);
 					matrix_constructor.ExtractAll(tmp_out);
 					mxSetCell(mx_dxtimage_out, this->ComputeIndexMEX(i, j, k), tmp_out);
 				}
@@ -488,6 +499,7 @@ void DXTImage::WriteHDR(const std::wstring & filename, std::wstring & ext, bool
 				for(k = 0; k < depth; k++)
 				{
 					std::wstring out_fn = filename + std::to_wstring(i).append(std::to_wstring(j)).append(std::to_wstring(k)).append(ext);
+					Trace::Scope trace_scope("DirectX::SaveToHDRFile", "file");
 					hres = DirectX::SaveToHDRFile(*this->GetImage(i, j, k), out_fn.c_str());
 					if(FAILED(hres))
 					{
@@ -504,6 +516,7 @@ void DXTImage::WriteHDR(const std::wstring & filename, std::wstring & ext, bool
 	else
 	{
 		std::wstring out_fn = filename + ext;
+		Trace::Scope trace_scope("DirectX::SaveToHDRFile", "file");
 		hres = DirectX::SaveToHDRFile(*this->GetImage(0, 0, 0), out_fn.c_str());
 		if(FAILED(hres))
 		{
@@ -514,6 +527,7 @@ void DXTImage::WriteHDR(const std::wstring & filename, std::wstring & ext, bool
 
 void DXTImage::WriteHDR(const std::wstring & filename, size_t mip, size_t item, size_t slice)
 {
+	Trace::Scope trace_scope("DirectX::SaveToHDRFile", "file");
 	hres = DirectX::SaveToHDRFile(*this->GetImage(mip, item, slice), filename.c_str());
 	if(FAILED(hres))
 	{
@@ -535,6 +549,7 @@ void DXTImage::WriteTGA(const std::wstring & filename, std::wstring & ext, bool
 				for(k = 0; k < depth; k++)
 				{
 					std::wstring out_fn = filename + std::to_wstring(i).append(std::to_wstring(j)).append(std::to_wstring(k)).append(ext);
+					Trace::Scope trace_scope("DirectX::SaveToTGAFile", "file");
 					hres = DirectX::SaveToTGAFile(*this->GetImage(i, j, k), out_fn.c_str());
 					if(FAILED(hres))
 					{
@@ -551,6 +566,7 @@ void DXTImage::WriteTGA(const std::wstring & filename, std::wstring & ext, bool
 	else
 	{
 		std::wstring out_fn = filename + ext;
+		Trace::Scope trace_scope("DirectX::SaveToTGAFile", "file");
 		hres = DirectX::SaveToTGAFile(*this->GetImage(0, 0, 0), out_fn.c_str());
 		if(FAILED(hres))
 		{
@@ -561,6 +577,7 @@ void DXTImage::WriteTGA(const std::wstring & filename, std::wstring & ext, bool
 
 void DXTImage::WriteTGA(const std::wstring & filename, size_t mip, size_t item, size_t slice)
 {
+	Trace::Scope trace_scope("DirectX::SaveToTGAFile", "file");
 	hres = DirectX::SaveToTGAFile(*this->GetImage(mip, item, slice), filename.c_str());
 	if(FAILED(hres))
 	{
@@ -572,7 +589,9 @@ DirectX::TexMetadata
 MEXToDXT::DeriveMetadata(const mxArray * data_in,
 	COLORSPACE input_colorspace,
 	DirectX::TEX_ALPHA_MODE alpha_mode,
-	bool is_cubemap)
+	bool is_cubemap,
+	LAYOUT layout,
+	INTERMEDIATE intermediate)
 {
 	mxClassID class_id = mxGetClassID(data_in);
 	mwSize num_dims = mxGetNumberOfDimensions(data_in);
@@ -595,7 +614,7 @@ MEXToDXT::DeriveMetadata(const mxArray * data_in,
 				"Cell array contents must be numeric or logical");
 		}
 
-		DirectX::TexMetadata metadata = DeriveMetadata(mxGetCell(data_in, 0), input_colorspace, alpha_mode, is_cubemap);
+		DirectX::TexMetadata metadata = DeriveMetadata(mxGetCell(data_in, 0), input_colorspace, alpha_mode, is_cubemap, layout, intermediate);
 
 		if(num_dims != 2)
 		{
@@ -607,6 +626,14 @@ MEXToDXT::DeriveMetadata(const mxArray * data_in,
 
 		metadata.arraySize = dims[0];
 		metadata.mipLevels = dims[1];
+
+		if(metadata.dimension == DirectX::TEX_DIMENSION_TEXTURE3D && metadata.arraySize != 1)
+		{
+			MEXError::PrintMexError(MEU_FL,
+				MEU_SEVERITY_USER,
+				"InvalidImportError",
+				"Volume textures cannot be arrays. Use a 1xN cell array for volume mipmaps.");
+		}
 		return metadata;
 	}
 	else
@@ -683,6 +710,14 @@ MEXToDXT::DeriveMetadata(const mxArray * data_in,
 			}
 		}
 
+		if(layout == LAYOUT::INTERLEAVED && num_dims > 1)
+		{
+			/* channels come first, then width and height */
+			num_channels = dims[0];
+			metadata.width = dims[1];
+			metadata.height = (num_dims > 2)? dims[2] : 1;
+		}
+
 		/* now need to get the intermediate format */
 
 		if(num_channels < 1 || 4 < num_channels)
@@ -690,7 +725,7 @@ MEXToDXT::DeriveMetadata(const mxArray * data_in,
 			MEXError::PrintMexError(MEU_FL,
 				MEU_SEVERITY_USER,
 				"InvalidImportError",
-				"The size of the third dimension must be between 1 and 4.");
+				"The number of channels must be between 1 and 4.");
 		}
 
 		switch(class_id)
@@ -713,10 +748,25 @@ MEXToDXT::DeriveMetadata(const mxArray * data_in,
 				}
 				break;
 			}
+			case mxDOUBLE_CLASS:
+			case mxSINGLE_CLASS:
+			{
+				if(intermediate == INTERMEDIATE::HALF)
+				{
+					switch(num_channels)
+					{
+						case 1:  metadata.format = DXGI_FORMAT_R16_FLOAT; break;
+						case 2:  metadata.format = DXGI_FORMAT_R16G16_FLOAT; break;
+						case 3:  /* NEEDS ALPHA */
+						case 4:
+						default: metadata.format = DXGI_FORMAT_R16G16B16A16_FLOAT; break;
+					}
+					break;
+				}
+			}
+			/* fallthrough */
 			case mxINT32_CLASS:  /* convert to unsigned */
 			case mxUINT32_CLASS:
-			case mxDOUBLE_CLASS: /* narrowing */
-			case mxSINGLE_CLASS:
 			{
 				switch(num_channels)
 				{
@@ -794,16 +844,19 @@ MEXToDXT::ConvertToOutput(DXGI_FORMAT fmt_out,
 	COLORSPACE input_colorspace,
 	DirectX::TEX_ALPHA_MODE alpha_mode,
 	bool is_cubemap,
-	DirectX::CP_FLAGS cp_flags)
+	DirectX::CP_FLAGS cp_flags,
+	LAYOUT layout,
+	INTERMEDIATE intermediate)
 {
+	intermediate = ResolveIntermediate(intermediate, fmt_out);
 	if(fmt_out == DXGI_FORMAT_UNKNOWN)
 	{
-		ConvertToIntermediate(scimg_out, data_in, input_colorspace, alpha_mode, is_cubemap, cp_flags);
+		ConvertToIntermediate(scimg_out, data_in, input_colorspace, alpha_mode, is_cubemap, cp_flags, layout, intermediate);
 	}
 	else
 	{
 		DirectX::ScratchImage tmp;
-		ConvertToIntermediate(tmp, data_in, input_colorspace, alpha_mode, is_cubemap, cp_flags);
+		ConvertToIntermediate(tmp, data_in, input_colorspace, alpha_mode, is_cubemap, cp_flags, layout, intermediate);
 		hres = DirectX::Convert(tmp.GetImages(), tmp.GetImageCount(), tmp.GetMetadata(), fmt_out, filter_flags, threshold, scimg_out);
 		if(FAILED(hres))
 		{
@@ -819,7 +872,9 @@ MEXToDXT::ConvertToIntermediate(DirectX::ScratchImage& scimg_out,
                                 COLORSPACE input_colorspace,
                                 DirectX::TEX_ALPHA_MODE alpha_mode,
                                 bool is_cubemap,
-                                DirectX::CP_FLAGS flags)
+                                DirectX::CP_FLAGS flags,
+                                LAYOUT layout,
+                                INTERMEDIATE intermediate)
 {
 
 	/* options:
@@ -851,6 +906,10 @@ MEXToDXT::ConvertToIntermediate(DirectX::ScratchImage& scimg_out,
 	 *
 	 * mxSingle => DXGI_FORMAT_R32G32B32A32_FLOAT
 	 * mxDouble => DXGI_FORMAT_R32G32B32A32_FLOAT (loss of precision)
+	 *
+	 * with a half intermediate:
+	 * mxSingle => DXGI_FORMAT_R16G16B16A16_FLOAT
+	 * mxDouble => DXGI_FORMAT_R16G16B16A16_FLOAT
 	 */
 
 	 /*
@@ -861,13 +920,16 @@ MEXToDXT::ConvertToIntermediate(DirectX::ScratchImage& scimg_out,
 	  * should support any combination of the three and let DirectXTex decide if the input is ok
 	  */
 
-	const DirectX::TexMetadata metadata = DeriveMetadata(data_in, input_colorspace, alpha_mode, is_cubemap);
+	const DirectX::TexMetadata metadata = DeriveMetadata(data_in, input_colorspace, alpha_mode, is_cubemap, layout, intermediate);
 	hres = scimg_out.Initialize(metadata, flags);
 	if(FAILED(hres))
 	{
 		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_HRESULT, "InitializationError", "There was an error while saving initializing the image.");
 	}
 
+	/* validate everything and gather the slices here, since the MATLAB API may only be used on this thread */
+	std::vector<ConversionJob> jobs;
+	jobs.reserve(scimg_out.GetImageCount());
 	if(mxIsCell(data_in))
 	{
 		const mwSize* dims = mxGetDimensions(data_in);
@@ -887,7 +949,7 @@ MEXToDXT::ConvertToIntermediate(DirectX::ScratchImage& scimg_out,
 						"Input cell array is incorrectly sized.");
 				}
 
-				DoConversion(const_cast<DirectX::Image*>(scimg_out.GetImage(i, j, 0)), cell_data, depth, input_colorspace);
+				PrepareConversion(jobs, const_cast<DirectX::Image*>(scimg_out.GetImage(i, j, 0)), cell_data, depth, input_colorspace, layout, intermediate);
 
 			}
 			if(depth > 1)
@@ -898,32 +960,60 @@ MEXToDXT::ConvertToIntermediate(DirectX::ScratchImage& scimg_out,
 	}
 	else
 	{
-		DoConversion(const_cast<DirectX::Image*>(scimg_out.GetImage(0, 0, 0)), data_in, 1, input_colorspace);
+		PrepareConversion(jobs, const_cast<DirectX::Image*>(scimg_out.GetImage(0, 0, 0)), data_in, metadata.depth, input_colorspace, layout, intermediate);
 	}
 
-	/* now make sure our data is correctly sized */
+	/* each job writes a distinct subresource */
+	Parallel::For(jobs.size(), [&jobs](size_t i)
+	{
+		RunConversion(jobs[i]);
+	});
+}
 
+/* planar input which only has to be reordered into the image goes through the transpose kernels.
+ * output elements past the input channels are set to fill */
+template <typename T>
+static bool InsertPlanar(const uint8_t* in_data, DirectX::Image* out_img, MEXToDXT::LAYOUT layout, int num_in_channels, int num_out_channels, T fill)
+{
+	if(layout != MEXToDXT::LAYOUT::PLANAR || DirectX::BitsPerPixel(out_img->format) != num_out_channels * sizeof(T) * 8)
+	{
+		return false;
+	}
+	const uint8_t* planes[MAX_CHANNELS] = {nullptr};
+	for(int j = 0; j < num_in_channels; j++)
+	{
+		planes[j] = in_data + j * out_img->width * out_img->height * sizeof(T);
+	}
+	SIMD::InsertPlanar(planes, reinterpret_cast<const uint8_t*>(&fill), out_img->width, out_img->height, num_out_channels, sizeof(T), out_img->pixels, out_img->rowPitch);
+	return true;
 }
 
 template <typename MX_TYPE, typename DXT_TYPE, int NCHANNELS>
 struct MEXToDXT::Converter<MX_TYPE, DXT_TYPE, NCHANNELS, MEXToDXT::COLORSPACE::LINEAR>
 {
-	static void ToIntermediate(uint8_t* in_data, DirectX::Image* out_img)
+	static void ToIntermediate(uint8_t* in_data, DirectX::Image* out_img, LAYOUT layout)
 	{
+		if(std::is_same<MX_TYPE, DXT_TYPE>::value && InsertPlanar<DXT_TYPE>(in_data, out_img, layout, NCHANNELS, NCHANNELS, DXT_TYPE()))
+		{
+			return; // EARLY RETURN
+		}
+
 		/* direct copy to image */
 		auto in_ptr = reinterpret_cast<MX_TYPE*>(in_data);
 		auto out_ptr = reinterpret_cast<DXT_TYPE*>(out_img->pixels);
 		size_t num_pixels = out_img->height * out_img->width;
-		for(size_t src_idx = 0, dst_idx = 0; dst_idx < num_pixels; dst_idx++, src_idx += out_img->height)
+		const size_t pixel_stride = (layout == LAYOUT::INTERLEAVED)? NCHANNELS : out_img->height;
+		const size_t channel_stride = (layout == LAYOUT::INTERLEAVED)? 1 : num_pixels;
+		for(size_t src_idx = 0, dst_idx = 0; dst_idx < num_pixels; dst_idx++, src_idx += pixel_stride)
 		{
-			if(src_idx >= num_pixels)
+			if(layout == LAYOUT::PLANAR && src_idx >= num_pixels)
 			{
 				src_idx = dst_idx / out_img->width;
 			}
 
 			for(int j = 0; j < NCHANNELS; j++)
 			{
-				out_ptr[(dst_idx * NCHANNELS) + j] = static_cast<DXT_TYPE>(in_ptr[src_idx + (j * num_pixels)]);
+				out_ptr[(dst_idx * NCHANNELS) + j] = static_cast<DXT_TYPE>(in_ptr[src_idx + (j * channel_stride)]);
 			}
 		}
 	}
@@ -933,21 +1023,23 @@ struct MEXToDXT::Converter<MX_TYPE, DXT_TYPE, NCHANNELS, MEXToDXT::COLORSPACE::L
 template <typename MX_TYPE>
 struct MEXToDXT::Converter<MX_TYPE, uint16_t, 3, MEXToDXT::COLORSPACE::LINEAR>
 {
-	static void ToIntermediate(uint8_t* in_data, DirectX::Image* out_img)
+	static void ToIntermediate(uint8_t* in_data, DirectX::Image* out_img, LAYOUT layout)
 	{
 		/* direct copy to image */
 		auto in_ptr = reinterpret_cast<MX_TYPE*>(in_data);
 		auto out_ptr = reinterpret_cast<uint16_t*>(out_img->pixels);
 		size_t num_pixels = out_img->height * out_img->width;
-		for(size_t src_idx = 0, dst_idx = 0; dst_idx < num_pixels; dst_idx++, src_idx += out_img->height)
+		const size_t pixel_stride = (layout == LAYOUT::INTERLEAVED)? 3 : out_img->height;
+		const size_t channel_stride = (layout == LAYOUT::INTERLEAVED)? 1 : num_pixels;
+		for(size_t src_idx = 0, dst_idx = 0; dst_idx < num_pixels; dst_idx++, src_idx += pixel_stride)
 		{
-			if(src_idx >= num_pixels)
+			if(layout == LAYOUT::PLANAR && src_idx >= num_pixels)
 			{
 				src_idx = dst_idx / out_img->width;
 			}
 			for(int j = 0; j < 3; j++)
 			{
-				out_ptr[(dst_idx * 4) + j] = static_cast<uint16_t>(static_cast<int32_t>(in_ptr[src_idx + (j * num_pixels)]) - std::numeric_limits<int32_t>::min());
+				out_ptr[(dst_idx * 4) + j] = static_cast<uint16_t>(static_cast<int32_t>(in_ptr[src_idx + (j * channel_stride)]) - std::numeric_limits<int32_t>::min());
 			}
 			out_ptr[(dst_idx * 4) + 3] = std::numeric_limits<uint16_t>::max(); /* set missing alpha */
 		}
@@ -958,22 +1050,24 @@ struct MEXToDXT::Converter<MX_TYPE, uint16_t, 3, MEXToDXT::COLORSPACE::LINEAR>
 template <typename MX_TYPE, int NCHANNELS>
 struct MEXToDXT::Converter<MX_TYPE, float, NCHANNELS, MEXToDXT::COLORSPACE::LINEAR>
 {
-	static void ToIntermediate(uint8_t* in_data, DirectX::Image* out_img)
+	static void ToIntermediate(uint8_t* in_data, DirectX::Image* out_img, LAYOUT layout)
 	{
 		/* covert to float then to output format */
 		auto in_ptr = reinterpret_cast<MX_TYPE*>(in_data);
 		auto out_ptr = reinterpret_cast<float*>(out_img->pixels);
 		const size_t num_pixels = out_img->height * out_img->width;
-		for(size_t src_idx = 0, dst_idx = 0; dst_idx < num_pixels; dst_idx++, src_idx += out_img->height)
+		const size_t pixel_stride = (layout == LAYOUT::INTERLEAVED)? NCHANNELS : out_img->height;
+		const size_t channel_stride = (layout == LAYOUT::INTERLEAVED)? 1 : num_pixels;
+		for(size_t src_idx = 0, dst_idx = 0; dst_idx < num_pixels; dst_idx++, src_idx += pixel_stride)
 		{
-			if(src_idx >= num_pixels)
+			if(layout == LAYOUT::PLANAR && src_idx >= num_pixels)
 			{
 				src_idx = dst_idx / out_img->width;
 			}
 
 			for(int j = 0; j < NCHANNELS; j++)
 			{
-				out_ptr[(dst_idx * NCHANNELS) + j] = static_cast<float>(in_ptr[src_idx + (j * num_pixels)]);
+				out_ptr[(dst_idx * NCHANNELS) + j] = static_cast<float>(in_ptr[src_idx + (j * channel_stride)]);
 			}
 		}
 	}
@@ -983,22 +1077,24 @@ struct MEXToDXT::Converter<MX_TYPE, float, NCHANNELS, MEXToDXT::COLORSPACE::LINE
 template <typename MX_TYPE, typename DXT_TYPE, int NCHANNELS>
 struct MEXToDXT::Converter<MX_TYPE, DXT_TYPE, NCHANNELS, MEXToDXT::COLORSPACE::SRGB>
 {
-	static void ToIntermediate(uint8_t* in_data, DirectX::Image* out_img)
+	static void ToIntermediate(uint8_t* in_data, DirectX::Image* out_img, LAYOUT layout)
 	{
 		/* covert to float then to output format */
 		auto in_ptr = reinterpret_cast<MX_TYPE*>(in_data);
 		auto out_ptr = reinterpret_cast<DXT_TYPE*>(out_img->pixels);
 		const size_t num_pixels = out_img->height * out_img->width;
-		for(size_t src_idx = 0, dst_idx = 0; dst_idx < num_pixels; dst_idx++, src_idx += out_img->height)
+		const size_t pixel_stride = (layout == LAYOUT::INTERLEAVED)? NCHANNELS : out_img->height;
+		const size_t channel_stride = (layout == LAYOUT::INTERLEAVED)? 1 : num_pixels;
+		for(size_t src_idx = 0, dst_idx = 0; dst_idx < num_pixels; dst_idx++, src_idx += pixel_stride)
 		{
-			if(src_idx >= num_pixels)
+			if(layout == LAYOUT::PLANAR && src_idx >= num_pixels)
 			{
 				src_idx = dst_idx / out_img->width;
 			}
 
 			for(int j = 0; j < NCHANNELS; j++)
 			{
-				float c = DXGIPixel::SRGBToLinearFloat(in_ptr[src_idx + (j * num_pixels)]);
+				float c = DXGIPixel::SRGBToLinearFloat(in_ptr[src_idx + (j * channel_stride)]);
 				out_ptr[(dst_idx * NCHANNELS) + j] = DXGIPixel::LinearFloatToUNORM<DXT_TYPE>(c);
 			}
 		}
@@ -1009,19 +1105,26 @@ struct MEXToDXT::Converter<MX_TYPE, DXT_TYPE, NCHANNELS, MEXToDXT::COLORSPACE::S
 template <int NCHANNELS>
 struct MEXToDXT::Converter<mxUint8, uint8_t, NCHANNELS, MEXToDXT::COLORSPACE::SRGB>
 {
-	static void ToIntermediate(uint8_t* in_data, DirectX::Image* out_img)
+	static void ToIntermediate(uint8_t* in_data, DirectX::Image* out_img, LAYOUT layout)
 	{
+		if(InsertPlanar<uint8_t>(in_data, out_img, layout, NCHANNELS, NCHANNELS, 0))
+		{
+			return; // EARLY RETURN
+		}
+
 		/* copy to DXGI_FORMAT_R8G8B8A8_SRGB */
 		size_t num_pixels = out_img->height * out_img->width;
-		for(size_t src_idx = 0, dst_idx = 0; dst_idx < num_pixels; dst_idx++, src_idx += out_img->height)
+		const size_t pixel_stride = (layout == LAYOUT::INTERLEAVED)? NCHANNELS : out_img->height;
+		const size_t channel_stride = (layout == LAYOUT::INTERLEAVED)? 1 : num_pixels;
+		for(size_t src_idx = 0, dst_idx = 0; dst_idx < num_pixels; dst_idx++, src_idx += pixel_stride)
 		{
-			if(src_idx >= num_pixels)
+			if(layout == LAYOUT::PLANAR && src_idx >= num_pixels)
 			{
 				src_idx = dst_idx / out_img->width;
 			}
 			for(int j = 0; j < NCHANNELS; j++)
 			{
-				out_img->pixels[(dst_idx * NCHANNELS) + j] = in_data[src_idx + (j * num_pixels)];
+				out_img->pixels[(dst_idx * NCHANNELS) + j] = in_data[src_idx + (j * channel_stride)];
 			}
 		}
 	}
@@ -1031,19 +1134,27 @@ struct MEXToDXT::Converter<mxUint8, uint8_t, NCHANNELS, MEXToDXT::COLORSPACE::SR
 template <>
 struct MEXToDXT::Converter<mxUint8, uint8_t, 3, MEXToDXT::COLORSPACE::SRGB>
 {
-	static void ToIntermediate(uint8_t* in_data, DirectX::Image* out_img)
+	static void ToIntermediate(uint8_t* in_data, DirectX::Image* out_img, LAYOUT layout)
 	{
+		/* set missing alpha */
+		if(InsertPlanar<uint8_t>(in_data, out_img, layout, 3, 4, std::numeric_limits<uint8_t>::max()))
+		{
+			return; // EARLY RETURN
+		}
+
 		/* copy to DXGI_FORMAT_R8G8B8A8_SRGB */
 		size_t num_pixels = out_img->height * out_img->width;
-		for(size_t src_idx = 0, dst_idx = 0; dst_idx < num_pixels; dst_idx++, src_idx += out_img->height)
+		const size_t pixel_stride = (layout == LAYOUT::INTERLEAVED)? 3 : out_img->height;
+		const size_t channel_stride = (layout == LAYOUT::INTERLEAVED)? 1 : num_pixels;
+		for(size_t src_idx = 0, dst_idx = 0; dst_idx < num_pixels; dst_idx++, src_idx += pixel_stride)
 		{
-			if(src_idx >= num_pixels)
+			if(layout == LAYOUT::PLANAR && src_idx >= num_pixels)
 			{
 				src_idx = dst_idx / out_img->width;
 			}
 			for(int j = 0; j < 3; j++)
 			{
-				out_img->pixels[(dst_idx * 4) + j] = in_data[src_idx + (j * num_pixels)];
+				out_img->pixels[(dst_idx * 4) + j] = in_data[src_idx + (j * channel_stride)];
 			}
 			out_img->pixels[(dst_idx * 4) + 3] = std::numeric_limits<uint8_t>::max(); /* set missing alpha */
 		}
@@ -1055,22 +1166,24 @@ template <int NCHANNELS>
 struct MEXToDXT::Converter<mxInt8, uint8_t, NCHANNELS, MEXToDXT::COLORSPACE::SRGB>
 {
 	/* nearly direct conversion---just shift everything over by 0x80 */
-	static void ToIntermediate(uint8_t* in_data, DirectX::Image* out_img)
+	static void ToIntermediate(uint8_t* in_data, DirectX::Image* out_img, LAYOUT layout)
 	{
 		auto in_ptr = reinterpret_cast<mxInt8*>(in_data);
 		auto out_ptr = reinterpret_cast<uint8_t*>(out_img->pixels);
 		/* copy to DXGI_FORMAT_R8G8B8A8_SRGB */
 		size_t num_pixels = out_img->height * out_img->width;
-		for(size_t src_idx = 0, dst_idx = 0; dst_idx < num_pixels; dst_idx++, src_idx += out_img->height)
+		const size_t pixel_stride = (layout == LAYOUT::INTERLEAVED)? NCHANNELS : out_img->height;
+		const size_t channel_stride = (layout == LAYOUT::INTERLEAVED)? 1 : num_pixels;
+		for(size_t src_idx = 0, dst_idx = 0; dst_idx < num_pixels; dst_idx++, src_idx += pixel_stride)
 		{
-			if(src_idx >= num_pixels)
+			if(layout == LAYOUT::PLANAR && src_idx >= num_pixels)
 			{
 				src_idx = dst_idx / out_img->width;
 			}
 			for(int j = 0; j < NCHANNELS; j++)
 			{
 				out_ptr[(dst_idx * NCHANNELS) + j] = static_cast<uint8_T>(
-					static_cast<int16_t>(in_ptr[src_idx + (j * num_pixels)]) - static_cast<int16_t>(std::numeric_limits<mxInt8>::min())
+					static_cast<int16_t>(in_ptr[src_idx + (j * channel_stride)]) - static_cast<int16_t>(std::numeric_limits<mxInt8>::min())
 					);
 			}
 		}
@@ -1081,22 +1194,24 @@ struct MEXToDXT::Converter<mxInt8, uint8_t, NCHANNELS, MEXToDXT::COLORSPACE::SRG
 template <>
 struct MEXToDXT::Converter<mxInt8, uint8_t, 3, MEXToDXT::COLORSPACE::SRGB>
 {
-	static void ToIntermediate(uint8_t* in_data, DirectX::Image* out_img)
+	static void ToIntermediate(uint8_t* in_data, DirectX::Image* out_img, LAYOUT layout)
 	{
 		auto in_ptr = reinterpret_cast<mxInt8*>(in_data);
 		auto out_ptr = reinterpret_cast<uint8_t*>(out_img->pixels);
 		/* copy to DXGI_FORMAT_R8G8B8A8_SRGB */
 		size_t num_pixels = out_img->height * out_img->width;
-		for(size_t src_idx = 0, dst_idx = 0; dst_idx < num_pixels; dst_idx++, src_idx += out_img->height)
+		const size_t pixel_stride = (layout == LAYOUT::INTERLEAVED)? 3 : out_img->height;
+		const size_t channel_stride = (layout == LAYOUT::INTERLEAVED)? 1 : num_pixels;
+		for(size_t src_idx = 0, dst_idx = 0; dst_idx < num_pixels; dst_idx++, src_idx += pixel_stride)
 		{
-			if(src_idx >= num_pixels)
+			if(layout == LAYOUT::PLANAR && src_idx >= num_pixels)
 			{
 				src_idx = dst_idx / out_img->width;
 			}
 			for(int j = 0; j < 3; j++)
 			{
 				out_ptr[(dst_idx * 4) + j] = static_cast<uint8_T>(
-					static_cast<int16_t>(in_ptr[src_idx + (j * num_pixels)]) - static_cast<int16_t>(std::numeric_limits<mxInt8>::min())
+					static_cast<int16_t>(in_ptr[src_idx + (j * channel_stride)]) - static_cast<int16_t>(std::numeric_limits<mxInt8>::min())
 					);
 			}
 			out_img->pixels[(dst_idx * 4) + 3] = std::numeric_limits<uint8_t>::max(); /* set missing alpha */
@@ -1108,32 +1223,30 @@ struct MEXToDXT::Converter<mxInt8, uint8_t, 3, MEXToDXT::COLORSPACE::SRGB>
 template <>
 struct MEXToDXT::Converter<mxLogical, uint8_t, 1, MEXToDXT::COLORSPACE::SRGB>
 {
-	static void ToIntermediate(uint8_t* in_data, DirectX::Image* out_img)
+	static void ToIntermediate(uint8_t* in_data, DirectX::Image* out_img, LAYOUT layout)
 	{
 		auto in_ptr = reinterpret_cast<mxLogical*>(in_data);
 		auto out_ptr = reinterpret_cast<uint8_t*>(out_img->pixels);
 		/* copy to DXGI_FORMAT_R1_UNORM */
-		for(size_t col_idx = 0; col_idx < out_img->height; col_idx++)
+		const size_t x_stride = (layout == LAYOUT::INTERLEAVED)? 1 : out_img->height;
+		const size_t y_stride = (layout == LAYOUT::INTERLEAVED)? out_img->width : 1;
+		for(size_t y = 0; y < out_img->height; y++)
 		{
-			for(size_t row_idx = 0; row_idx < out_img->rowPitch - 1; row_idx++)
+			uint8_t* row = out_ptr + y * out_img->rowPitch;
+			for(size_t byte_idx = 0; byte_idx < out_img->rowPitch; byte_idx++)
 			{
 				uint8_t val = 0;
-				for(uint32_t bit_idx = 8; bit_idx > 0; bit_idx--)
+				for(uint32_t bit_idx = 0; bit_idx < 8; bit_idx++)
 				{
-					uint32_t mask = 1u << (bit_idx - 1);
-					/* cast to make sure we don't upcast to int */
-					val |= ((static_cast<uint32_t>(in_ptr[row_idx * out_img->height + col_idx] != 0) << (bit_idx - 1))) & mask;
+					size_t x = byte_idx * 8 + bit_idx;
+					if(x < out_img->width && in_ptr[x * x_stride + y * y_stride])
+					{
+						/* most significant bit is the leftmost pixel */
+						val |= static_cast<uint8_t>(0x80u >> bit_idx);
+					}
 				}
-				out_ptr[row_idx + col_idx * out_img->width] = val;
+				row[byte_idx] = val;
 			}
-			uint8_t val = 0;
-			for(uint32_t bit_idx = static_cast<uint32_t>(out_img->width - ((out_img->rowPitch - 1) * 8)); bit_idx > 0; bit_idx--)
-			{
-				uint32_t mask = 1u << (bit_idx - 1);
-				/* cast to make sure we don't upcast to int */
-				val |= ((static_cast<uint32_t>(in_ptr[(out_img->rowPitch - 1) * out_img->height + col_idx] != 0) << (bit_idx - 1))) & mask;
-			}
-			out_ptr[(out_img->rowPitch - 1) + col_idx * out_img->width] = val;
 		}
 	}
 };
@@ -1142,22 +1255,24 @@ struct MEXToDXT::Converter<mxLogical, uint8_t, 1, MEXToDXT::COLORSPACE::SRGB>
 template <typename MX_TYPE>
 struct MEXToDXT::Converter<MX_TYPE, uint16_t, 3, MEXToDXT::COLORSPACE::SRGB>
 {
-	static void ToIntermediate(uint8_t* in_data, DirectX::Image* out_img)
+	static void ToIntermediate(uint8_t* in_data, DirectX::Image* out_img, LAYOUT layout)
 	{
 		/* direct copy to image */
 		auto in_ptr = reinterpret_cast<MX_TYPE*>(in_data);
 		auto out_ptr = reinterpret_cast<uint16_t*>(out_img->pixels);
 		size_t num_pixels = out_img->height * out_img->width;
-		for(size_t src_idx = 0, dst_idx = 0; dst_idx < num_pixels; dst_idx++, src_idx += out_img->height)
+		const size_t pixel_stride = (layout == LAYOUT::INTERLEAVED)? 3 : out_img->height;
+		const size_t channel_stride = (layout == LAYOUT::INTERLEAVED)? 1 : num_pixels;
+		for(size_t src_idx = 0, dst_idx = 0; dst_idx < num_pixels; dst_idx++, src_idx += pixel_stride)
 		{
-			if(src_idx >= num_pixels)
+			if(layout == LAYOUT::PLANAR && src_idx >= num_pixels)
 			{
 				src_idx = dst_idx / out_img->width;
 			}
 
 			for(int j = 0; j < 3; j++)
 			{
-				float c = DXGIPixel::SRGBToLinearFloat(in_ptr[src_idx + (j * num_pixels)]);
+				float c = DXGIPixel::SRGBToLinearFloat(in_ptr[src_idx + (j * channel_stride)]);
 				out_ptr[(dst_idx * 4) + j] = DXGIPixel::LinearFloatToUNORM<uint16_t>(c);
 			}
 			out_ptr[(dst_idx * 4) + 3] = std::numeric_limits<uint16_t>::max(); /* set missing alpha */
@@ -1169,33 +1284,97 @@ struct MEXToDXT::Converter<MX_TYPE, uint16_t, 3, MEXToDXT::COLORSPACE::SRGB>
 template <typename MX_TYPE, int NCHANNELS>
 struct MEXToDXT::Converter<MX_TYPE, float, NCHANNELS, MEXToDXT::COLORSPACE::SRGB>
 {
-	static void ToIntermediate(uint8_t* in_data, DirectX::Image* out_img)
+	static void ToIntermediate(uint8_t* in_data, DirectX::Image* out_img, LAYOUT layout)
 	{
 		/* covert to float then to output format */
 		auto in_ptr = reinterpret_cast<MX_TYPE*>(in_data);
 		auto out_ptr = reinterpret_cast<float*>(out_img->pixels);
 		const size_t num_pixels = out_img->height * out_img->width;
-		for(size_t src_idx = 0, dst_idx = 0; dst_idx < num_pixels; dst_idx++, src_idx += out_img->height)
+		const size_t pixel_stride = (layout == LAYOUT::INTERLEAVED)? NCHANNELS : out_img->height;
+		const size_t channel_stride = (layout == LAYOUT::INTERLEAVED)? 1 : num_pixels;
+		for(size_t src_idx = 0, dst_idx = 0; dst_idx < num_pixels; dst_idx++, src_idx += pixel_stride)
 		{
-			if(src_idx >= num_pixels)
+			if(layout == LAYOUT::PLANAR && src_idx >= num_pixels)
 			{
 				src_idx = dst_idx / out_img->width;
 			}
 
 			for(int j = 0; j < NCHANNELS; j++)
 			{
-				out_ptr[(dst_idx * NCHANNELS) + j] = DXGIPixel::SRGBToLinearFloat(in_ptr[src_idx + (j * num_pixels)]);
+				out_ptr[(dst_idx * NCHANNELS) + j] = DXGIPixel::SRGBToLinearFloat(in_ptr[src_idx + (j * channel_stride)]);
 			}
 		}
 	}
 };
 
 
-MEXToDXT::f_toir MEXToDXT::GetToIRFunction(mxClassID class_id, int num_channels, COLORSPACE input_colorspace)
+template <typename MX_TYPE, int NCHANNELS, MEXToDXT::COLORSPACE CS>
+void MEXToDXT::HalfConverter<MX_TYPE, NCHANNELS, CS>::ToIntermediate(uint8_t* in_data, DirectX::Image* out_img, LAYOUT layout)
 {
+	/* widen a row to float, then round the whole row to half at once */
+	constexpr int NOUTCHANNELS = (NCHANNELS == 3)? 4 : NCHANNELS;
+	auto in_ptr = reinterpret_cast<MX_TYPE*>(in_data);
+	const size_t num_pixels = out_img->height * out_img->width;
+	const size_t x_stride = (layout == LAYOUT::INTERLEAVED)? NCHANNELS : out_img->height;
+	const size_t y_stride = (layout == LAYOUT::INTERLEAVED)? out_img->width * NCHANNELS : 1;
+	const size_t channel_stride = (layout == LAYOUT::INTERLEAVED)? 1 : num_pixels;
+
+	/* set missing alpha once, it is never overwritten */
+	std::vector<float> row_buffer(out_img->width * NOUTCHANNELS, 1.0f);
+	for(size_t y = 0; y < out_img->height; y++)
+	{
+		const MX_TYPE* row_in = in_ptr + y * y_stride;
+		for(size_t x = 0; x < out_img->width; x++)
+		{
+			for(int j = 0; j < NCHANNELS; j++)
+			{
+				const MX_TYPE c = row_in[x * x_stride + j * channel_stride];
+				row_buffer[x * NOUTCHANNELS + j] = (CS == COLORSPACE::SRGB)? DXGIPixel::SRGBToLinearFloat(c) : static_cast<float>(c);
+			}
+		}
+		DirectX::PackedVector::XMConvertFloatToHalfStream(reinterpret_cast<DirectX::PackedVector::HALF*>(out_img->pixels + y * out_img->rowPitch),
+			sizeof(DirectX::PackedVector::HALF),
+			row_buffer.data(),
+			sizeof(float),
+			row_buffer.size());
+	}
+}
+
+
+MEXToDXT::INTERMEDIATE MEXToDXT::ResolveIntermediate(INTERMEDIATE intermediate, DXGI_FORMAT fmt_out)
+{
+	if(intermediate != INTERMEDIATE::DEFAULT)
+	{
+		return intermediate;
+	}
+	switch(fmt_out)
+	{
+		case DXGI_FORMAT_R16G16B16A16_FLOAT:
+		case DXGI_FORMAT_R16G16_FLOAT:
+		case DXGI_FORMAT_R16_FLOAT:
+		case DXGI_FORMAT_BC6H_TYPELESS:
+		case DXGI_FORMAT_BC6H_UF16:
+		case DXGI_FORMAT_BC6H_SF16:  return INTERMEDIATE::HALF;
+		default:                     return INTERMEDIATE::SINGLE;
+	}
+}
+
+
+MEXToDXT::f_toir MEXToDXT::GetToIRFunction(mxClassID class_id, int num_channels, COLORSPACE input_colorspace, INTERMEDIATE intermediate)
+{
+	if(intermediate == INTERMEDIATE::HALF)
+	{
+		switch(class_id)
+		{
+			case mxDOUBLE_CLASS: return GetHalfToIRFunction<mxDouble>(num_channels, input_colorspace);
+			case mxSINGLE_CLASS: return GetHalfToIRFunction<mxSingle>(num_channels, input_colorspace);
+			default:             break;
+		}
+	}
+
 	switch(class_id)
 	{
-		case mxLOGICAL_CLASS: return Converter<mxLogical, uint8_t, 1, COLORSPACE::LINEAR>::ToIntermediate;
+		case mxLOGICAL_CLASS: return Converter<mxLogical, uint8_t, 1, COLORSPACE::SRGB>::ToIntermediate;
 		case mxDOUBLE_CLASS:  return GetToIRFunction<mxDouble, float>(num_channels, input_colorspace);
 		case mxSINGLE_CLASS:  return GetToIRFunction<mxSingle, float>(num_channels, input_colorspace);
 		case mxINT8_CLASS:    return GetToIRFunction<mxInt8,   uint8_t>(num_channels, input_colorspace);
@@ -1216,7 +1395,24 @@ MEXToDXT::f_toir MEXToDXT::GetToIRFunction(mxClassID class_id, int num_channels,
 }
 
 
-void MEXToDXT::DoConversion(DirectX::Image* img_out, const mxArray* data_in, size_t depth, COLORSPACE input_colorspace)
+/* interleaved input can be copied as is when the intermediate has the same element type and channel count */
+static bool IsDirectIntermediate(mxClassID class_id, size_t num_channels, MEXToDXT::COLORSPACE input_colorspace, MEXToDXT::INTERMEDIATE intermediate)
+{
+	if(num_channels == 3 || intermediate == MEXToDXT::INTERMEDIATE::HALF)
+	{
+		return false;
+	}
+	switch(class_id)
+	{
+		case mxUINT8_CLASS:  return true;
+		case mxUINT16_CLASS:
+		case mxSINGLE_CLASS: return input_colorspace == MEXToDXT::COLORSPACE::LINEAR;
+		default:             return false;
+	}
+}
+
+
+void MEXToDXT::PrepareConversion(std::vector<ConversionJob>& jobs, DirectX::Image* img_out, const mxArray* data_in, size_t depth, COLORSPACE input_colorspace, LAYOUT layout, INTERMEDIATE intermediate)
 {
 	mxClassID class_id = mxGetClassID(data_in);
 	const mwSize num_dims = mxGetNumberOfDimensions(data_in);
@@ -1233,48 +1429,228 @@ void MEXToDXT::DoConversion(DirectX::Image* img_out, const mxArray* data_in, siz
 		}
 	}
 
-	size_t in_slicepitch = dims[0] * dims[1] * mxGetElementSize(data_in);
-	int num_channels = 1;
-	if(num_dims > 2)
+	size_t num_channels;
+	size_t num_pixels;
+	if(layout == LAYOUT::INTERLEAVED)
+	{
+		num_channels = dims[0];
+		num_pixels = dims[1] * ((num_dims > 2)? dims[2] : 1);
+	}
+	else
+	{
+		num_channels = (num_dims > 2)? dims[2] : 1;
+		num_pixels = dims[0] * dims[1];
+	}
+
+	if(num_pixels != img_out->width * img_out->height)
+	{
+		MEXError::PrintMexError(MEU_FL,
+			MEU_SEVERITY_USER,
+			"InvalidImportError",
+			"Input array is incorrectly sized.");
+	}
+
+	/* all cells must map to the same intermediate as the first */
+	if(DeriveMetadata(data_in, input_colorspace, DirectX::TEX_ALPHA_MODE_UNKNOWN, false, layout, intermediate).format != img_out->format)
+	{
+		MEXError::PrintMexError(MEU_FL,
+			MEU_SEVERITY_USER,
+			"InvalidImportError",
+			"Input arrays must all have the same class and number of channels.");
+	}
+
+	const size_t in_slicepitch = num_pixels * num_channels * mxGetElementSize(data_in);
+
+	const bool direct_copy = (layout == LAYOUT::INTERLEAVED) && IsDirectIntermediate(class_id, num_channels, input_colorspace, intermediate);
+
+	f_toir toir = GetToIRFunction(class_id, static_cast<int>(num_channels), input_colorspace, intermediate);
+
+	auto ptr = reinterpret_cast<uint8_t*>(mxGetData(data_in));
+	for(size_t i = 0; i < depth; i++, ptr += in_slicepitch, img_out++)
+	{
+		jobs.push_back({toir, ptr, in_slicepitch, img_out, layout, direct_copy});
+	}
+}
+
+
+void MEXToDXT::RunConversion(const ConversionJob& job)
+{
+	if(job.direct_copy)
+	{
+		const size_t row_size = job.src_size / job.dst->height;
+		if(job.dst->rowPitch == row_size)
+		{
+			memcpy(job.dst->pixels, job.src, job.src_size);
+		}
+		else
+		{
+			for(size_t j = 0; j < job.dst->height; j++)
+			{
+				memcpy(job.dst->pixels + j * job.dst->rowPitch, job.src + j * row_size, row_size);
+			}
+		}
+	}
+	else
+	{
+		job.toir(job.src, job.dst, job.layout);
+	}
+}
+
+
+void MEXToDXT::ConvertRowsToIntermediate(DirectX::Image* band_out, const mxArray* data_in, size_t row, uint8_t* gather_buffer, COLORSPACE input_colorspace, LAYOUT layout, INTERMEDIATE intermediate)
+{
+	const mwSize num_dims = mxGetNumberOfDimensions(data_in);
+	const mwSize* dims = mxGetDimensions(data_in);
+	const size_t elem_size = mxGetElementSize(data_in);
+
+	size_t num_channels, height;
+	if(layout == LAYOUT::INTERLEAVED)
+	{
+		num_channels = dims[0];
+		height = (num_dims > 2)? dims[2] : 1;
+	}
+	else
+	{
+		num_channels = (num_dims > 2)? dims[2] : 1;
+		height = dims[0];
+	}
+
+	const size_t width = band_out->width;
+	const size_t band_height = band_out->height;
+	if(row + band_height > height)
+	{
+		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_INTERNAL, "InvalidBandError", "The requested rows were out of bounds.");
+	}
+
+	auto data = reinterpret_cast<uint8_t*>(mxGetData(data_in));
+	if(layout == LAYOUT::INTERLEAVED)
 	{
-		if(dims[2] == 3 && (mxGetElementSize(data_in) == 1 || mxGetElementSize(data_in) == 2))
+		/* rows are already contiguous */
+		uint8_t* src = data + row * width * num_channels * elem_size;
+		if(IsDirectIntermediate(mxGetClassID(data_in), num_channels, input_colorspace, intermediate))
 		{
-			/* in these cases our intermediate has four elements while the input has 3 */
-			if(in_slicepitch * 4 != img_out->slicePitch)
+			const size_t row_size = width * num_channels * elem_size;
+			for(size_t i = 0; i < band_height; i++)
 			{
-				MEXError::PrintMexError(MEU_FL,
-					MEU_SEVERITY_USER,
-					"InvalidImportError",
-					"Input array is incorrectly sized.");
+				memcpy(band_out->pixels + i * band_out->rowPitch, src + i * row_size, row_size);
 			}
 		}
-		else if(in_slicepitch * dims[2] != img_out->slicePitch)
+		else
 		{
-			MEXError::PrintMexError(MEU_FL,
-				MEU_SEVERITY_USER,
-				"InvalidImportError",
-				"Input array is incorrectly sized.");
+			GetToIRFunction(mxGetClassID(data_in), static_cast<int>(num_channels), input_colorspace, intermediate)(src, band_out, layout);
 		}
-		in_slicepitch *= dims[2];
-		num_channels = static_cast<int>(dims[2]);
 	}
 	else
 	{
-		if(in_slicepitch != img_out->slicePitch)
+		/* gather the rows into a small column-major matrix so the converters can be reused */
+		const size_t run_size = band_height * elem_size;
+		for(size_t c = 0; c < num_channels; c++)
 		{
-			MEXError::PrintMexError(MEU_FL,
-				MEU_SEVERITY_USER,
-				"InvalidImportError",
-				"Input array is incorrectly sized.");
+			for(size_t x = 0; x < width; x++)
+			{
+				memcpy(gather_buffer + (c * width + x) * run_size, data + ((c * width + x) * height + row) * elem_size, run_size);
+			}
 		}
-		num_channels = 1;
+		GetToIRFunction(mxGetClassID(data_in), static_cast<int>(num_channels), input_colorspace, intermediate)(gather_buffer, band_out, layout);
 	}
+}
 
-	f_toir toir = GetToIRFunction(class_id, num_channels, input_colorspace);
 
-	auto ptr = reinterpret_cast<uint8_t*>(mxGetData(data_in));
-	for(size_t i = 0; i < depth; i++, ptr += in_slicepitch, img_out++)
+/* the filter bits which have a counterpart when compressing */
+static DirectX::TEX_COMPRESS_FLAGS FilterToCompressFlags(DirectX::TEX_FILTER_FLAGS filter_flags)
+{
+	uint32_t compress_flags = DirectX::TEX_COMPRESS_DEFAULT;
+	if(filter_flags & DirectX::TEX_FILTER_SRGB_IN)
 	{
-		toir(ptr, img_out);
+		compress_flags |= DirectX::TEX_COMPRESS_SRGB_IN;
 	}
+	if(filter_flags & DirectX::TEX_FILTER_SRGB_OUT)
+	{
+		compress_flags |= DirectX::TEX_COMPRESS_SRGB_OUT;
+	}
+	if(filter_flags & (DirectX::TEX_FILTER_DITHER | DirectX::TEX_FILTER_DITHER_DIFFUSION))
+	{
+		compress_flags |= DirectX::TEX_COMPRESS_DITHER;
+	}
+	return static_cast<DirectX::TEX_COMPRESS_FLAGS>(compress_flags);
+}
+
+void MEXToDXT::StreamToDDS(const std::wstring& filename,
+                           const mxArray* data_in,
+                           DXGI_FORMAT fmt_out,
+                           DirectX::TEX_FILTER_FLAGS filter_flags,
+                           float threshold,
+                           COLORSPACE input_colorspace,
+                           DirectX::TEX_ALPHA_MODE alpha_mode,
+                           DirectX::DDS_FLAGS dds_flags,
+                           LAYOUT layout,
+                           INTERMEDIATE intermediate)
+{
+	if(mxIsCell(data_in))
+	{
+		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "StreamingError", "Streaming input must be a single numeric or logical matrix.");
+	}
+
+	/* only a few rows of the intermediate and output are ever held at once */
+	intermediate = ResolveIntermediate(intermediate, fmt_out);
+	const DirectX::TexMetadata ir_metadata = DeriveMetadata(data_in, input_colorspace, alpha_mode, false, layout, intermediate);
+	DirectX::TexMetadata out_metadata = ir_metadata;
+	if(fmt_out != DXGI_FORMAT_UNKNOWN)
+	{
+		out_metadata.format = fmt_out;
+	}
+
+	Trace::Scope trace_scope("MEXToDXT::StreamToDDS", "file");
+	DDSStreamWriter writer(filename, out_metadata, dds_flags);
+
+	DirectX::ScratchImage ir_band;
+	hres = ir_band.Initialize2D(ir_metadata.format, ir_metadata.width, DDSStreamWriter::BAND_HEIGHT, 1, 1);
+	if(FAILED(hres))
+	{
+		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_HRESULT, "InitializationError", "There was an error while initializing the intermediate band.");
+	}
+
+	std::unique_ptr<uint8_t[]> gather_buffer;
+	if(layout == LAYOUT::PLANAR)
+	{
+		gather_buffer = std::make_unique<uint8_t[]>(mxGetNumberOfElements(data_in) / ir_metadata.height * DDSStreamWriter::BAND_HEIGHT * mxGetElementSize(data_in));
+	}
+
+	const DirectX::TEX_COMPRESS_FLAGS compress_flags = FilterToCompressFlags(filter_flags);
+	DirectX::ScratchImage out_band;
+	for(size_t row = 0; row < ir_metadata.height; row += DDSStreamWriter::BAND_HEIGHT)
+	{
+		Progress::CheckInterrupt();
+		DirectX::Image band = *ir_band.GetImage(0, 0, 0);
+		band.height = std::min(DDSStreamWriter::BAND_HEIGHT, ir_metadata.height - row);
+		band.slicePitch = band.rowPitch * band.height;
+
+		ConvertRowsToIntermediate(&band, data_in, row, gather_buffer.get(), input_colorspace, layout, intermediate);
+
+		if(out_metadata.format == ir_metadata.format)
+		{
+			writer.Append(band);
+			continue;
+		}
+
+		if(DirectX::IsCompressed(out_metadata.format))
+		{
+			hres = DirectX::Compress(band, out_metadata.format, compress_flags, threshold, out_band);
+			if(FAILED(hres))
+			{
+				MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_HRESULT, "CompressionError", "There was an error while compressing the image.");
+			}
+		}
+		else
+		{
+			hres = DirectX::Convert(band, out_metadata.format, filter_flags, threshold, out_band);
+			if(FAILED(hres))
+			{
+				MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_HRESULT, "ConversionError", "There was an error while converting the image.");
+			}
+		}
+		writer.Append(*out_band.GetImage(0, 0, 0));
+	}
+
+	writer.Finish();
 }
@@ -3,6 +3,7 @@
 #include "mex.h"
 #include "DirectXTex.h"
 #include <string>
+#include <vector>
 
 namespace DXTMEX
 {
@@ -15,15 +16,38 @@ namespace DXTMEX
 			DEFAULT = SRGB
 		};
 
+		/* element order of MATLAB pixel data */
+		enum class LAYOUT
+		{
+			PLANAR,      /* H x W x C */
+			INTERLEAVED, /* C x W x H, same order as DXGI pixels */
+			DEFAULT = PLANAR
+		};
+
+		/* element type of the intermediate for floating point input */
+		enum class INTERMEDIATE
+		{
+			DEFAULT, /* half if the output format is 16-bit float or BC6H, otherwise single */
+			SINGLE,
+			HALF
+		};
+
 		template <typename MX_TYPE, typename DXT_TYPE, int NCHANNELS, COLORSPACE CS, typename Enable = void>
 		struct Converter
 		{
-			static void ToIntermediate(uint8_t* in_data, DirectX::Image* out_img);
+			static void ToIntermediate(uint8_t* in_data, DirectX::Image* out_img, LAYOUT layout);
+		};
+
+		/* floating point input to DXGI_FORMAT_R16*_FLOAT */
+		template <typename MX_TYPE, int NCHANNELS, COLORSPACE CS>
+		struct HalfConverter
+		{
+			static void ToIntermediate(uint8_t* in_data, DirectX::Image* out_img, LAYOUT layout);
 		};
 
-		using f_toir = void (*)(uint8_t*, DirectX::Image*);
+		using f_toir = void (*)(uint8_t*, DirectX::Image*, LAYOUT);
 
-		f_toir GetToIRFunction(mxClassID class_id, int num_channels, COLORSPACE input_colorspace);
+		f_toir GetToIRFunction(mxClassID class_id, int num_channels, COLORSPACE input_colorspace, INTERMEDIATE intermediate = INTERMEDIATE::DEFAULT);
 
 		template <typename MX_TYPE, typename DXT_TYPE>
 		f_toir GetToIRFunction(int num_channels, COLORSPACE input_colorspace)
@@ -49,19 +73,62 @@ namespace DXTMEX
 			}
 		}
 
+		template <typename MX_TYPE>
+		f_toir GetHalfToIRFunction(int num_channels, COLORSPACE input_colorspace)
+		{
+			switch(num_channels)
+			{
+				case 1:  return GetHalfToIRFunction<MX_TYPE, 1>(input_colorspace);
+				case 2:  return GetHalfToIRFunction<MX_TYPE, 2>(input_colorspace);
+				case 3:  return GetHalfToIRFunction<MX_TYPE, 3>(input_colorspace);
+				case 4:
+				default: return GetHalfToIRFunction<MX_TYPE, 4>(input_colorspace);
+			}
+		}
+
+		template <typename MX_TYPE, int NCHANNELS>
+		f_toir GetHalfToIRFunction(COLORSPACE input_colorspace)
+		{
+			switch(input_colorspace)
+			{
+				case COLORSPACE::LINEAR: return HalfConverter<MX_TYPE, NCHANNELS, COLORSPACE::LINEAR>::ToIntermediate;
+				case COLORSPACE::SRGB:
+				default:                 return HalfConverter<MX_TYPE, NCHANNELS, COLORSPACE::SRGB>::ToIntermediate;
+			}
+		}
+
+		/* resolves INTERMEDIATE::DEFAULT against the final output format */
+		INTERMEDIATE ResolveIntermediate(INTERMEDIATE intermediate, DXGI_FORMAT fmt_out);
+
 		static DirectX::TexMetadata DeriveMetadata(const mxArray* data_in,
 			COLORSPACE input_colorspace,
 			DirectX::TEX_ALPHA_MODE alpha_mode,
-			bool is_cubemap);
+			bool is_cubemap,
+			LAYOUT layout = LAYOUT::DEFAULT,
+			INTERMEDIATE intermediate = INTERMEDIATE::DEFAULT);
+
+		/* a single slice conversion which does not touch the MATLAB API */
+		struct ConversionJob
+		{
+			f_toir          toir;
+			uint8_t*        src;
+			size_t          src_size;
+			DirectX::Image* dst;
+			LAYOUT          layout;
+			bool            direct_copy;
+		};
 
-		void DoConversion(DirectX::Image* img_out, const mxArray* data_in, size_t depth, COLORSPACE input_colorspace);
+		void PrepareConversion(std::vector<ConversionJob>& jobs, DirectX::Image* img_out, const mxArray* data_in, size_t depth, COLORSPACE input_colorspace, LAYOUT layout = LAYOUT::DEFAULT, INTERMEDIATE intermediate = INTERMEDIATE::DEFAULT);
+		void RunConversion(const ConversionJob& job);
 
 		void ConvertToIntermediate(DirectX::ScratchImage& scimg_out,
 			const mxArray* data_in,
 			COLORSPACE input_colorspace,
 			DirectX::TEX_ALPHA_MODE alpha_mode,
 			bool is_cubemap,
-			DirectX::CP_FLAGS cp_flags);
+			DirectX::CP_FLAGS cp_flags,
+			LAYOUT layout = LAYOUT::DEFAULT,
+			INTERMEDIATE intermediate = INTERMEDIATE::DEFAULT);
 
 		void ConvertToOutput(DXGI_FORMAT fmt_out,
 			DirectX::TEX_FILTER_FLAGS filter_flags,
@@ -71,8 +138,28 @@ namespace DXTMEX
 			COLORSPACE input_colorspace,
 			DirectX::TEX_ALPHA_MODE alpha_mode,
 			bool is_cubemap,
-			DirectX::CP_FLAGS cp_flags);
+			DirectX::CP_FLAGS cp_flags,
+			LAYOUT layout = LAYOUT::DEFAULT,
+			INTERMEDIATE intermediate = INTERMEDIATE::DEFAULT);
 
+		void ConvertRowsToIntermediate(DirectX::Image* band_out,
+			const mxArray* data_in,
+			size_t row,
+			uint8_t* gather_buffer,
+			COLORSPACE input_colorspace,
+			LAYOUT layout = LAYOUT::DEFAULT,
+			INTERMEDIATE intermediate = INTERMEDIATE::DEFAULT);
+
+		void StreamToDDS(const std::wstring& filename,
+			const mxArray* data_in,
+			DXGI_FORMAT fmt_out,
+			DirectX::TEX_FILTER_FLAGS filter_flags,
+			float threshold,
+			COLORSPACE input_colorspace,
+			DirectX::TEX_ALPHA_MODE alpha_mode,
+			DirectX::DDS_FLAGS dds_flags,
+			LAYOUT layout = LAYOUT::DEFAULT,
+			INTERMEDIATE intermediate = INTERMEDIATE::DEFAULT);
 
 	};
 
@@ -131,12 +218,12 @@ namespace DXTMEX
 		static bool IsDXTImageImport(const mxArray* in);
 		static bool IsDXTImageSliceImport(const mxArray* in);
 
-		void ToImage(mxArray*& mx_dxtimage_rgb, bool combine_alpha);
+		void ToImage(mxArray*& mx_dxtimage_rgb, bool combine_alpha, mxArray* mx_target = nullptr);
 		void ToImage(mxArray*& mx_dxtimage_rgb, mxArray*& mx_dxtimage_a);
-		void ToImageMatrix(mxArray*& mx_dxtimage_rgb, bool combine_alpha);
+		void ToImageMatrix(mxArray*& mx_dxtimage_rgb, bool combine_alpha, mxArray* mx_target = nullptr);
 		void ToImageMatrix(mxArray*& mx_dxtimage_rgb, mxArray*& mx_dxtimage_a);
 
-		void ToMatrix(mxArray*& mx_dxtimage_out);
+		void ToMatrix(mxArray*& mx_dxtimage_out, mxArray* mx_target = nullptr, MEXToDXT::LAYOUT layout = MEXToDXT::LAYOUT::DEFAULT);
 
 		void WriteHDR(const std::wstring& filename, std::wstring& ext, bool remove_idx_if_singular = false);
 		void WriteHDR(const std::wstring& filename, size_t mip, size_t item, size_t slice);
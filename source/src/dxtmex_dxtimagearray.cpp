@@ -1,3 +1,5 @@
+#include <cmath>
+#include <limits>
 #include <string>
 
 #include "mex.h"
@@ -6,6 +8,12 @@
 #include "dxtmex_dxtimagearray.hpp"
 #include "dxtmex_mexerror.hpp"
 #include "dxtmex_mexutils.hpp"
+#include "dxtmex_compress.hpp"
+#include "dxtmex_blockops.hpp"
+#include "dxtmex_progress.hpp"
+#include "dxtmex_jobs.hpp"
+#include "dxtmex_stats.hpp"
+#include "dxtmex_trace.hpp"
 
 #ifdef min
 #  undef min
@@ -45,13 +53,52 @@ static std::unordered_map<std::string, DXTImageArray::OPERATION> g_directive_map
 	{"PREMULTIPLY_ALPHA",                DXTImageArray::OPERATION::PREMULTIPLY_ALPHA               },
 	{"COMPRESS",                         DXTImageArray::OPERATION::COMPRESS                        },
 	{"DECOMPRESS",                       DXTImageArray::OPERATION::DECOMPRESS                      },
+	{"TRANSCODE",                        DXTImageArray::OPERATION::TRANSCODE                       },
 	{"COPY_RECTANGLE",                   DXTImageArray::OPERATION::COPY_RECTANGLE                  },
+	{"UPDATE_REGION",                    DXTImageArray::OPERATION::UPDATE_REGION                   },
 	{"COMPUTE_NORMAL_MAP",               DXTImageArray::OPERATION::COMPUTE_NORMAL_MAP              },
 	{"COMPUTE_MSE",                      DXTImageArray::OPERATION::COMPUTE_MSE                     },
 	{"TO_IMAGE",                         DXTImageArray::OPERATION::TO_IMAGE                        },
-	{"TO_MATRIX",                        DXTImageArray::OPERATION::TO_MATRIX                       }
+	{"TO_MATRIX",                        DXTImageArray::OPERATION::TO_MATRIX                       },
+	{"ASYNC_READ_DDS",                   DXTImageArray::OPERATION::ASYNC_READ_DDS                  },
+	{"ASYNC_READ_HDR",                   DXTImageArray::OPERATION::ASYNC_READ_HDR                  },
+	{"ASYNC_READ_TGA",                   DXTImageArray::OPERATION::ASYNC_READ_TGA                  },
+	{"ASYNC_COMPRESS",                   DXTImageArray::OPERATION::ASYNC_COMPRESS                  },
+	{"ASYNC_DECOMPRESS",                 DXTImageArray::OPERATION::ASYNC_DECOMPRESS                },
+	{"ASYNC_TRANSCODE",                  DXTImageArray::OPERATION::ASYNC_TRANSCODE                 },
+	{"POLL",                             DXTImageArray::OPERATION::POLL                            },
+	{"WAIT",                             DXTImageArray::OPERATION::WAIT                            },
+	{"FETCH",                            DXTImageArray::OPERATION::FETCH                           },
+	{"STATS",                            DXTImageArray::OPERATION::STATS                           },
+	{"STATS_RESET",                      DXTImageArray::OPERATION::STATS_RESET                     },
+	{"TRACE_START",                      DXTImageArray::OPERATION::TRACE_START                     },
+	{"TRACE_STOP",                       DXTImageArray::OPERATION::TRACE_STOP                      },
+	{"BENCHMARK",                        DXTImageArray::OPERATION::BENCHMARK                       },
+	{"BENCHMARK_PIXEL",                  DXTImageArray::OPERATION::BENCHMARK_PIXEL                 },
+	{"COMPUTE_SSIM",                     DXTImageArray::OPERATION::COMPUTE_SSIM                    },
+	{"COMPRESSION_REPORT",               DXTImageArray::OPERATION::COMPRESSION_REPORT              }
 };
 
+/* 'Progress' takes a function handle called as fn(done, total), 'ProgressInterval' the seconds between calls */
+static bool ImportProgressOption(const mxArray* key, const mxArray* val)
+{
+	if(MEXUtils::CompareMEXString(key, "PROGRESS"))
+	{
+		Progress::SetCallback(val);
+		return true;
+	}
+	if(MEXUtils::CompareMEXString(key, "PROGRESSINTERVAL"))
+	{
+		if(!mxIsNumeric(val) || !mxIsScalar(val) || mxGetScalar(val) < 0)
+		{
+			MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "InvalidValueError", "ProgressInterval value must be a nonnegative scalar in seconds.");
+		}
+		Progress::SetInterval(mxGetScalar(val));
+		return true;
+	}
+	return false;
+}
+
 void DXTImageArray::WriteMatrixDDS(int nrhs, const mxArray* prhs[])
 {
 	if(nrhs < 3)
@@ -98,6 +145,10 @@ void DXTImageArray::WriteMatrixDDS(int nrhs, const mxArray* prhs[])
 
 	DirectX::DDS_FLAGS dds_flags = DirectX::DDS_FLAGS_NONE;
 
+	MEXToDXT::LAYOUT layout = MEXToDXT::LAYOUT::DEFAULT;
+	MEXToDXT::INTERMEDIATE intermediate = MEXToDXT::INTERMEDIATE::DEFAULT;
+	bool is_streaming = false;
+
 	if((num_opts % 2) != 0)
 	{
 		MEXError::PrintMexError(MEU_FL,
@@ -192,6 +243,45 @@ void DXTImageArray::WriteMatrixDDS(int nrhs, const mxArray* prhs[])
 		{
 			g_ddsflags.ImportFlags(mx_curr_val, dds_flags);
 		}
+		else if(strcmp(keyname, "STREAMING") == 0)
+		{
+			if(!mxIsLogicalScalar(mx_curr_val))
+			{
+				MEXError::PrintMexError(MEU_FL,
+					MEU_SEVERITY_USER,
+					"InvalidValueError",
+					"Streaming value must be class 'logical'");
+			}
+			is_streaming = mxIsLogicalScalarTrue(mx_curr_val);
+		}
+		else if(strcmp(keyname, "LAYOUT") == 0)
+		{
+			if(!mxIsChar(mx_curr_val))
+			{
+				MEXError::PrintMexError(MEU_FL,
+					MEU_SEVERITY_USER,
+					"InvalidValueError",
+					"Layout value must be class 'char'");
+			}
+			MEXUtils::ToUpper(const_cast<mxArray*>(mx_curr_val));
+			char* val = mxArrayToString(mx_curr_val);
+			layout = g_layout_map.FindIDFromString(val);
+			mxFree(val);
+		}
+		else if(strcmp(keyname, "INTERMEDIATE") == 0)
+		{
+			if(!mxIsChar(mx_curr_val))
+			{
+				MEXError::PrintMexError(MEU_FL,
+					MEU_SEVERITY_USER,
+					"InvalidValueError",
+					"Intermediate value must be class 'char'");
+			}
+			MEXUtils::ToUpper(const_cast<mxArray*>(mx_curr_val));
+			char* val = mxArrayToString(mx_curr_val);
+			intermediate = g_intermediate_map.FindIDFromString(val);
+			mxFree(val);
+		}
 		else
 		{
 			MEXError::PrintMexError(MEU_FL,
@@ -201,12 +291,23 @@ void DXTImageArray::WriteMatrixDDS(int nrhs, const mxArray* prhs[])
 		}
 	}
 	
-	DirectX::ScratchImage sc_img;
-	MEXToDXT::ConvertToOutput(fmt, filter_flags, threshold, sc_img, mx_data, input_colorspace, alpha_mode, is_cubemap, cp_flags);
-
 	std::wstring filename;
 	ImportFilename(mx_filename, filename);
 
+	if(is_streaming)
+	{
+		if(is_cubemap)
+		{
+			MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "StreamingError", "Cubemaps cannot be written with streaming.");
+		}
+		MEXToDXT::StreamToDDS(filename, mx_data, fmt, filter_flags, threshold, input_colorspace, alpha_mode, dds_flags, layout, intermediate);
+		return;
+	}
+
+	DirectX::ScratchImage sc_img;
+	MEXToDXT::ConvertToOutput(fmt, filter_flags, threshold, sc_img, mx_data, input_colorspace, alpha_mode, is_cubemap, cp_flags, layout, intermediate);
+
+	Trace::Scope trace_scope("DirectX::SaveToDDSFile", "file");
 	hres = DirectX::SaveToDDSFile(sc_img.GetImages(), sc_img.GetImageCount(), sc_img.GetMetadata(), dds_flags, filename.c_str());
 	if(FAILED(hres))
 	{
@@ -375,6 +476,7 @@ void DXTImageArray::WriteMatrixHDR(int nrhs, const mxArray* prhs[])
 	std::wstring filename;
 	ImportFilename(mx_filename, filename);
 
+	Trace::Scope trace_scope("DirectX::SaveToHDRFile", "file");
 	hres = DirectX::SaveToHDRFile(*sc_img.GetImage(0, 0, 0), filename.c_str());
 	if(FAILED(hres))
 	{
@@ -543,6 +645,7 @@ void DXTImageArray::WriteMatrixTGA(int nrhs, const mxArray* prhs[])
 	std::wstring filename;
 	ImportFilename(mx_filename, filename);
 
+	Trace::Scope trace_scope("DirectX::SaveToTGAFile", "file");
 	hres = DirectX::SaveToTGAFile(*sc_img.GetImage(0, 0, 0), filename.c_str());
 	if(FAILED(hres))
 	{
@@ -563,162 +666,138 @@ std::unique_ptr<DXTImage[]> DXTImageArray::CopyDXTImageArray()
 	return out;
 }
 
-void DXTImageArray::ReadDDS(int nrhs, const mxArray* prhs[])
+DXTImageArray::FileRequest DXTImageArray::ParseFileRequest(DXTImage::IMAGE_TYPE type, int nrhs, const mxArray* prhs[])
 {
 	size_t i;
-	DirectX::DDS_FLAGS flags = DirectX::DDS_FLAGS_NONE;
-	std::wstring filename;
+	FileRequest request = {type, DirectX::DDS_FLAGS_NONE, 1, 1, {}, {}};
 	
 	if(nrhs < 1)
 	{
 		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "NotEnoughInputsError", "Not enough arguments. Please supply a file name.");
 	}
 	
-	const mxArray* mx_filenames = prhs[0];
-	
-	if(nrhs > 1)
-	{
-		g_ddsflags.ImportFlags(nrhs - 1, prhs + 1, flags);
-	}
-	
-	if(mxIsCell(mx_filenames))
-	{
-		this->Initialize(mxGetM(mx_filenames), mxGetN(mx_filenames), DXTImage::IMAGE_TYPE::DDS, flags);
-		for(i = 0; i < this->GetSize(); i++)
-		{
-			ImportFilename(mxGetCell(mx_filenames, i), filename);
-			hres = DirectX::LoadFromDDSFile(filename.c_str(), flags, nullptr, this->GetDXTImage(i));
-			if(FAILED(hres))
-			{
-				MEXError::PrintMexError(MEU_FL,
-				                        MEU_SEVERITY_USER | MEU_SEVERITY_HRESULT,
-				                        "DDSReadError",
-				                        "There was an error while reading the DDS file.\n"
-				                        "Filename: \"%s\"",
-				                        mxArrayToString(mxGetCell(mx_filenames, i)));
-			}
-		}
-	}
-	else
+	if(type == DXTImage::IMAGE_TYPE::DDS)
 	{
-		this->Initialize(1, 1, DXTImage::IMAGE_TYPE::DDS, flags);
-		ImportFilename(mx_filenames, filename);
-		hres = DirectX::LoadFromDDSFile(filename.c_str(), flags, nullptr, this->GetDXTImage(0));
-		if(FAILED(hres))
+		if(nrhs > 1)
 		{
-			MEXError::PrintMexError(MEU_FL,
-			                        MEU_SEVERITY_USER | MEU_SEVERITY_HRESULT,
-			                        "DDSReadError",
-			                        "There was an error while reading the DDS file.\n"
-					              "Filename: \"%s\"",
-					              mxArrayToString(mx_filenames));
+			g_ddsflags.ImportFlags(nrhs - 1, prhs + 1, request.flags);
 		}
-		this->GetDXTImage(0).SetImageType(DXTImage::IMAGE_TYPE::DDS);
-	}
-}
-
-void DXTImageArray::ReadHDR(int nrhs, const mxArray* prhs[])
-{
-	size_t i;
-	std::wstring filename;
-	
-	if(nrhs < 1)
-	{
-		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "NotEnoughInputsError", "Not enough arguments. Please supply a file name.");
 	}
 	else if(nrhs > 1)
 	{
 		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "TooManyInputsError", "Too many arguments.");
 	}
-	const mxArray* mx_filenames = prhs[0];
 	
+	const mxArray* mx_filenames = prhs[0];
+	std::vector<const mxArray*> mx_names;
 	if(mxIsCell(mx_filenames))
 	{
-		this->Initialize(mxGetM(mx_filenames), mxGetN(mx_filenames));
-		for(i = 0; i < this->GetSize(); i++)
+		request.m = mxGetM(mx_filenames);
+		request.n = mxGetN(mx_filenames);
+		for(i = 0; i < request.m*request.n; i++)
 		{
-			ImportFilename(mxGetCell(mx_filenames, i), filename);
-			hres = DirectX::LoadFromHDRFile(filename.c_str(), nullptr, this->GetDXTImage(i));
-			if(FAILED(hres))
-			{
-				MEXError::PrintMexError(MEU_FL,
-				                        MEU_SEVERITY_USER | MEU_SEVERITY_HRESULT,
-				                        "HDRReadError",
-				                        "There was an error while reading the HDR file.\n"
-				                        "Filename: \"%s\"",
-				                        mxArrayToString(mxGetCell(mx_filenames, i)));
-			}
-			this->GetDXTImage(i).SetImageType(DXTImage::IMAGE_TYPE::HDR);
+			mx_names.push_back(mxGetCell(mx_filenames, i));
 		}
 	}
 	else
 	{
-		this->Initialize(1, 1);
-		ImportFilename(mx_filenames, filename);
-		hres = DirectX::LoadFromHDRFile(filename.c_str(), nullptr, this->GetDXTImage(0));
-		if(FAILED(hres))
-		{
-			MEXError::PrintMexError(MEU_FL,
-			                        MEU_SEVERITY_USER | MEU_SEVERITY_HRESULT,
-			                        "HDRReadError",
-			                        "There was an error while reading the HDR file.\n"
-			                        "Filename: \"%s\"",
-			                        mxArrayToString(mx_filenames));
-		}
-		this->GetDXTImage(0).SetImageType(DXTImage::IMAGE_TYPE::HDR);
+		mx_names.push_back(mx_filenames);
+	}
+	
+	/* the names are kept for the error messages, which may be raised off the main thread */
+	request.filenames.resize(mx_names.size());
+	for(i = 0; i < mx_names.size(); i++)
+	{
+		ImportFilename(mx_names[i], request.filenames[i]);
+		char* name = mxArrayToString(mx_names[i]);
+		request.names.emplace_back(name);
+		mxFree(name);
 	}
+	return request;
 }
 
-void DXTImageArray::ReadTGA(int nrhs, const mxArray* prhs[])
+void DXTImageArray::ReadFiles(const FileRequest& request)
 {
 	size_t i;
-	std::wstring filename;
-	
-	if(nrhs < 1)
-	{
-		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "NotEnoughInputsError", "Not enough arguments. Please supply a file name.");
-	}
-	else if(nrhs > 1)
-	{
-		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "TooManyInputsError", "Too many arguments.");
-	}
-	const mxArray* mx_filenames = prhs[0];
-	
-	if(mxIsCell(mx_filenames))
+	this->Initialize(request.m, request.n, request.type, request.flags);
+	for(i = 0; i < this->GetSize(); i++)
 	{
-		this->Initialize(mxGetM(mx_filenames), mxGetN(mx_filenames));
-		for(i = 0; i < this->GetSize(); i++)
+		switch(request.type)
 		{
-			ImportFilename(mxGetCell(mx_filenames, i), filename);
-			hres = DirectX::LoadFromTGAFile(filename.c_str(), nullptr, this->GetDXTImage(i));
-			if(FAILED(hres))
+			case DXTImage::IMAGE_TYPE::DDS:
 			{
-				MEXError::PrintMexError(MEU_FL,
-				                        MEU_SEVERITY_USER | MEU_SEVERITY_HRESULT,
-				                        "TGAReadError",
-				                        "There was an error while reading the TGA file.\n"
-				                        "Filename: \"%s\"",
-				                        mxArrayToString(mxGetCell(mx_filenames, i)));
+				Trace::Scope trace_scope("DirectX::LoadFromDDSFile", "file");
+				hres = DirectX::LoadFromDDSFile(request.filenames[i].c_str(), request.flags, nullptr, this->GetDXTImage(i));
+				if(FAILED(hres))
+				{
+					MEXError::PrintMexError(MEU_FL,
+					                        MEU_SEVERITY_USER | MEU_SEVERITY_HRESULT,
+					                        "DDSReadError",
+					                        "There was an error while reading the DDS file.\n"
+					                        "Filename: \"%s\"",
+					                        request.names[i].c_str());
+				}
+				break;
+			}
+			case DXTImage::IMAGE_TYPE::HDR:
+			{
+				Trace::Scope trace_scope("DirectX::LoadFromHDRFile", "file");
+				hres = DirectX::LoadFromHDRFile(request.filenames[i].c_str(), nullptr, this->GetDXTImage(i));
+				if(FAILED(hres))
+				{
+					MEXError::PrintMexError(MEU_FL,
+					                        MEU_SEVERITY_USER | MEU_SEVERITY_HRESULT,
+					                        "HDRReadError",
+					                        "There was an error while reading the HDR file.\n"
+					                        "Filename: \"%s\"",
+					                        request.names[i].c_str());
+				}
+				break;
+			}
+			case DXTImage::IMAGE_TYPE::TGA:
+			{
+				Trace::Scope trace_scope("DirectX::LoadFromTGAFile", "file");
+				hres = DirectX::LoadFromTGAFile(request.filenames[i].c_str(), nullptr, this->GetDXTImage(i));
+				if(FAILED(hres))
+				{
+					MEXError::PrintMexError(MEU_FL,
+					                        MEU_SEVERITY_USER | MEU_SEVERITY_HRESULT,
+					                        "TGAReadError",
+					                        "There was an error while reading the TGA file.\n"
+					                        "Filename: \"%s\"",
+					                        request.names[i].c_str());
+				}
+				break;
+			}
+			default:
+			{
+				MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_INTERNAL, "InvalidImageTypeError", "Unexpected image type.");
 			}
-			this->GetDXTImage(i).SetImageType(DXTImage::IMAGE_TYPE::TGA);
-		}
-	}
-	else
-	{
-		this->Initialize(1, 1);
-		ImportFilename(mx_filenames, filename);
-		hres = DirectX::LoadFromTGAFile(filename.c_str(), nullptr, this->GetDXTImage(0));
-		if(FAILED(hres))
-		{
-			MEXError::PrintMexError(MEU_FL,
-			                        MEU_SEVERITY_USER | MEU_SEVERITY_HRESULT,
-			                        "TGAReadError",
-			                        "There was an error while reading the TGA file.\n"
-			                        "Filename: \"%s\"",
-			                        mxArrayToString(mx_filenames));
 		}
-		this->GetDXTImage(0).SetImageType(DXTImage::IMAGE_TYPE::TGA);
+		this->GetDXTImage(i).SetImageType(request.type);
 	}
+	Stats::AddSubresources(this->GetNumberOfSlices());
+}
+
+void DXTImageArray::ReadDDS(int nrhs, const mxArray* prhs[])
+{
+	this->ReadFiles(DXTImageArray::ParseFileRequest(DXTImage::IMAGE_TYPE::DDS, nrhs, prhs));
+}
+
+void DXTImageArray::ReadHDR(int nrhs, const mxArray* prhs[])
+{
+	this->ReadFiles(DXTImageArray::ParseFileRequest(DXTImage::IMAGE_TYPE::HDR, nrhs, prhs));
+}
+
+void DXTImageArray::ReadTGA(int nrhs, const mxArray* prhs[])
+{
+	this->ReadFiles(DXTImageArray::ParseFileRequest(DXTImage::IMAGE_TYPE::TGA, nrhs, prhs));
+}
+
+void DXTImageArray::ReadAsync(DXTImage::IMAGE_TYPE type, int, mxArray* plhs[], int nrhs, const mxArray* prhs[])
+{
+	const FileRequest request = DXTImageArray::ParseFileRequest(type, nrhs, prhs);
+	plhs[0] = mxCreateDoubleScalar(Jobs::Start(DXTImageArray(), [request](DXTImageArray& arr) {arr.ReadFiles(request);}));
 }
 
 void DXTImageArray::Import(int nrhs, const mxArray* prhs[])
@@ -766,6 +845,7 @@ void DXTImageArray::Import(int nrhs, const mxArray* prhs[])
 	{
 		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER | MEU_SEVERITY_INTERNAL, "InvalidImportError", "The import object was invalid.");
 	}
+	Stats::AddSubresources(this->GetNumberOfSlices());
 }
 
 bool DXTImage::IsDXTImageImport(const mxArray* in)
@@ -811,6 +891,7 @@ void DXTImageArray::ReadDDSMetadata(int, mxArray *plhs[], int nrhs, const mxArra
 		g_ddsflags.ImportFlags(nrhs - 1, prhs + 1, flags);
 	}
 	
+	Trace::Scope trace_scope("DirectX::GetMetadataFromDDSFile", "file");
 	hres = DirectX::GetMetadataFromDDSFile(filename.c_str(), flags, metadata);
 	if(FAILED(hres))
 	{
@@ -836,6 +917,7 @@ void DXTImageArray::ReadHDRMetadata(int, mxArray *plhs[], int nrhs, const mxArra
 	DXTImageArray::ImportFilename(prhs[0], filename);
 	
 	
+	Trace::Scope trace_scope("DirectX::GetMetadataFromHDRFile", "file");
 	hres = DirectX::GetMetadataFromHDRFile(filename.c_str(), metadata);
 	if(FAILED(hres))
 	{
@@ -860,6 +942,7 @@ void DXTImageArray::ReadTGAMetadata(int, mxArray *plhs[], int nrhs, const mxArra
 	DXTImageArray::ImportFilename(prhs[0], filename);
 	
 	
+	Trace::Scope trace_scope("DirectX::GetMetadataFromTGAFile", "file");
 	hres = DirectX::GetMetadataFromTGAFile(filename.c_str(), metadata);
 	if(FAILED(hres))
 	{
@@ -881,6 +964,7 @@ void DXTImageArray::IsDDS(int, mxArray *plhs[], int nrhs, const mxArray* prhs[])
 		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "TooManyInputsError", "Too many arguments.");
 	}
 	DXTImageArray::ImportFilename(prhs[0], filename);
+	Trace::Scope trace_scope("DirectX::GetMetadataFromDDSFile", "file");
 	hres = DirectX::GetMetadataFromDDSFile(filename.c_str(), DirectX::DDS_FLAGS_NONE, metadata);
 	if(FAILED(hres) && hres != E_FAIL && hres != HRESULT_FROM_WIN32(ERROR_INVALID_DATA) && hres != HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED))
 	{
@@ -902,6 +986,7 @@ void DXTImageArray::IsHDR(int, mxArray *plhs[], int nrhs, const mxArray* prhs[])
 		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "TooManyInputsError", "Too many arguments.");
 	}
 	DXTImageArray::ImportFilename(prhs[0], filename);
+	Trace::Scope trace_scope("DirectX::GetMetadataFromHDRFile", "file");
 	hres = DirectX::GetMetadataFromHDRFile(filename.c_str(), metadata);
 	if(FAILED(hres) && hres != E_FAIL && hres != HRESULT_FROM_WIN32(ERROR_INVALID_DATA) && hres != HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED))
 	{
@@ -923,6 +1008,7 @@ void DXTImageArray::IsTGA(int, mxArray *plhs[], int nrhs, const mxArray* prhs[])
 		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "TooManyInputsError", "Too many arguments.");
 	}
 	DXTImageArray::ImportFilename(prhs[0], filename);
+	Trace::Scope trace_scope("DirectX::GetMetadataFromTGAFile", "file");
 	hres = DirectX::GetMetadataFromTGAFile(filename.c_str(), metadata);
 	if(FAILED(hres) && hres != E_FAIL && hres != HRESULT_FROM_WIN32(ERROR_INVALID_DATA) && hres != HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED))
 	{
@@ -977,14 +1063,52 @@ void DXTImageArray::FlipRotate(int nrhs, const mxArray* prhs[])
 	DWORD fr_flags = g_frflags.FindFlag(flag);
 	mxFree(flag);
 	
+	/* block compressed images are flipped in place where possible, otherwise they go through a decode */
+	std::vector<DirectX::ScratchImage> decoded(this->GetSize());
+	bool needs_reencode = false;
 	for(i = 0; i < this->GetSize(); i++)
 	{
 		DXTImage& pre_op  = this->GetDXTImage(i);
-		hres = DirectX::FlipRotate(pre_op.GetImages(), pre_op.GetImageCount(), pre_op.GetMetadata(), fr_flags, new_arr[i]);
-		if(FAILED(hres))
+		if(!DirectX::IsCompressed(pre_op.GetMetadata().format))
+		{
+			Trace::Scope trace_scope("DirectX::FlipRotate", "image");
+			hres = DirectX::FlipRotate(pre_op.GetImages(), pre_op.GetImageCount(), pre_op.GetMetadata(), fr_flags, new_arr[i]);
+			if(FAILED(hres))
+			{
+				MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_HRESULT, "FlipRotateError", "There was an error while rotating or flipping the image.");
+			}
+		}
+		else if(!BlockOps::FlipRotate(pre_op, fr_flags, new_arr[i]))
+		{
+			DirectX::ScratchImage tmp;
+			{
+				Trace::Scope trace_scope("DirectX::Decompress", "image");
+				hres = DirectX::Decompress(pre_op.GetImages(), pre_op.GetImageCount(), pre_op.GetMetadata(), DXGI_FORMAT_UNKNOWN, tmp);
+			}
+			if(SUCCEEDED(hres))
+			{
+				Trace::Scope trace_scope("DirectX::FlipRotate", "image");
+				hres = DirectX::FlipRotate(tmp.GetImages(), tmp.GetImageCount(), tmp.GetMetadata(), fr_flags, decoded[i]);
+			}
+			if(FAILED(hres))
+			{
+				MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_HRESULT, "FlipRotateError", "There was an error while rotating or flipping the image.");
+			}
+			needs_reencode = true;
+		}
+	}
+	
+	if(needs_reencode)
+	{
+		CompressionScheduler scheduler(DXGI_FORMAT_UNKNOWN, DirectX::TEX_COMPRESS_DEFAULT, DirectX::TEX_THRESHOLD_DEFAULT);
+		for(i = 0; i < this->GetSize(); i++)
 		{
-			MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_HRESULT, "FlipRotateError", "There was an error while rotating or flipping the image.");
+			if(decoded[i].GetImageCount() > 0)
+			{
+				scheduler.Add(decoded[i], new_arr[i], this->GetDXTImage(i).GetMetadata().format);
+			}
 		}
+		scheduler.Run();
 	}
 	this->_arr = std::move(new_arr);
 }
@@ -1049,6 +1173,7 @@ void DXTImageArray::Resize(int nrhs, const mxArray* prhs[])
 	{
 		DXTImage& pre_op  = this->GetDXTImage(i);
 		DXTImage& post_op = new_arr[i];
+		Trace::Scope trace_scope("DirectX::Resize", "image");
 		hres = DirectX::Resize(pre_op.GetImages(), pre_op.GetImageCount(), pre_op.GetMetadata(), w, h, filter_flags, post_op);
 		if(FAILED(hres))
 		{
@@ -1100,6 +1225,7 @@ void DXTImageArray::Convert(int nrhs, const mxArray* prhs[])
 	{
 		DXTImage& pre_op  = this->GetDXTImage(i);
 		DXTImage& post_op = new_arr[i];
+		Trace::Scope trace_scope("DirectX::Convert", "image");
 		hres = DirectX::Convert(pre_op.GetImages(), pre_op.GetImageCount(), pre_op.GetMetadata(), fmt, filter_flags, threshold, post_op);
 		if(FAILED(hres))
 		{
@@ -1122,6 +1248,7 @@ void DXTImageArray::ConvertToSinglePlane(int nrhs, const mxArray* [])
 	{
 		DXTImage& pre_op  = this->GetDXTImage(i);
 		DXTImage& post_op = new_arr[i];
+		Trace::Scope trace_scope("DirectX::ConvertToSinglePlane", "image");
 		hres = DirectX::ConvertToSinglePlane(pre_op.GetImages(), pre_op.GetImageCount(), pre_op.GetMetadata(), post_op);
 		if(FAILED(hres))
 		{
@@ -1171,6 +1298,7 @@ void DXTImageArray::GenerateMipMaps(int nrhs, const mxArray* prhs[])
 			case DirectX::TEX_DIMENSION_TEXTURE1D:
 			case DirectX::TEX_DIMENSION_TEXTURE2D:
 			{
+				Trace::Scope trace_scope("DirectX::GenerateMipMaps", "image");
 				hres = DirectX::GenerateMipMaps(pre_op.GetImages(), pre_op.GetImageCount(), pre_op.GetMetadata(), filter_flags, levels, post_op);
 				if(FAILED(hres))
 				{
@@ -1179,6 +1307,7 @@ void DXTImageArray::GenerateMipMaps(int nrhs, const mxArray* prhs[])
 			}
 			case DirectX::TEX_DIMENSION_TEXTURE3D:
 			{
+				Trace::Scope trace_scope("DirectX::GenerateMipMaps3D", "image");
 				hres = DirectX::GenerateMipMaps3D(pre_op.GetImages(), pre_op.GetImageCount(), pre_op.GetMetadata(), filter_flags, levels, post_op);
 				if(FAILED(hres))
 				{
@@ -1228,6 +1357,7 @@ void DXTImageArray::ScaleMipMapsAlphaForCoverage(int nrhs, const mxArray* prhs[]
 		for(j = 0; j < metadata.mipLevels; j++)
 		{
 			const DirectX::Image* image = pre_op.GetImage(0, j, 0);
+			Trace::Scope trace_scope("DirectX::ScaleMipMapsAlphaForCoverage", "image");
 			hres = DirectX::ScaleMipMapsAlphaForCoverage(image, metadata.mipLevels, metadata, j, alpha_ref, post_op);
 			if(FAILED(hres))
 			{
@@ -1249,6 +1379,7 @@ void DXTImageArray::PremultiplyAlpha(int nrhs, const mxArray* prhs[])
 	{
 		DXTImage& pre_op  = this->GetDXTImage(i);
 		DXTImage& post_op = new_arr[i];
+		Trace::Scope trace_scope("DirectX::PremultiplyAlpha", "image");
 		hres = DirectX::PremultiplyAlpha(pre_op.GetImages(), pre_op.GetImageCount(), pre_op.GetMetadata(), pmalpha_flags, post_op);
 		if(FAILED(hres))
 		{
@@ -1258,11 +1389,10 @@ void DXTImageArray::PremultiplyAlpha(int nrhs, const mxArray* prhs[])
 	this->_arr = std::move(new_arr);
 }
 
-void DXTImageArray::Compress(int nrhs, const mxArray* prhs[])
+DXTImageArray::CompressOptions DXTImageArray::ParseCompressOptions(int nrhs, const mxArray* prhs[])
 {
 	size_t i;
 	DXGI_FORMAT fmt;
-	std::unique_ptr<DXTImage[]> new_arr = this->CopyDXTImageArray();
 	DirectX::TEX_COMPRESS_FLAGS compress_flags = DirectX::TEX_COMPRESS_DEFAULT;
 	float threshold = DirectX::TEX_THRESHOLD_DEFAULT;
 	if(nrhs < 1)
@@ -1270,8 +1400,39 @@ void DXTImageArray::Compress(int nrhs, const mxArray* prhs[])
 		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "NotEnoughArgumentsError", "No enough arguments. Please supply a format.");
 	}
 	
-	fmt = DXTImageArray::ParseFormat(prhs[0]);
+	/* 'auto' picks a format per image from the error target */
+	bool is_auto = false;
+	if(mxIsChar(prhs[0]))
+	{
+		MEXUtils::ToUpper(const_cast<mxArray*>(prhs[0]));
+		is_auto = MEXUtils::CompareMEXString(prhs[0], "AUTO");
+	}
+	
+	/* a cell array of formats makes one variant per format from the same source */
+	std::vector<DXGI_FORMAT> variant_formats;
+	if(mxIsCell(prhs[0]))
+	{
+		if(mxIsEmpty(prhs[0]))
+		{
+			MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "InvalidInputError", "The list of formats must not be empty.");
+		}
+		for(i = 0; i < mxGetNumberOfElements(prhs[0]); i++)
+		{
+			const mxArray* mx_fmt = mxGetCell(prhs[0], i);
+			if(mx_fmt == nullptr)
+			{
+				MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "InvalidInputError", "The list of formats must only contain format names.");
+			}
+			variant_formats.push_back(DXTImageArray::ParseFormat(mx_fmt));
+		}
+		fmt = variant_formats[0];
+	}
+	else
+	{
+		fmt = is_auto? DXGI_FORMAT_UNKNOWN : DXTImageArray::ParseFormat(prhs[0]);
+	}
 	
+	int opts_start = 1;
 	if(nrhs > 1)
 	{
 		if(mxIsDouble(prhs[1]))
@@ -1284,77 +1445,414 @@ void DXTImageArray::Compress(int nrhs, const mxArray* prhs[])
 				                        "The alpha threshold must be scalar.");
 			}
 			threshold = (float)mxGetScalar(prhs[1]);
-			if(nrhs > 2)
-			{
-				g_compressflags.ImportFlags(nrhs - 2, prhs + 2, compress_flags);
-			}
-		}
-		else if(mxIsChar(prhs[1]))
-		{
-			g_compressflags.ImportFlags(nrhs - 1, prhs + 1, compress_flags);
+			opts_start = 2;
 		}
-		else
+		else if(!mxIsChar(prhs[1]))
 		{
 			MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "InvalidInputError", "The optional second argument must either be of class 'double' or class 'char'.");
 		}
 	}
 	
-	for(i = 0; i < this->GetSize(); i++)
-	{
-		DXTImage& pre_op  = this->GetDXTImage(i);
-		DXTImage& post_op = new_arr[i];
-		hres = DirectX::Compress(pre_op.GetImages(), pre_op.GetImageCount(), pre_op.GetMetadata(), fmt, compress_flags, threshold, post_op);
-		if(FAILED(hres))
-		{
-			MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_HRESULT, "CompressError", "There was an error while compressing the image.");
-		}
-	}
-	this->_arr = std::move(new_arr);
-}
-
-void DXTImageArray::Decompress(int nrhs, const mxArray* prhs[])
-{
-	size_t i;
-	std::unique_ptr<DXTImage[]> new_arr = this->CopyDXTImageArray();
-	DXGI_FORMAT fmt = DXGI_FORMAT_UNKNOWN;
-	if(nrhs > 1)
-	{
-		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "TooManyArgumentsError", "Too many arguments.");
-	}
-	
-	if(nrhs == 1)
+	if(((nrhs - opts_start) % 2) != 0)
 	{
-		fmt = DXTImageArray::ParseFormat(prhs[0]);
+		MEXError::PrintMexError(MEU_FL,
+		                        MEU_SEVERITY_USER,
+		                        "KeyValueError",
+		                        "Invalid number of arguments. A key is likely missing a value.");
 	}
 	
-	for(i = 0; i < this->GetSize(); i++)
-	{
-		DXTImage& pre_op  = this->GetDXTImage(i);
-		DXTImage& post_op = new_arr[i];
-		hres = DirectX::Decompress(pre_op.GetImages(), pre_op.GetImageCount(), pre_op.GetMetadata(), fmt, post_op);
-		if(FAILED(hres))
+	/* pick out the scheduler options, everything else is a compression flag */
+	double quality = -1;
+	double time_budget = 0;
+	double rdo_lambda = 0;
+	double max_mse = std::pow(10.0, -DEFAULT_TARGET_PSNR / 10.0);
+	bool is_fast_path = false;
+	std::vector<const mxArray*> flag_opts;
+	for(int j = opts_start; j < nrhs; j += 2)
+	{
+		const mxArray* mx_curr_key = prhs[j];
+		const mxArray* mx_curr_val = prhs[j + 1];
+		if(!mxIsChar(mx_curr_key))
 		{
-			MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_HRESULT, "DecompressError", "There was an error while decompressing the image.");
+			MEXError::PrintMexError(MEU_FL,
+			                        MEU_SEVERITY_USER,
+			                        "InvalidKeyError",
+			                        "All keys must be class 'char'.");
 		}
-	}
-	this->_arr = std::move(new_arr);
-}
-
-void DXTImageArray::ComputeNormalMap(int nrhs, const mxArray* prhs[])
-{
-	size_t i;
-	std::unique_ptr<DXTImage[]> new_arr = this->CopyDXTImageArray();
-	DXGI_FORMAT fmt;
-	float amplitude;
-	DirectX::CNMAP_FLAGS cn_flags = DirectX::CNMAP_DEFAULT;
-	if(nrhs < 2)
-	{
-		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "NotEnoughArgumentsError", "No enough arguments. Please supply a format and an amplitude.");
-	}
-	
-	fmt = DXTImageArray::ParseFormat(prhs[0]);
-	
-	if(!mxIsDouble(prhs[1]) || !mxIsScalar(prhs[1]))
+		MEXUtils::ToUpper(const_cast<mxArray*>(mx_curr_key));
+		if(MEXUtils::CompareMEXString(mx_curr_key, "QUALITY"))
+		{
+			if(!mxIsNumeric(mx_curr_val) || !mxIsScalar(mx_curr_val) || !std::isfinite(mxGetScalar(mx_curr_val)) || mxGetScalar(mx_curr_val) < 0
+			   || mxGetScalar(mx_curr_val) > CompressionScheduler::MAX_QUALITY || mxGetScalar(mx_curr_val) != std::floor(mxGetScalar(mx_curr_val)))
+			{
+				MEXError::PrintMexError(MEU_FL,
+				                        MEU_SEVERITY_USER,
+				                        "InvalidValueError",
+				                        "Quality value must be an integer from 0 to %d.",
+				                        (int)CompressionScheduler::MAX_QUALITY);
+			}
+			quality = mxGetScalar(mx_curr_val);
+		}
+		else if(MEXUtils::CompareMEXString(mx_curr_key, "TIMEBUDGET"))
+		{
+			if(!mxIsNumeric(mx_curr_val) || !mxIsScalar(mx_curr_val) || mxGetScalar(mx_curr_val) < 0)
+			{
+				MEXError::PrintMexError(MEU_FL,
+				                        MEU_SEVERITY_USER,
+				                        "InvalidValueError",
+				                        "TimeBudget value must be a nonnegative scalar in milliseconds.");
+			}
+			time_budget = mxGetScalar(mx_curr_val);
+		}
+		else if(ImportProgressOption(mx_curr_key, mx_curr_val))
+		{
+			continue;
+		}
+		else if(MEXUtils::CompareMEXString(mx_curr_key, "RDO"))
+		{
+			if(!mxIsNumeric(mx_curr_val) || !mxIsScalar(mx_curr_val) || mxGetScalar(mx_curr_val) < 0)
+			{
+				MEXError::PrintMexError(MEU_FL,
+				                        MEU_SEVERITY_USER,
+				                        "InvalidValueError",
+				                        "RDO value must be a nonnegative scalar lambda.");
+			}
+			rdo_lambda = mxGetScalar(mx_curr_val);
+		}
+		else if(MEXUtils::CompareMEXString(mx_curr_key, "TARGETPSNR"))
+		{
+			if(!mxIsNumeric(mx_curr_val) || !mxIsScalar(mx_curr_val))
+			{
+				MEXError::PrintMexError(MEU_FL,
+				                        MEU_SEVERITY_USER,
+				                        "InvalidValueError",
+				                        "TargetPSNR value must be a scalar in decibels.");
+			}
+			/* DirectXTex measures error on normalized channels, so the peak is 1 */
+			max_mse = std::pow(10.0, -mxGetScalar(mx_curr_val) / 10.0);
+		}
+		else if(MEXUtils::CompareMEXString(mx_curr_key, "MAXMSE"))
+		{
+			if(!mxIsNumeric(mx_curr_val) || !mxIsScalar(mx_curr_val) || mxGetScalar(mx_curr_val) < 0)
+			{
+				MEXError::PrintMexError(MEU_FL,
+				                        MEU_SEVERITY_USER,
+				                        "InvalidValueError",
+				                        "MaxMSE value must be a nonnegative scalar.");
+			}
+			max_mse = mxGetScalar(mx_curr_val);
+		}
+		else if(MEXUtils::CompareMEXString(mx_curr_key, "FASTPATH"))
+		{
+			if(!mxIsLogicalScalar(mx_curr_val))
+			{
+				MEXError::PrintMexError(MEU_FL,
+				                        MEU_SEVERITY_USER,
+				                        "InvalidValueError",
+				                        "FastPath value must be a scalar logical.");
+			}
+			is_fast_path = mxIsLogicalScalarTrue(mx_curr_val);
+		}
+		else
+		{
+			flag_opts.push_back(mx_curr_key);
+			flag_opts.push_back(mx_curr_val);
+		}
+	}
+	g_compressflags.ImportFlags(static_cast<int>(flag_opts.size()), flag_opts.data(), compress_flags);
+	
+	return {fmt, is_auto, variant_formats, compress_flags, threshold, quality, time_budget, rdo_lambda, max_mse, is_fast_path};
+}
+
+size_t DXTImageArray::CompressImages(const CompressOptions& opts)
+{
+	size_t i;
+	std::unique_ptr<DXTImage[]> new_arr = this->CopyDXTImageArray();
+	
+	std::vector<DXGI_FORMAT> formats(this->GetSize(), opts.fmt);
+	if(opts.is_auto)
+	{
+		for(i = 0; i < this->GetSize(); i++)
+		{
+			formats[i] = SelectCompressedFormat(this->GetDXTImage(i), static_cast<float>(opts.max_mse), opts.flags, opts.threshold);
+		}
+	}
+	
+	/* queue the whole array first so small mips and images share the threads, one pass per format */
+	size_t num_fast_blocks = 0;
+	std::vector<bool> is_queued(this->GetSize(), false);
+	for(i = 0; i < this->GetSize(); i++)
+	{
+		if(is_queued[i])
+		{
+			continue;
+		}
+		
+		if(formats[i] == DXGI_FORMAT_UNKNOWN)
+		{
+			/* nothing met the target, so keep the original */
+			new_arr[i] = std::move(this->GetDXTImage(i));
+			is_queued[i] = true;
+			continue;
+		}
+		
+		CompressionScheduler scheduler(formats[i], opts.flags, opts.threshold);
+		if(opts.quality >= 0)
+		{
+			scheduler.SetQuality(static_cast<size_t>(opts.quality));
+		}
+		scheduler.SetTimeBudget(opts.time_budget);
+		scheduler.SetRDO(opts.rdo_lambda);
+		scheduler.SetFastPath(opts.is_fast_path);
+		for(size_t j = i; j < this->GetSize(); j++)
+		{
+			if(!is_queued[j] && formats[j] == formats[i])
+			{
+				scheduler.Add(this->GetDXTImage(j), new_arr[j]);
+				is_queued[j] = true;
+			}
+		}
+		scheduler.Run();
+		num_fast_blocks += scheduler.GetNumFastBlocks();
+	}
+	this->_arr = std::move(new_arr);
+	return num_fast_blocks;
+}
+
+void DXTImageArray::Compress(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[])
+{
+	size_t i;
+	const CompressOptions opts = DXTImageArray::ParseCompressOptions(nrhs, prhs);
+	if(!opts.variant_formats.empty())
+	{
+		this->CompressVariants(nlhs, plhs, opts);
+		return;
+	}
+	
+	const size_t num_fast_blocks = this->CompressImages(opts);
+	this->ToExport(nlhs, plhs);
+	if(nlhs > 1)
+	{
+		plhs[1] = mxCreateDoubleScalar(static_cast<double>(num_fast_blocks));
+	}
+	if(nlhs > 2)
+	{
+		plhs[2] = mxCreateCellMatrix(this->GetM(), this->GetN());
+		for(i = 0; i < this->GetSize(); i++)
+		{
+			mxSetCell(plhs[2], i, mxCreateString(g_format_map.FindStringFromID(this->GetDXTImage(i).GetMetadata().format).c_str()));
+		}
+	}
+	if(nlhs > 3)
+	{
+		plhs[3] = mxCreateDoubleMatrix(this->GetM(), this->GetN(), mxREAL);
+		for(i = 0; i < this->GetSize(); i++)
+		{
+			((double*)mxGetData(plhs[3]))[i] = EstimateBitsPerTexel(this->GetDXTImage(i));
+		}
+	}
+}
+
+void DXTImageArray::CompressVariants(int nlhs, mxArray* plhs[], const CompressOptions& opts)
+{
+	const std::vector<DXGI_FORMAT>& formats = opts.variant_formats;
+	size_t i, k;
+	
+	/* every variant is queued in one pool, so the encodes of all formats run at once */
+	std::vector<std::unique_ptr<DXTImage[]>> variants;
+	CompressionScheduler scheduler(formats[0], opts.flags, opts.threshold);
+	if(opts.quality >= 0)
+	{
+		scheduler.SetQuality(static_cast<size_t>(opts.quality));
+	}
+	scheduler.SetTimeBudget(opts.time_budget);
+	scheduler.SetRDO(opts.rdo_lambda);
+	scheduler.SetFastPath(opts.is_fast_path);
+	for(k = 0; k < formats.size(); k++)
+	{
+		variants.push_back(this->CopyDXTImageArray());
+		for(i = 0; i < this->GetSize(); i++)
+		{
+			scheduler.Add(this->GetDXTImage(i), variants[k][i], formats[k]);
+		}
+	}
+	scheduler.Run();
+	
+	plhs[0] = mxCreateCellMatrix(1, formats.size());
+	if(nlhs > 3)
+	{
+		plhs[3] = mxCreateCellMatrix(1, formats.size());
+	}
+	for(k = 0; k < formats.size(); k++)
+	{
+		DXTImageArray variant;
+		variant._arr  = std::move(variants[k]);
+		variant._sz_m = this->_sz_m;
+		variant._sz_n = this->_sz_n;
+		variant._size = this->_size;
+		
+		if(nlhs > 3)
+		{
+			mxArray* mx_bits = mxCreateDoubleMatrix(this->GetM(), this->GetN(), mxREAL);
+			for(i = 0; i < this->GetSize(); i++)
+			{
+				((double*)mxGetData(mx_bits))[i] = EstimateBitsPerTexel(variant.GetDXTImage(i));
+			}
+			mxSetCell(plhs[3], k, mx_bits);
+		}
+		
+		mxArray* mx_variant;
+		variant.ToExport(1, &mx_variant);
+		mxSetCell(plhs[0], k, mx_variant);
+	}
+	
+	if(nlhs > 1)
+	{
+		plhs[1] = mxCreateDoubleScalar(static_cast<double>(scheduler.GetNumFastBlocks()));
+	}
+	if(nlhs > 2)
+	{
+		plhs[2] = mxCreateCellMatrix(1, formats.size());
+		for(k = 0; k < formats.size(); k++)
+		{
+			mxSetCell(plhs[2], k, mxCreateString(g_format_map.FindStringFromID(formats[k]).c_str()));
+		}
+	}
+}
+
+DXTImageArray::CompressOptions DXTImageArray::ParseTranscodeOptions(int nrhs, const mxArray* prhs[])
+{
+	size_t i;
+	DirectX::TEX_COMPRESS_FLAGS compress_flags = DirectX::TEX_COMPRESS_DEFAULT;
+	float threshold = DirectX::TEX_THRESHOLD_DEFAULT;
+	if(nrhs < 1)
+	{
+		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "NotEnoughArgumentsError", "No enough arguments. Please supply a format.");
+	}
+	
+	DXGI_FORMAT fmt = DXTImageArray::ParseFormat(prhs[0]);
+	if(!DirectX::IsCompressed(fmt))
+	{
+		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "InvalidFormatError", "The target format must be block compressed. Use DECOMPRESS or CONVERT instead.");
+	}
+	
+	int opts_start = 1;
+	if(nrhs > 1 && mxIsDouble(prhs[1]))
+	{
+		if(!mxIsScalar(prhs[1]))
+		{
+			MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "InvalidInputError", "The alpha threshold must be scalar.");
+		}
+		threshold = (float)mxGetScalar(prhs[1]);
+		opts_start = 2;
+	}
+	
+	if(((nrhs - opts_start) % 2) != 0)
+	{
+		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "KeyValueError", "Invalid number of arguments. A key is likely missing a value.");
+	}
+	
+	std::vector<const mxArray*> flag_opts;
+	for(int j = opts_start; j < nrhs; j += 2)
+	{
+		if(!mxIsChar(prhs[j]))
+		{
+			MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "InvalidKeyError", "All keys must be class 'char'.");
+		}
+		MEXUtils::ToUpper(const_cast<mxArray*>(prhs[j]));
+		if(!ImportProgressOption(prhs[j], prhs[j + 1]))
+		{
+			flag_opts.push_back(prhs[j]);
+			flag_opts.push_back(prhs[j + 1]);
+		}
+	}
+	g_compressflags.ImportFlags(static_cast<int>(flag_opts.size()), flag_opts.data(), compress_flags);
+	
+	for(i = 0; i < this->GetSize(); i++)
+	{
+		if(!DirectX::IsCompressed(this->GetDXTImage(i).GetMetadata().format))
+		{
+			MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "InvalidFormatError", "TRANSCODE only accepts block compressed images. Use COMPRESS instead.");
+		}
+	}
+	
+	return {fmt, false, {}, compress_flags, threshold, -1, 0, 0, 0, false};
+}
+
+void DXTImageArray::TranscodeImages(const CompressOptions& opts)
+{
+	size_t i;
+	std::unique_ptr<DXTImage[]> new_arr = this->CopyDXTImageArray();
+	
+	/* the source is never fully decoded, each tile decodes its own block rows right before they are encoded */
+	CompressionScheduler scheduler(opts.fmt, opts.flags, opts.threshold);
+	for(i = 0; i < this->GetSize(); i++)
+	{
+		scheduler.Add(this->GetDXTImage(i), new_arr[i]);
+	}
+	scheduler.Run();
+	this->_arr = std::move(new_arr);
+}
+
+void DXTImageArray::Transcode(int nrhs, const mxArray* prhs[])
+{
+	this->TranscodeImages(this->ParseTranscodeOptions(nrhs, prhs));
+}
+
+DXGI_FORMAT DXTImageArray::ParseDecompressFormat(int nrhs, const mxArray* prhs[])
+{
+	DXGI_FORMAT fmt = DXGI_FORMAT_UNKNOWN;
+	if(nrhs > 1)
+	{
+		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "TooManyArgumentsError", "Too many arguments.");
+	}
+	
+	if(nrhs == 1)
+	{
+		fmt = DXTImageArray::ParseFormat(prhs[0]);
+	}
+	return fmt;
+}
+
+void DXTImageArray::DecompressImages(DXGI_FORMAT fmt)
+{
+	size_t i;
+	std::unique_ptr<DXTImage[]> new_arr = this->CopyDXTImageArray();
+	for(i = 0; i < this->GetSize(); i++)
+	{
+		DXTImage& pre_op  = this->GetDXTImage(i);
+		DXTImage& post_op = new_arr[i];
+		Progress::CheckInterrupt();
+		Trace::Scope trace_scope("DirectX::Decompress", "image");
+		hres = DirectX::Decompress(pre_op.GetImages(), pre_op.GetImageCount(), pre_op.GetMetadata(), fmt, post_op);
+		if(FAILED(hres))
+		{
+			MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_HRESULT, "DecompressError", "There was an error while decompressing the image.");
+		}
+	}
+	this->_arr = std::move(new_arr);
+}
+
+void DXTImageArray::Decompress(int nrhs, const mxArray* prhs[])
+{
+	this->DecompressImages(DXTImageArray::ParseDecompressFormat(nrhs, prhs));
+}
+
+void DXTImageArray::ComputeNormalMap(int nrhs, const mxArray* prhs[])
+{
+	size_t i;
+	std::unique_ptr<DXTImage[]> new_arr = this->CopyDXTImageArray();
+	DXGI_FORMAT fmt;
+	float amplitude;
+	DirectX::CNMAP_FLAGS cn_flags = DirectX::CNMAP_DEFAULT;
+	if(nrhs < 2)
+	{
+		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "NotEnoughArgumentsError", "No enough arguments. Please supply a format and an amplitude.");
+	}
+	
+	fmt = DXTImageArray::ParseFormat(prhs[0]);
+	
+	if(!mxIsDouble(prhs[1]) || !mxIsScalar(prhs[1]))
 	{
 		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "InvalidSizeError", "Amplitude must be a scalar double.");
 	}
@@ -1369,6 +1867,7 @@ void DXTImageArray::ComputeNormalMap(int nrhs, const mxArray* prhs[])
 	{
 		DXTImage& pre_op  = this->GetDXTImage(i);
 		DXTImage& post_op = new_arr[i];
+		Trace::Scope trace_scope("DirectX::ComputeNormalMap", "image");
 		hres = DirectX::ComputeNormalMap(pre_op.GetImages(), pre_op.GetImageCount(), pre_op.GetMetadata(), cn_flags, amplitude, fmt, post_op);
 		if(FAILED(hres))
 		{
@@ -1378,6 +1877,16 @@ void DXTImageArray::ComputeNormalMap(int nrhs, const mxArray* prhs[])
 	this->_arr = std::move(new_arr);
 }
 
+/* DirectXTex cannot copy between compressed images, those are done block by block */
+static HRESULT CopyImageRectangle(const DirectX::Image& src, const DirectX::Rect& rect, const DirectX::Image& dst, DirectX::TEX_FILTER_FLAGS filter_flags, size_t x_offset, size_t y_offset)
+{
+	if(DirectX::IsCompressed(src.format) && DirectX::IsCompressed(dst.format))
+	{
+		return BlockOps::CopyRectangle(src, rect, dst, x_offset, y_offset);
+	}
+	return DirectX::CopyRectangle(src, rect, dst, filter_flags, x_offset, y_offset);
+}
+
 void DXTImageArray::CopyRectangle(DXTImageArray& dst, DXTImageArray& src, int nrhs, const mxArray* prhs[])
 {
 	size_t i, j;
@@ -1422,7 +1931,8 @@ void DXTImageArray::CopyRectangle(DXTImageArray& dst, DXTImageArray& src, int nr
 				auto dst_slices = dst.GetDXTImage(i).GetImages();
 				for(j = 0; j < dst_dxtimage.GetImageCount(); j++)
 				{
-					hres = DirectX::CopyRectangle(*src_slices, rect, *(dst_slices + j), filter_flags, out_x, out_y);
+					Trace::Scope trace_scope("CopyImageRectangle", "image");
+					hres = CopyImageRectangle(*src_slices, rect, *(dst_slices + j), filter_flags, out_x, out_y);
 					if(FAILED(hres))
 					{
 						MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_HRESULT, "CopyRectangleError", "There was an error while copying over the rectangle.");
@@ -1442,7 +1952,8 @@ void DXTImageArray::CopyRectangle(DXTImageArray& dst, DXTImageArray& src, int nr
 				auto dst_slices = dst_dxtimage.GetImages();
 				for(j = 0; j < src_dxtimage.GetImageCount(); j++)
 				{
-					hres = DirectX::CopyRectangle(*(src_slices + j), rect, *(dst_slices + j), filter_flags, out_x, out_y);
+					Trace::Scope trace_scope("CopyImageRectangle", "image");
+					hres = CopyImageRectangle(*(src_slices + j), rect, *(dst_slices + j), filter_flags, out_x, out_y);
 					if(FAILED(hres))
 					{
 						MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_HRESULT, "CopyRectangleError", "There was an error while copying over the rectangle.");
@@ -1472,7 +1983,8 @@ void DXTImageArray::CopyRectangle(DXTImageArray& dst, DXTImageArray& src, int nr
 			auto dst_slices = dst_dxtimage.GetImages();
 			for(j = 0; j < src_dxtimage.GetImageCount(); j++)
 			{
-				hres = DirectX::CopyRectangle(*(src_slices + j), rect, *(dst_slices + j), filter_flags, out_x, out_y);
+				Trace::Scope trace_scope("CopyImageRectangle", "image");
+				hres = CopyImageRectangle(*(src_slices + j), rect, *(dst_slices + j), filter_flags, out_x, out_y);
 				if(FAILED(hres))
 				{
 					MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_HRESULT, "CopyRectangleError", "There was an error while copying over the rectangle.");
@@ -1482,117 +1994,376 @@ void DXTImageArray::CopyRectangle(DXTImageArray& dst, DXTImageArray& src, int nr
 	}
 }
 
+void DXTImageArray::UpdateRegion(DXTImageArray& dst, DXTImageArray& src, int nrhs, const mxArray* prhs[])
+{
+	size_t i, j;
+	DirectX::TEX_FILTER_FLAGS filter_flags = DirectX::TEX_FILTER_DEFAULT;
+	size_t out_x;
+	size_t out_y;
+	if(nrhs < 1)
+	{
+		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "NotEnoughArgumentsError", "No enough arguments. Please supply a 2-element vector specifying the destination coordinates.");
+	}
+	
+	if(!mxIsDouble(prhs[0]) || mxGetNumberOfElements(prhs[0]) != 2)
+	{
+		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "InvalidSizeError", "The destination specifier must be of class 'double' and have 2 elements.");
+	}
+	auto data = (double*)mxGetData(prhs[0]);
+	out_x = (size_t)data[1];
+	out_y = (size_t)data[0];
+	
+	if(nrhs > 1)
+	{
+		g_filterflags.ImportFlags(nrhs - 1, prhs + 1, filter_flags);
+	}
+	
+	if(src.GetSize() != 1 && src.GetSize() != dst.GetSize())
+	{
+		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "InputMismatchError", "The source and destination arguments are not the same size.");
+	}
+	
+	for(i = 0; i < dst.GetSize(); i++)
+	{
+		DXTImage& src_dxtimage = src.GetDXTImage(src.GetSize() == 1? 0 : i);
+		DXTImage& dst_dxtimage = dst.GetDXTImage(i);
+		const size_t num_items = dst_dxtimage.GetMetadata().arraySize;
+		
+		/* the new pixels are the top level of each source item, one item is used for all */
+		const size_t num_src_items = src_dxtimage.GetMetadata().arraySize;
+		if(num_src_items != 1 && num_src_items != num_items)
+		{
+			MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "InputMismatchError", "The source must have either one array item or as many as the destination.");
+		}
+		
+		for(j = 0; j < num_items; j++)
+		{
+			const DirectX::Image* pixels = src_dxtimage.GetImage(0, num_src_items == 1? 0 : j, 0);
+			Trace::Scope trace_scope("BlockOps::UpdateRegion", "image");
+			hres = BlockOps::UpdateRegion(dst_dxtimage, j, *pixels, out_x, out_y, filter_flags);
+			if(FAILED(hres))
+			{
+				MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_HRESULT, "UpdateRegionError", "There was an error while updating the region.");
+			}
+		}
+	}
+}
+
 void DXTImageArray::ComputeMSE(DXTImageArray& dxtimagearray1, DXTImageArray& dxtimagearray2, int nlhs, mxArray *plhs[], int nrhs, const mxArray* prhs[])
 {
-	size_t i;
 	DirectX::CMSE_FLAGS cmse_flags = DirectX::CMSE_DEFAULT;
-	g_cmseflags.ImportFlags(nrhs, prhs, cmse_flags);
 	
-	if(dxtimagearray1.GetSize() != dxtimagearray2.GetSize())
+	if((nrhs % 2) != 0)
 	{
-		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "InputMismatchError", "The comparison arguments are not the same size.");
+		MEXError::PrintMexError(MEU_FL,
+		                        MEU_SEVERITY_USER,
+		                        "KeyValueError",
+		                        "Invalid number of arguments. A key is likely missing a value.");
 	}
 	
-	if(dxtimagearray1.GetSize() == 1)
+	/* pick out the map options, everything else is a comparison flag */
+	size_t block_size = 4;
+	std::vector<const mxArray*> flag_opts;
+	for(int n = 0; n < nrhs; n += 2)
 	{
-		if(nlhs > 1)
+		const mxArray* mx_curr_key = prhs[n];
+		const mxArray* mx_curr_val = prhs[n + 1];
+		if(!mxIsChar(mx_curr_key))
+		{
+			MEXError::PrintMexError(MEU_FL,
+			                        MEU_SEVERITY_USER,
+			                        "InvalidKeyError",
+			                        "All keys must be class 'char'.");
+		}
+		MEXUtils::ToUpper(const_cast<mxArray*>(mx_curr_key));
+		if(MEXUtils::CompareMEXString(mx_curr_key, "BLOCKSIZE"))
 		{
-			mxArray* tmp[2];
-			plhs[0] = mxCreateCellMatrix(dxtimagearray1.GetM(), dxtimagearray1.GetN());
-			plhs[1] = mxCreateCellMatrix(dxtimagearray1.GetM(), dxtimagearray1.GetN());
-			for(i = 0; i < dxtimagearray1.GetSize(); i++)
+			if(!mxIsNumeric(mx_curr_val) || !mxIsScalar(mx_curr_val) || mxGetScalar(mx_curr_val) < 1 || mxGetScalar(mx_curr_val) != std::floor(mxGetScalar(mx_curr_val)))
 			{
-				DXTImageArray::ComputeMSE(dxtimagearray1.GetDXTImage(i), dxtimagearray2.GetDXTImage(i), cmse_flags, tmp[0], tmp[1]);
-				mxSetCell(plhs[0], i, tmp[0]);
-				mxSetCell(plhs[1], i, tmp[1]);
+				MEXError::PrintMexError(MEU_FL,
+				                        MEU_SEVERITY_USER,
+				                        "InvalidValueError",
+				                        "BlockSize value must be a positive integer.");
 			}
+			block_size = static_cast<size_t>(mxGetScalar(mx_curr_val));
 		}
 		else
 		{
-			mxArray* tmp;
-			plhs[0] = mxCreateCellMatrix(dxtimagearray1.GetM(), dxtimagearray1.GetN());
-			for(i = 0; i < dxtimagearray1.GetSize(); i++)
-			{
-				DXTImageArray::ComputeMSE(dxtimagearray1.GetDXTImage(i), dxtimagearray2.GetDXTImage(i), cmse_flags, tmp);
-				mxSetCell(plhs[0], i, tmp);
-			}
+			flag_opts.push_back(mx_curr_key);
+			flag_opts.push_back(mx_curr_val);
 		}
 	}
-	else
+	g_cmseflags.ImportFlags(static_cast<int>(flag_opts.size()), flag_opts.data(), cmse_flags);
+	
+	/* outputs are mse, mseV, psnr, the maximum error per channel and the error map */
+	const int num_outputs = std::min(std::max(nlhs, 1), 5);
+	
+	/* every subresource of the array is compared in one parallel pass */
+	std::vector<Metrics::ErrorResult> results;
+	std::vector<mwIndex> mex_indices;
+	std::vector<size_t> first_results;
+	DXTImageArray::PairSubresources(dxtimagearray1, dxtimagearray2, results, mex_indices, first_results);
+	
+	Stats::AddSubresources(results.size());
+	hres = Metrics::ComputeError(results, cmse_flags, (num_outputs > 4)? block_size : 0);
+	if(FAILED(hres))
 	{
-		if(nlhs > 1)
+		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_HRESULT, "ComputeMSEError", "There was an error while computing the mean-squared error.");
+	}
+	
+	DXTImageArray::ExportComparison(dxtimagearray1, results, mex_indices, first_results, num_outputs, plhs);
+}
+
+void DXTImageArray::ComputeSSIM(DXTImageArray& dxtimagearray1, DXTImageArray& dxtimagearray2, int nlhs, mxArray *plhs[], int nrhs, const mxArray* prhs[])
+{
+	DirectX::CMSE_FLAGS cmse_flags = DirectX::CMSE_DEFAULT;
+	
+	if((nrhs % 2) != 0)
+	{
+		MEXError::PrintMexError(MEU_FL,
+		                        MEU_SEVERITY_USER,
+		                        "KeyValueError",
+		                        "Invalid number of arguments. A key is likely missing a value.");
+	}
+	
+	/* pick out the multi-scale option, everything else is a comparison flag */
+	bool is_multiscale = false;
+	std::vector<const mxArray*> flag_opts;
+	for(int n = 0; n < nrhs; n += 2)
+	{
+		const mxArray* mx_curr_key = prhs[n];
+		const mxArray* mx_curr_val = prhs[n + 1];
+		if(!mxIsChar(mx_curr_key))
 		{
-			DXTImageArray::ComputeMSE(dxtimagearray1.GetDXTImage(0), dxtimagearray2.GetDXTImage(0), cmse_flags, plhs[0], plhs[1]);
+			MEXError::PrintMexError(MEU_FL,
+			                        MEU_SEVERITY_USER,
+			                        "InvalidKeyError",
+			                        "All keys must be class 'char'.");
+		}
+		MEXUtils::ToUpper(const_cast<mxArray*>(mx_curr_key));
+		if(MEXUtils::CompareMEXString(mx_curr_key, "MULTISCALE"))
+		{
+			if(!(mxIsLogical(mx_curr_val) || mxIsNumeric(mx_curr_val)) || !mxIsScalar(mx_curr_val))
+			{
+				MEXError::PrintMexError(MEU_FL,
+				                        MEU_SEVERITY_USER,
+				                        "InvalidValueError",
+				                        "MultiScale value must be a scalar logical.");
+			}
+			is_multiscale = (mxGetScalar(mx_curr_val) != 0);
 		}
 		else
 		{
-			DXTImageArray::ComputeMSE(dxtimagearray1.GetDXTImage(0), dxtimagearray2.GetDXTImage(0), cmse_flags, plhs[0]);
+			flag_opts.push_back(mx_curr_key);
+			flag_opts.push_back(mx_curr_val);
 		}
 	}
+	g_cmseflags.ImportFlags(static_cast<int>(flag_opts.size()), flag_opts.data(), cmse_flags);
+	
+	/* outputs are ssim, ssimV and the single-scale similarity map */
+	const int num_outputs = std::min(std::max(nlhs, 1), 3);
+	
+	std::vector<Metrics::SSIMResult> results;
+	std::vector<mwIndex> mex_indices;
+	std::vector<size_t> first_results;
+	DXTImageArray::PairSubresources(dxtimagearray1, dxtimagearray2, results, mex_indices, first_results);
+	
+	Stats::AddSubresources(results.size());
+	hres = Metrics::ComputeSSIM(results, cmse_flags, is_multiscale, num_outputs > 2);
+	if(FAILED(hres))
+	{
+		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_HRESULT, "ComputeSSIMError", "There was an error while computing the structural similarity.");
+	}
+	
+	DXTImageArray::ExportComparison(dxtimagearray1, results, mex_indices, first_results, num_outputs, plhs);
 }
 
-void DXTImageArray::ComputeMSE(DXTImage& dxtimage1, DXTImage& dxtimage2, DirectX::CMSE_FLAGS cmse_flags, mxArray*& mx_dxtimage_mse, mxArray*& mx_dxtimage_mseV)
+void DXTImageArray::CompressionReport(DXTImageArray& src, DXTImageArray& cmp, int, mxArray* plhs[], int nrhs, const mxArray* prhs[])
 {
-	size_t i, j, k;
-	mxArray* tmp_mse,* tmp_mseV;
-	if(dxtimage1.GetImageCount() != dxtimage2.GetImageCount())
+	size_t i, k;
+	DirectX::CMSE_FLAGS cmse_flags = DirectX::CMSE_DEFAULT;
+	
+	if((nrhs % 2) != 0)
 	{
-		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "InputMismatchError", "The source and destination arguments are not the same size.");
+		MEXError::PrintMexError(MEU_FL,
+		                        MEU_SEVERITY_USER,
+		                        "KeyValueError",
+		                        "Invalid number of arguments. A key is likely missing a value.");
 	}
-	if(dxtimage1.GetImageCount() == 1)
+	
+	/* pick out the report options, everything else is a comparison flag */
+	size_t top_k = 16;
+	std::vector<double> edges;
+	for(double edge = 10.0; edge <= 60.0; edge += 2.0)
 	{
-		DXTImageArray::ComputeMSE(dxtimage1.GetImage(0, 0, 0), dxtimage2.GetImage(0, 0, 0), cmse_flags, mx_dxtimage_mse, mx_dxtimage_mseV);
+		edges.push_back(edge);
 	}
-	else
+	std::vector<const mxArray*> flag_opts;
+	for(int n = 0; n < nrhs; n += 2)
 	{
-		DirectX::TexMetadata metadata = dxtimage1.GetMetadata();
-		size_t depth = metadata.depth;
-		mx_dxtimage_mse = mxCreateCellMatrix(std::max(metadata.arraySize, metadata.depth), metadata.mipLevels);
-		mx_dxtimage_mseV = mxCreateCellMatrix(std::max(metadata.arraySize, metadata.depth), metadata.mipLevels);
-		for(i = 0; i < metadata.mipLevels; i++)
+		const mxArray* mx_curr_key = prhs[n];
+		const mxArray* mx_curr_val = prhs[n + 1];
+		if(!mxIsChar(mx_curr_key))
+		{
+			MEXError::PrintMexError(MEU_FL,
+			                        MEU_SEVERITY_USER,
+			                        "InvalidKeyError",
+			                        "All keys must be class 'char'.");
+		}
+		MEXUtils::ToUpper(const_cast<mxArray*>(mx_curr_key));
+		if(MEXUtils::CompareMEXString(mx_curr_key, "TOPK"))
 		{
-			for(j = 0; j < metadata.arraySize; j++)
+			if(!mxIsNumeric(mx_curr_val) || !mxIsScalar(mx_curr_val) || mxGetScalar(mx_curr_val) < 0 || mxGetScalar(mx_curr_val) != std::floor(mxGetScalar(mx_curr_val)))
 			{
-				for(k = 0; k < depth; k++)
-				{
-					DXTImageArray::ComputeMSE(dxtimage1.GetImage(i, j, k), dxtimage2.GetImage(i, j, k), cmse_flags, tmp_mse, tmp_mseV);
-					mxSetCell(mx_dxtimage_mse,  dxtimage1.ComputeIndexMEX(i, j, k), tmp_mse);
-					mxSetCell(mx_dxtimage_mseV, dxtimage1.ComputeIndexMEX(i, j, k), tmp_mseV);
-				}
+				MEXError::PrintMexError(MEU_FL,
+				                        MEU_SEVERITY_USER,
+				                        "InvalidValueError",
+				                        "TopK value must be a nonnegative integer.");
 			}
-			if(depth > 1)
+			top_k = static_cast<size_t>(mxGetScalar(mx_curr_val));
+		}
+		else if(MEXUtils::CompareMEXString(mx_curr_key, "EDGES"))
+		{
+			if(!mxIsDouble(mx_curr_val) || mxIsComplex(mx_curr_val) || mxIsEmpty(mx_curr_val))
 			{
-				depth >>= 1u;
+				MEXError::PrintMexError(MEU_FL,
+				                        MEU_SEVERITY_USER,
+				                        "InvalidValueError",
+				                        "Edges value must be a nonempty real double vector.");
 			}
+			const double* data = (const double*)mxGetData(mx_curr_val);
+			edges.assign(data, data + mxGetNumberOfElements(mx_curr_val));
+			for(k = 1; k < edges.size(); k++)
+			{
+				if(!(edges[k - 1] < edges[k]))
+				{
+					MEXError::PrintMexError(MEU_FL,
+					                        MEU_SEVERITY_USER,
+					                        "InvalidValueError",
+					                        "Edges value must be strictly increasing.");
+				}
+			}
+		}
+		else
+		{
+			flag_opts.push_back(mx_curr_key);
+			flag_opts.push_back(mx_curr_val);
+		}
+	}
+	g_cmseflags.ImportFlags(static_cast<int>(flag_opts.size()), flag_opts.data(), cmse_flags);
+	
+	for(i = 0; i < cmp.GetSize(); i++)
+	{
+		if(!DirectX::IsCompressed(cmp.GetDXTImage(i).GetMetadata().format))
+		{
+			MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "InvalidFormatError", "The compressed argument must be block compressed. Use COMPUTE_MSE instead.");
 		}
 	}
+	
+	std::vector<Metrics::ErrorResult> results;
+	std::vector<mwIndex> mex_indices;
+	std::vector<size_t> first_results;
+	std::vector<SubresourceIndex> locations;
+	DXTImageArray::PairSubresources(src, cmp, results, mex_indices, first_results, &locations);
+	
+	Stats::AddSubresources(results.size());
+	Metrics::BlockReport report;
+	hres = Metrics::ComputeBlockReport(results, cmse_flags, edges, top_k, report);
+	if(FAILED(hres))
+	{
+		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_HRESULT, "CompressionReportError", "There was an error while computing the compression report.");
+	}
+	
+	/* indices are 1-based like the rest of MATLAB, the bins are open at both ends */
+	const char* hist_fields[] = {"Edges", "Counts"};
+	mxArray* mx_hist = mxCreateStructMatrix(1, 1, ARRAYSIZE(hist_fields), hist_fields);
+	mxArray* mx_edges = mxCreateDoubleMatrix(1, edges.size() + 2, mxREAL);
+	mxArray* mx_counts = mxCreateDoubleMatrix(1, report.counts.size(), mxREAL);
+	double* edges_data = (double*)mxGetData(mx_edges);
+	edges_data[0] = -std::numeric_limits<double>::infinity();
+	std::copy(edges.begin(), edges.end(), edges_data + 1);
+	edges_data[edges.size() + 1] = std::numeric_limits<double>::infinity();
+	std::copy(report.counts.begin(), report.counts.end(), (double*)mxGetData(mx_counts));
+	mxSetField(mx_hist, 0, "Edges", mx_edges);
+	mxSetField(mx_hist, 0, "Counts", mx_counts);
+	
+	const char* block_fields[] = {"Image", "Mip", "Item", "Slice", "Row", "Column", "MSE", "PSNR"};
+	mxArray* mx_worst = mxCreateStructMatrix(report.worst.size(), 1, ARRAYSIZE(block_fields), block_fields);
+	for(k = 0; k < report.worst.size(); k++)
+	{
+		const Metrics::BlockEntry& entry = report.worst[k];
+		const SubresourceIndex& location = locations[entry.result];
+		mxSetField(mx_worst, k, "Image",  mxCreateDoubleScalar(static_cast<double>(location.image + 1)));
+		mxSetField(mx_worst, k, "Mip",    mxCreateDoubleScalar(static_cast<double>(location.mip + 1)));
+		mxSetField(mx_worst, k, "Item",   mxCreateDoubleScalar(static_cast<double>(location.item + 1)));
+		mxSetField(mx_worst, k, "Slice",  mxCreateDoubleScalar(static_cast<double>(location.slice + 1)));
+		mxSetField(mx_worst, k, "Row",    mxCreateDoubleScalar(static_cast<double>(entry.y + 1)));
+		mxSetField(mx_worst, k, "Column", mxCreateDoubleScalar(static_cast<double>(entry.x + 1)));
+		mxSetField(mx_worst, k, "MSE",    mxCreateDoubleScalar(entry.mse));
+		mxSetField(mx_worst, k, "PSNR",   mxCreateDoubleScalar((entry.mse == 0.0)? std::numeric_limits<double>::infinity() : -10.0 * std::log10(entry.mse)));
+	}
+	
+	const char* fieldnames[] = {"NumBlocks", "MSE", "MSEV", "PSNR", "MaxError", "MeanBlockMSE", "StdBlockMSE", "Histogram", "WorstBlocks"};
+	plhs[0] = mxCreateStructMatrix(1, 1, ARRAYSIZE(fieldnames), fieldnames);
+	mxArray* mx_msev = mxCreateDoubleMatrix(4, 1, mxREAL);
+	mxArray* mx_max_abs = mxCreateDoubleMatrix(4, 1, mxREAL);
+	std::copy(report.mseV, report.mseV + 4, (double*)mxGetData(mx_msev));
+	std::copy(report.max_abs, report.max_abs + 4, (double*)mxGetData(mx_max_abs));
+	mxSetField(plhs[0], 0, "NumBlocks",    mxCreateDoubleScalar(static_cast<double>(report.num_blocks)));
+	mxSetField(plhs[0], 0, "MSE",          mxCreateDoubleScalar(report.mse));
+	mxSetField(plhs[0], 0, "MSEV",         mx_msev);
+	mxSetField(plhs[0], 0, "PSNR",         mxCreateDoubleScalar(report.psnr));
+	mxSetField(plhs[0], 0, "MaxError",     mx_max_abs);
+	mxSetField(plhs[0], 0, "MeanBlockMSE", mxCreateDoubleScalar(report.mean_block_mse));
+	mxSetField(plhs[0], 0, "StdBlockMSE",  mxCreateDoubleScalar(report.std_block_mse));
+	mxSetField(plhs[0], 0, "Histogram",    mx_hist);
+	mxSetField(plhs[0], 0, "WorstBlocks",  mx_worst);
 }
 
-void DXTImageArray::ComputeMSE(DXTImage& dxtimage1, DXTImage& dxtimage2, DirectX::CMSE_FLAGS cmse_flags, mxArray*& mx_dxtimage_mse)
+template <typename R>
+void DXTImageArray::PairSubresources(DXTImageArray& dxtimagearray1, DXTImageArray& dxtimagearray2, std::vector<R>& results, std::vector<mwIndex>& mex_indices, std::vector<size_t>& first_results,
+                                     std::vector<SubresourceIndex>* locations)
 {
-	size_t i, j, k;
-	mxArray* tmp_mse;
-	if(dxtimage1.GetImageCount() != dxtimage2.GetImageCount())
-	{
-		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "InputMismatchError", "The source and destination arguments are not the same size.");
-	}
-	if(dxtimage1.GetImageCount() == 1)
+	size_t i, j, k, m;
+	if(dxtimagearray1.GetSize() != dxtimagearray2.GetSize())
 	{
-		DXTImageArray::ComputeMSE(dxtimage1.GetImage(0, 0, 0), dxtimage2.GetImage(0, 0, 0), cmse_flags, mx_dxtimage_mse);
+		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "InputMismatchError", "The comparison arguments are not the same size.");
 	}
-	else
+	
+	first_results.resize(dxtimagearray1.GetSize());
+	for(i = 0; i < dxtimagearray1.GetSize(); i++)
 	{
-		DirectX::TexMetadata metadata = dxtimage1.GetMetadata();
+		DXTImage& dxtimage1 = dxtimagearray1.GetDXTImage(i);
+		DXTImage& dxtimage2 = dxtimagearray2.GetDXTImage(i);
+		if(dxtimage1.GetImageCount() != dxtimage2.GetImageCount())
+		{
+			MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "InputMismatchError", "The source and destination arguments are not the same size.");
+		}
+		
+		first_results[i] = results.size();
+		const DirectX::TexMetadata& metadata = dxtimage1.GetMetadata();
 		size_t depth = metadata.depth;
-		mx_dxtimage_mse = mxCreateCellMatrix(std::max(metadata.arraySize, metadata.depth), metadata.mipLevels);
-		for(i = 0; i < metadata.mipLevels; i++)
+		for(j = 0; j < metadata.mipLevels; j++)
 		{
-			for(j = 0; j < metadata.arraySize; j++)
+			for(k = 0; k < metadata.arraySize; k++)
 			{
-				for(k = 0; k < depth; k++)
+				for(m = 0; m < depth; m++)
 				{
-					DXTImageArray::ComputeMSE(dxtimage1.GetImage(i, j, k), dxtimage2.GetImage(i, j, k), cmse_flags, tmp_mse);
-					mxSetCell(mx_dxtimage_mse,  dxtimage1.ComputeIndexMEX(i, j, k), tmp_mse);
+					const DirectX::Image* img1 = dxtimage1.GetImage(j, k, m);
+					const DirectX::Image* img2 = dxtimage2.GetImage(j, k, m);
+					if(img2 == nullptr || img1->width != img2->width || img1->height != img2->height)
+					{
+						MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "InputMismatchError", "The compared subresources are not the same size.");
+					}
+					R result = {};
+					result.image1 = img1;
+					result.image2 = img2;
+					results.push_back(std::move(result));
+					mex_indices.push_back(dxtimage1.ComputeIndexMEX(j, k, m));
+					if(locations != nullptr)
+					{
+						locations->push_back({i, j, k, m});
+					}
 				}
 			}
 			if(depth > 1)
@@ -1603,33 +2374,95 @@ void DXTImageArray::ComputeMSE(DXTImage& dxtimage1, DXTImage& dxtimage2, DirectX
 	}
 }
 
-void DXTImageArray::ComputeMSE(const DirectX::Image* img1, const DirectX::Image* img2, DirectX::CMSE_FLAGS cmse_flags, mxArray*& mx_dxtimageslice_mse)
+template <typename R>
+void DXTImageArray::ExportComparison(DXTImageArray& dxtimagearray, const std::vector<R>& results, const std::vector<mwIndex>& mex_indices, const std::vector<size_t>& first_results, int num_outputs, mxArray* outputs[])
 {
-	float mse;
-	hres = DirectX::ComputeMSE(*img1, *img2, mse, nullptr, cmse_flags);
-	if(FAILED(hres))
+	size_t i;
+	int k;
+	if(dxtimagearray.GetSize() == 1)
 	{
-		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_HRESULT, "ComputeMSEError", "There was an error while computing the mean-squared error.");
+		DXTImageArray::ExportComparison(dxtimagearray.GetDXTImage(0), results.data(), mex_indices.data(), num_outputs, outputs);
+		return; // EARLY RETURN
+	}
+	
+	for(k = 0; k < num_outputs; k++)
+	{
+		outputs[k] = mxCreateCellMatrix(dxtimagearray.GetM(), dxtimagearray.GetN());
+	}
+	for(i = 0; i < dxtimagearray.GetSize(); i++)
+	{
+		mxArray* tmp[5];
+		DXTImageArray::ExportComparison(dxtimagearray.GetDXTImage(i), results.data() + first_results[i], mex_indices.data() + first_results[i], num_outputs, tmp);
+		for(k = 0; k < num_outputs; k++)
+		{
+			mxSetCell(outputs[k], i, tmp[k]);
+		}
 	}
-	mx_dxtimageslice_mse = mxCreateDoubleScalar((double)mse);
 }
 
-void DXTImageArray::ComputeMSE(const DirectX::Image* img1, const DirectX::Image* img2, DirectX::CMSE_FLAGS cmse_flags, mxArray*& mx_dxtimageslice_mse, mxArray*& mx_dxtimageslice_mseV)
+template <typename R>
+void DXTImageArray::ExportComparison(DXTImage& dxtimage, const R* results, const mwIndex* mex_indices, int num_outputs, mxArray* outputs[])
 {
-	float mse;
-	float mseV[4];
-	hres = DirectX::ComputeMSE(*img1, *img2, mse, mseV, cmse_flags);
-	if(FAILED(hres))
+	int k;
+	if(dxtimage.GetImageCount() == 1)
 	{
-		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_HRESULT, "ComputeMSEError", "There was an error while computing the mean-squared error.");
+		DXTImageArray::ExportResult(results[0], num_outputs, outputs);
+		return; // EARLY RETURN
+	}
+	
+	const DirectX::TexMetadata& metadata = dxtimage.GetMetadata();
+	for(k = 0; k < num_outputs; k++)
+	{
+		outputs[k] = mxCreateCellMatrix(std::max(metadata.arraySize, metadata.depth), metadata.mipLevels);
+	}
+	for(size_t i = 0; i < dxtimage.GetImageCount(); i++)
+	{
+		mxArray* tmp[5];
+		DXTImageArray::ExportResult(results[i], num_outputs, tmp);
+		for(k = 0; k < num_outputs; k++)
+		{
+			mxSetCell(outputs[k], mex_indices[i], tmp[k]);
+		}
+	}
+}
+
+void DXTImageArray::ExportResult(const Metrics::ErrorResult& result, int num_outputs, mxArray* outputs[])
+{
+	outputs[0] = mxCreateDoubleScalar(result.mse);
+	if(num_outputs > 1)
+	{
+		outputs[1] = mxCreateDoubleMatrix(4, 1, mxREAL);
+		std::copy(result.mseV, result.mseV + 4, (double*)mxGetData(outputs[1]));
+	}
+	if(num_outputs > 2)
+	{
+		outputs[2] = mxCreateDoubleScalar(result.psnr);
+	}
+	if(num_outputs > 3)
+	{
+		outputs[3] = mxCreateDoubleMatrix(4, 1, mxREAL);
+		std::copy(result.max_abs, result.max_abs + 4, (double*)mxGetData(outputs[3]));
+	}
+	if(num_outputs > 4)
+	{
+		outputs[4] = mxCreateDoubleMatrix(result.map_height, result.map_width, mxREAL);
+		std::copy(result.map.begin(), result.map.end(), (double*)mxGetData(outputs[4]));
+	}
+}
+
+void DXTImageArray::ExportResult(const Metrics::SSIMResult& result, int num_outputs, mxArray* outputs[])
+{
+	outputs[0] = mxCreateDoubleScalar(result.ssim);
+	if(num_outputs > 1)
+	{
+		outputs[1] = mxCreateDoubleMatrix(4, 1, mxREAL);
+		std::copy(result.ssimV, result.ssimV + 4, (double*)mxGetData(outputs[1]));
+	}
+	if(num_outputs > 2)
+	{
+		outputs[2] = mxCreateNumericMatrix(result.image1->height, result.image1->width, mxSINGLE_CLASS, mxREAL);
+		std::copy(result.map.begin(), result.map.end(), (float*)mxGetData(outputs[2]));
 	}
-	mx_dxtimageslice_mse = mxCreateDoubleScalar(mse);
-	mx_dxtimageslice_mseV = mxCreateDoubleMatrix(4, 1, mxREAL);
-	auto data = (double*)mxGetData(mx_dxtimageslice_mseV);
-	data[0] = (double)mseV[0];
-	data[1] = (double)mseV[1];
-	data[2] = (double)mseV[2];
-	data[3] = (double)mseV[3];
 }
 
 void DXTImageArray::WriteDDS(int nrhs, const mxArray* prhs[])
@@ -1664,6 +2497,7 @@ void DXTImageArray::WriteDDS(int nrhs, const mxArray* prhs[])
 			{
 				std::wstring out_fn = filename + std::to_wstring(i).append(ext);
 				DXTImage& pre_op = this->GetDXTImage(i);
+				Trace::Scope trace_scope("DirectX::SaveToDDSFile", "file");
 				hres = DirectX::SaveToDDSFile(pre_op.GetImages(), pre_op.GetImageCount(), pre_op.GetMetadata(), ctrl_flags, out_fn.c_str());
 				if(FAILED(hres))
 				{
@@ -1674,6 +2508,7 @@ void DXTImageArray::WriteDDS(int nrhs, const mxArray* prhs[])
 		else
 		{
 			DXTImage& dxt_image = this->GetDXTImage(0);
+			Trace::Scope trace_scope("DirectX::SaveToDDSFile", "file");
 			hres = DirectX::SaveToDDSFile(dxt_image.GetImages(), dxt_image.GetImageCount(), dxt_image.GetMetadata(), ctrl_flags, filename.c_str());
 			if(FAILED(hres))
 			{
@@ -1692,6 +2527,7 @@ void DXTImageArray::WriteDDS(int nrhs, const mxArray* prhs[])
 		{
 			DXTImageArray::ImportFilename(mxGetCell(prhs[0], i), filename);
 			DXTImage& pre_op = this->GetDXTImage(i);
+			Trace::Scope trace_scope("DirectX::SaveToDDSFile", "file");
 			hres = DirectX::SaveToDDSFile(pre_op.GetImages(), pre_op.GetImageCount(), pre_op.GetMetadata(), ctrl_flags, filename.c_str());
 			if(FAILED(hres))
 			{
@@ -1920,16 +2756,23 @@ void DXTImageArray::WriteTGA(int nrhs, const mxArray* prhs[])
 
 void DXTImageArray::ToImage(int nlhs, mxArray *plhs[], int nrhs, const mxArray* prhs[])
 {
-	size_t i;
+	Stats::Timer timer(Stats::PHASE::EXPORT);
+	int i;
+	size_t j;
 	bool combine_alpha = false;
-	if(nrhs > 2)
+	mxArray* mx_target = nullptr;
+	
+	if(nrhs % 2 != 0)
 	{
-		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "TooManyArgumentsError", "Too many arguments.");
+		MEXError::PrintMexError(MEU_FL,
+		                        MEU_SEVERITY_USER,
+		                        "KeyValueError",
+		                        "Invalid number of arguments. The key '%s' is missing a value.", mxIsChar(prhs[nrhs - 1])? mxArrayToString(prhs[nrhs - 1]) : "");
 	}
 	
-	if(nrhs > 0)
+	for(i = 0; i < nrhs; i += 2)
 	{
-		if(!mxIsChar(prhs[0]))
+		if(!mxIsChar(prhs[i]))
 		{
 			MEXError::PrintMexError(MEU_FL,
 			                        MEU_SEVERITY_USER,
@@ -1937,37 +2780,45 @@ void DXTImageArray::ToImage(int nlhs, mxArray *plhs[], int nrhs, const mxArray*
 			                        "All keys must be class 'char'.");
 		}
 		
-		if(nrhs == 1)
+		MEXUtils::ToUpper((mxArray*)prhs[i]);
+		if(MEXUtils::CompareMEXString(prhs[i], "COMBINEALPHA"))
 		{
-			MEXError::PrintMexError(MEU_FL,
-			                        MEU_SEVERITY_USER,
-			                        "KeyValueError",
-			                        "Invalid number of arguments. The key '%s' is missing a value.", mxArrayToString(prhs[0]));
-		}
-		
-		if(!mxIsLogicalScalar(prhs[1]))
-		{
-			MEXError::PrintMexError(MEU_FL,
-			                        MEU_SEVERITY_USER,
-			                        "InvalidValueError",
-			                        "All flag values must be scalar class 'logical'.");
+			if(!mxIsLogicalScalar(prhs[i + 1]))
+			{
+				MEXError::PrintMexError(MEU_FL,
+				                        MEU_SEVERITY_USER,
+				                        "InvalidValueError",
+				                        "All flag values must be scalar class 'logical'.");
+			}
+			if(nlhs > 1)
+			{
+				MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "MatrixOptionError", "The 'CombineAlpha' option requires either 0 or 1 outputs.");
+			}
+			combine_alpha = mxIsLogicalScalarTrue(prhs[i + 1]);
 		}
-		
-		MEXUtils::ToUpper((mxArray*)prhs[0]);
-		if(MEXUtils::CompareMEXString(prhs[0], "COMBINEALPHA"))
+		else if(MEXUtils::CompareMEXString(prhs[i], "OUTPUT"))
 		{
+			if(!(mxIsNumeric(prhs[i + 1]) || mxIsLogical(prhs[i + 1])))
+			{
+				MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "InvalidValueError", "The 'Output' option must be a numeric or logical array.");
+			}
 			if(nlhs > 1)
 			{
-				MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "MatrixOptionError", "The 'CombineAlpha' option requires either 0 or 1 outputs.");
+				MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "MatrixOptionError", "The 'Output' option requires either 0 or 1 outputs.");
 			}
-			combine_alpha = true;
+			mx_target = const_cast<mxArray*>(prhs[i + 1]);
 		}
 		else
 		{
-			MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "MatrixOptionError", "Unrecognized option '%s'.", mxArrayToString(prhs[0]));
+			MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "MatrixOptionError", "Unrecognized option '%s'.", mxArrayToString(prhs[i]));
 		}
 	}
 	
+	if(mx_target != nullptr && (this->GetSize() != 1 || this->GetDXTImage(0).GetImageCount() != 1))
+	{
+		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "MatrixOptionError", "The 'Output' option is only supported for single images.");
+	}
+	
 	if(this->GetSize() == 1)
 	{
 		if(nlhs > 1)
@@ -1976,7 +2827,7 @@ void DXTImageArray::ToImage(int nlhs, mxArray *plhs[], int nrhs, const mxArray*
 		}
 		else
 		{
-			this->GetDXTImage(0).ToImage(plhs[0], combine_alpha);
+			this->GetDXTImage(0).ToImage(plhs[0], combine_alpha, mx_target);
 		}
 	}
 	else
@@ -1985,22 +2836,22 @@ void DXTImageArray::ToImage(int nlhs, mxArray *plhs[], int nrhs, const mxArray*
 		{
 			plhs[0] = mxCreateCellMatrix(this->GetM(), this->GetN());
 			plhs[1] = mxCreateCellMatrix(this->GetM(), this->GetN());
-			for(i = 0; i < this->GetSize(); i++)
+			for(j = 0; j < this->GetSize(); j++)
 			{
 				mxArray* tmp[2];
-				this->GetDXTImage(i).ToImage(tmp[0], tmp[1]);
-				mxSetCell(plhs[0], i, tmp[0]);
-				mxSetCell(plhs[1], i, tmp[1]);
+				this->GetDXTImage(j).ToImage(tmp[0], tmp[1]);
+				mxSetCell(plhs[0], j, tmp[0]);
+				mxSetCell(plhs[1], j, tmp[1]);
 			}
 		}
 		else
 		{
 			plhs[0] = mxCreateCellMatrix(this->GetM(), this->GetN());
-			for(i = 0; i < this->GetSize(); i++)
+			for(j = 0; j < this->GetSize(); j++)
 			{
 				mxArray* tmp;
-				this->GetDXTImage(i).ToImage(tmp, combine_alpha);
-				mxSetCell(plhs[0], i, tmp);
+				this->GetDXTImage(j).ToImage(tmp, combine_alpha);
+				mxSetCell(plhs[0], j, tmp);
 			}
 			
 		}
@@ -2009,16 +2860,23 @@ void DXTImageArray::ToImage(int nlhs, mxArray *plhs[], int nrhs, const mxArray*
 
 void DXTImageArray::ToMatrix(int nlhs, mxArray *plhs[], int nrhs, const mxArray* prhs[])
 {
-	size_t i;
-	bool combine_alpha = false;
-	if(nrhs > 2)
+	Stats::Timer timer(Stats::PHASE::EXPORT);
+	int i;
+	size_t j;
+	mxArray* mx_target = nullptr;
+	MEXToDXT::LAYOUT layout = MEXToDXT::LAYOUT::DEFAULT;
+	
+	if(nrhs % 2 != 0)
 	{
-		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "TooManyArgumentsError", "Too many arguments.");
+		MEXError::PrintMexError(MEU_FL,
+		                        MEU_SEVERITY_USER,
+		                        "KeyValueError",
+		                        "Invalid number of arguments. The key '%s' is missing a value.", mxIsChar(prhs[nrhs - 1])? mxArrayToString(prhs[nrhs - 1]) : "");
 	}
 	
-	if(nrhs > 0)
+	for(i = 0; i < nrhs; i += 2)
 	{
-		if(!mxIsChar(prhs[0]))
+		if(!mxIsChar(prhs[i]))
 		{
 			MEXError::PrintMexError(MEU_FL,
 			                        MEU_SEVERITY_USER,
@@ -2026,55 +2884,70 @@ void DXTImageArray::ToMatrix(int nlhs, mxArray *plhs[], int nrhs, const mxArray*
 			                        "All keys must be class 'char'.");
 		}
 		
-		if(nrhs != 2)
+		MEXUtils::ToUpper((mxArray*)prhs[i]);
+		if(MEXUtils::CompareMEXString(prhs[i], "COMBINEALPHA"))
 		{
-			MEXError::PrintMexError(MEU_FL,
-			                        MEU_SEVERITY_USER,
-			                        "KeyValueError",
-			                        "Invalid number of arguments. The key '%s' is missing a value.", mxArrayToString(prhs[0]));
+			if(!mxIsLogicalScalar(prhs[i + 1]))
+			{
+				MEXError::PrintMexError(MEU_FL,
+				                        MEU_SEVERITY_USER,
+				                        "InvalidValueError",
+				                        "All flag values must be scalar class 'logical'.");
+			}
+			if(nlhs > 1)
+			{
+				MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "MatrixOptionError", "The 'CombineAlpha' option requires either 0 or 1 outputs.");
+			}
 		}
-		
-		if(!mxIsLogicalScalar(prhs[1]))
+		else if(MEXUtils::CompareMEXString(prhs[i], "OUTPUT"))
 		{
-			MEXError::PrintMexError(MEU_FL,
-			                        MEU_SEVERITY_USER,
-			                        "InvalidValueError",
-			                        "All flag values must be scalar class 'logical'.");
+			if(!(mxIsNumeric(prhs[i + 1]) || mxIsLogical(prhs[i + 1])))
+			{
+				MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "InvalidValueError", "The 'Output' option must be a numeric or logical array.");
+			}
+			mx_target = const_cast<mxArray*>(prhs[i + 1]);
 		}
-		
-		MEXUtils::ToUpper((mxArray*)prhs[0]);
-		if(MEXUtils::CompareMEXString(prhs[0], "COMBINEALPHA"))
+		else if(MEXUtils::CompareMEXString(prhs[i], "LAYOUT"))
 		{
-			if(nlhs > 1)
+			if(!mxIsChar(prhs[i + 1]))
 			{
-				MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "MatrixOptionError", "The 'CombineAlpha' option requires either 0 or 1 outputs.");
+				MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "InvalidValueError", "The 'Layout' option must be class 'char'.");
 			}
-			combine_alpha = mxIsLogicalScalarTrue(prhs[1]);
+			MEXUtils::ToUpper(const_cast<mxArray*>(prhs[i + 1]));
+			char* val = mxArrayToString(prhs[i + 1]);
+			layout = g_layout_map.FindIDFromString(val);
+			mxFree(val);
 		}
 		else
 		{
-			MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "MatrixOptionError", "Unrecognized option '%s'.", mxArrayToString(prhs[0]));
+			MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "MatrixOptionError", "Unrecognized option '%s'.", mxArrayToString(prhs[i]));
 		}
 	}
 	
+	if(mx_target != nullptr && (this->GetSize() != 1 || this->GetDXTImage(0).GetImageCount() != 1))
+	{
+		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "MatrixOptionError", "The 'Output' option is only supported for single images.");
+	}
+	
 	if(this->GetSize() == 1)
 	{
-		this->GetDXTImage(0).ToMatrix(plhs[0]);
+		this->GetDXTImage(0).ToMatrix(plhs[0], mx_target, layout);
 	}
 	else
 	{
 		plhs[0] = mxCreateCellMatrix(this->GetM(), this->GetN());
-		for(i = 0; i < this->GetSize(); i++)
+		for(j = 0; j < this->GetSize(); j++)
 		{
 			mxArray* tmp;
-			this->GetDXTImage(i).ToMatrix(tmp);
-			mxSetCell(plhs[0], i, tmp);
+			this->GetDXTImage(j).ToMatrix(tmp, nullptr, layout);
+			mxSetCell(plhs[0], j, tmp);
 		}
 	}
 }
 
 void DXTImageArray::ToExport(int, mxArray *plhs[])
 {
+	Stats::Timer timer(Stats::PHASE::EXPORT);
 	size_t i;
 	const char* fieldnames[] = {"Metadata", "Images"};
 	mxArray* out = mxCreateStructMatrix(this->GetM(), this->GetN(), ARRAYSIZE(fieldnames), fieldnames);
@@ -2086,6 +2959,42 @@ void DXTImageArray::ToExport(int, mxArray *plhs[])
 	plhs[0] = out;
 }
 
+void DXTImageArray::StartAsync(DXTImageArray::OPERATION op, int, mxArray* plhs[], int nrhs, const mxArray* prhs[])
+{
+	/* the options are read here, the job only sees them and the copied images */
+	Jobs::Work work;
+	switch(op)
+	{
+		case OPERATION::ASYNC_COMPRESS:
+		{
+			const CompressOptions opts = DXTImageArray::ParseCompressOptions(nrhs, prhs);
+			if(!opts.variant_formats.empty())
+			{
+				MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "InvalidFormatError", "ASYNC_COMPRESS takes a single format. Start one job per format instead.");
+			}
+			work = [opts](DXTImageArray& arr) {arr.CompressImages(opts);};
+			break;
+		}
+		case OPERATION::ASYNC_DECOMPRESS:
+		{
+			const DXGI_FORMAT fmt = DXTImageArray::ParseDecompressFormat(nrhs, prhs);
+			work = [fmt](DXTImageArray& arr) {arr.DecompressImages(fmt);};
+			break;
+		}
+		case OPERATION::ASYNC_TRANSCODE:
+		{
+			const CompressOptions opts = this->ParseTranscodeOptions(nrhs, prhs);
+			work = [opts](DXTImageArray& arr) {arr.TranscodeImages(opts);};
+			break;
+		}
+		default:
+		{
+			MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_INTERNAL, "InvalidDirectiveError", "The directive cannot be run in the background.");
+		}
+	}
+	plhs[0] = mxCreateDoubleScalar(Jobs::Start(std::move(*this), std::move(work)));
+}
+
 DXTImageArray::OPERATION DXTImageArray::GetOperation(const mxArray* directive)
 {
 	DXTImageArray::OPERATION op = OPERATION::NO_OP;
@@ -2106,3 +3015,16 @@ DXTImageArray::OPERATION DXTImageArray::GetOperation(const mxArray* directive)
 	mxFree(directive_str);
 	return op;
 }
+
+const char* DXTImageArray::GetOperationName(DXTImageArray::OPERATION op)
+{
+	/* the keys are never modified, so the names outlive any caller */
+	for(const auto& entry : g_directive_map)
+	{
+		if(entry.second == op)
+		{
+			return entry.first.c_str();
+		}
+	}
+	return "NO_OP";
+}
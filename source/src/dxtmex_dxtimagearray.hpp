@@ -5,7 +5,9 @@
 #include "mex.h"
 #include "DirectXTex.h"
 #include "dxtmex_dxtimage.hpp"
+#include "dxtmex_metrics.hpp"
 #include <memory>
+#include <vector>
 
 #define MEXF_IN  int nrhs, const mxArray* prhs[]
 #define MEXF_OUT int nlhs, mxArray* plhs[]
@@ -46,11 +48,15 @@ namespace DXTMEX
 		// void GenerateMipMaps3D           (MEXF_IN);
 		void ScaleMipMapsAlphaForCoverage(MEXF_IN);
 		void PremultiplyAlpha            (MEXF_IN);
-		void Compress                    (MEXF_IN);
+		void Compress                    (MEXF_SIG);
 		void Decompress                  (MEXF_IN);
+		void Transcode                   (MEXF_IN);
 		void ComputeNormalMap            (MEXF_IN);
 		static void CopyRectangle        (DXTImageArray& dst, DXTImageArray& src, MEXF_IN);
+		static void UpdateRegion         (DXTImageArray& dst, DXTImageArray& src, MEXF_IN);
 		static void ComputeMSE           (DXTImageArray& dxtimagearray1, DXTImageArray& dxtimagearray2, MEXF_SIG);
+		static void ComputeSSIM          (DXTImageArray& dxtimagearray1, DXTImageArray& dxtimagearray2, MEXF_SIG);
+		static void CompressionReport    (DXTImageArray& src, DXTImageArray& cmp, MEXF_SIG);
 		
 		void WriteDDS                    (MEXF_IN);
 		void WriteHDR                    (MEXF_IN);
@@ -95,6 +101,7 @@ namespace DXTMEX
 		static void IsTGA(MEXF_SIG);
 		
 		static DXGI_FORMAT ParseFormat(const mxArray* mx_fmt);
+		static void ImportFilename(const mxArray* mx_filename, std::wstring &filename);
 		
 		DXTImage& GetDXTImage(size_t idx)
 		{
@@ -138,14 +145,38 @@ namespace DXTMEX
 			PREMULTIPLY_ALPHA               ,
 			COMPRESS                        ,
 			DECOMPRESS                      ,
+			TRANSCODE                       ,
 			COMPUTE_NORMAL_MAP              ,
 			COPY_RECTANGLE                  ,
+			UPDATE_REGION                   ,
 			COMPUTE_MSE                     ,
 			TO_IMAGE                        ,
 			TO_MATRIX                       ,
+			ASYNC_READ_DDS                  ,
+			ASYNC_READ_HDR                  ,
+			ASYNC_READ_TGA                  ,
+			ASYNC_COMPRESS                  ,
+			ASYNC_DECOMPRESS                ,
+			ASYNC_TRANSCODE                 ,
+			POLL                            ,
+			WAIT                            ,
+			FETCH                           ,
+			STATS                           ,
+			STATS_RESET                     ,
+			TRACE_START                     ,
+			TRACE_STOP                      ,
+			BENCHMARK                       ,
+			BENCHMARK_PIXEL                 ,
+			COMPUTE_SSIM                    ,
+			COMPRESSION_REPORT              ,
 		};
 		
 		static DXTImageArray::OPERATION GetOperation(const mxArray* directive);
+		static const char* GetOperationName(DXTImageArray::OPERATION op);
+		
+		/* background jobs. the inputs are copied here and the job id is returned in plhs[0] */
+		static void ReadAsync            (DXTImage::IMAGE_TYPE type, MEXF_SIG);
+		void StartAsync                  (DXTImageArray::OPERATION op, MEXF_SIG);
 	
 	private:
 		std::unique_ptr<DXTImage[]> _arr;
@@ -196,12 +227,63 @@ namespace DXTMEX
 			return total;
 		}
 		
+		/* the options are parsed on the main thread, so the work below them may run on a background job */
+		struct FileRequest
+		{
+			DXTImage::IMAGE_TYPE      type;
+			DirectX::DDS_FLAGS        flags;
+			size_t                    m;
+			size_t                    n;
+			std::vector<std::wstring> filenames;
+			std::vector<std::string>  names;
+		};
+		
+		struct CompressOptions
+		{
+			DXGI_FORMAT                 fmt;
+			bool                        is_auto;
+			std::vector<DXGI_FORMAT>    variant_formats;
+			DirectX::TEX_COMPRESS_FLAGS flags;
+			float                       threshold;
+			double                      quality;
+			double                      time_budget;
+			double                      rdo_lambda;
+			double                      max_mse;
+			bool                        is_fast_path;
+		};
+		
 		/* import helpers */
-		static void      ImportFilename(const mxArray* mx_filename, std::wstring &filename);
 		std::unique_ptr<DXTImage[]> CopyDXTImageArray();
-		static void      ComputeMSE(DXTImage& dxtimage1, DXTImage& dxtimage2, DirectX::CMSE_FLAGS cmse_flags, mxArray*& mx_dxtimage_mse);
-		static void      ComputeMSE(DXTImage& dxtimage1, DXTImage& dxtimage2, DirectX::CMSE_FLAGS cmse_flags, mxArray*& mx_dxtimage_mse, mxArray*& mx_dxtimage_mseV);
-		static void      ComputeMSE(const DirectX::Image* img1, const DirectX::Image* img2, DirectX::CMSE_FLAGS cmse_flags, mxArray*& mx_dxtimageslice_mse);
-		static void      ComputeMSE(const DirectX::Image* img1, const DirectX::Image* img2, DirectX::CMSE_FLAGS cmse_flags, mxArray*& mx_dxtimageslice_mse, mxArray*& mx_dxtimageslice_mseV);
+		
+		static FileRequest     ParseFileRequest(DXTImage::IMAGE_TYPE type, MEXF_IN);
+		static CompressOptions ParseCompressOptions(MEXF_IN);
+		CompressOptions        ParseTranscodeOptions(MEXF_IN);
+		static DXGI_FORMAT     ParseDecompressFormat(MEXF_IN);
+		
+		/* these do not call into MATLAB, errors are raised through MEXError */
+		void             ReadFiles(const FileRequest& request);
+		size_t           CompressImages(const CompressOptions& opts);
+		void             TranscodeImages(const CompressOptions& opts);
+		void             DecompressImages(DXGI_FORMAT fmt);
+		
+		void             CompressVariants(int nlhs, mxArray* plhs[], const CompressOptions& opts);
+		
+		/* shared by the comparison directives, R is one of the Metrics results */
+		struct SubresourceIndex
+		{
+			size_t image;
+			size_t mip;
+			size_t item;
+			size_t slice;
+		};
+		template <typename R>
+		static void      PairSubresources(DXTImageArray& dxtimagearray1, DXTImageArray& dxtimagearray2, std::vector<R>& results, std::vector<mwIndex>& mex_indices, std::vector<size_t>& first_results,
+		                                  std::vector<SubresourceIndex>* locations = nullptr);
+		template <typename R>
+		static void      ExportComparison(DXTImageArray& dxtimagearray, const std::vector<R>& results, const std::vector<mwIndex>& mex_indices, const std::vector<size_t>& first_results, int num_outputs, mxArray* outputs[]);
+		template <typename R>
+		static void      ExportComparison(DXTImage& dxtimage, const R* results, const mwIndex* mex_indices, int num_outputs, mxArray* outputs[]);
+		static void      ExportResult(const Metrics::ErrorResult& result, int num_outputs, mxArray* outputs[]);
+		static void      ExportResult(const Metrics::SSIMResult& result, int num_outputs, mxArray* outputs[]);
 	};
 }
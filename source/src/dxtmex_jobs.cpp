@@ -0,0 +1,193 @@
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <future>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "dxtmex_jobs.hpp"
+#include "dxtmex_mexerror.hpp"
+#include "dxtmex_progress.hpp"
+#include "dxtmex_stats.hpp"
+#include "dxtmex_trace.hpp"
+
+using namespace DXTMEX;
+
+namespace
+{
+	/* only touched from the main thread, the jobs just fill their futures */
+	std::unordered_map<uint64_t, std::future<DXTImageArray>> g_jobs;
+	uint64_t g_next_id = 1;
+	
+	/* how often a blocked WAIT or FETCH checks for Ctrl-C */
+	constexpr std::chrono::milliseconds WAIT_SLICE(50);
+	
+	std::vector<uint64_t> ImportJobIDs(const mxArray* mx_ids)
+	{
+		if(!mxIsDouble(mx_ids) || mxIsEmpty(mx_ids))
+		{
+			MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "InvalidJobError", "Job ids must be a nonempty array of class 'double'.");
+		}
+		
+		std::vector<uint64_t> ids(mxGetNumberOfElements(mx_ids));
+		for(size_t i = 0; i < ids.size(); i++)
+		{
+			const double id = ((double*)mxGetData(mx_ids))[i];
+			if(id < 1 || id != std::floor(id) || g_jobs.find(static_cast<uint64_t>(id)) == g_jobs.end())
+			{
+				MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "UnknownJobError", "There is no outstanding job with id %g. It may have been fetched already.", id);
+			}
+			ids[i] = static_cast<uint64_t>(id);
+		}
+		return ids;
+	}
+	
+	bool IsDone(const std::future<DXTImageArray>& job)
+	{
+		return job.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+	}
+	
+	/* waits in slices so that Ctrl-C stops the wait, the job itself keeps running */
+	bool WaitForJob(const std::future<DXTImageArray>& job, std::chrono::steady_clock::time_point deadline)
+	{
+		while(!IsDone(job))
+		{
+			Progress::CheckInterrupt();
+			const auto now = std::chrono::steady_clock::now();
+			if(now >= deadline)
+			{
+				return false;
+			}
+			job.wait_for(std::min<std::chrono::steady_clock::duration>(WAIT_SLICE, deadline - now));
+		}
+		return true;
+	}
+	
+	void ExportDone(const std::vector<uint64_t>& ids, const mxArray* mx_ids, mxArray*& mx_done)
+	{
+		mx_done = mxCreateLogicalMatrix(mxGetM(mx_ids), mxGetN(mx_ids));
+		for(size_t i = 0; i < ids.size(); i++)
+		{
+			((mxLogical*)mxGetData(mx_done))[i] = IsDone(g_jobs.at(ids[i]));
+		}
+	}
+}
+
+double Jobs::Start(DXTImageArray&& arr, Work work)
+{
+	const uint64_t id = g_next_id++;
+	const DXTImageArray::OPERATION op = Stats::GetOperation();
+	g_jobs.emplace(id, std::async(std::launch::async, [op, arr = std::move(arr), work = std::move(work)]() mutable
+	{
+		Stats::BackgroundScope scope(op);
+		Trace::Scope trace_scope(DXTImageArray::GetOperationName(op), "job");
+		work(arr);
+		return std::move(arr);
+	}));
+	
+	/* the threads run code from this MEX file, so it must stay loaded until the job is fetched */
+	mexLock();
+	return static_cast<double>(id);
+}
+
+void Jobs::Poll(int, mxArray* plhs[], int nrhs, const mxArray* prhs[])
+{
+	if(nrhs < 1)
+	{
+		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "NotEnoughArgumentsError", "Not enough arguments. Please supply a job id.");
+	}
+	else if(nrhs > 1)
+	{
+		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "TooManyArgumentsError", "Too many arguments.");
+	}
+	ExportDone(ImportJobIDs(prhs[0]), prhs[0], plhs[0]);
+}
+
+void Jobs::Wait(int, mxArray* plhs[], int nrhs, const mxArray* prhs[])
+{
+	auto deadline = std::chrono::steady_clock::time_point::max();
+	if(nrhs < 1)
+	{
+		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "NotEnoughArgumentsError", "Not enough arguments. Please supply a job id.");
+	}
+	else if(nrhs > 2)
+	{
+		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "TooManyArgumentsError", "Too many arguments.");
+	}
+	
+	const std::vector<uint64_t> ids = ImportJobIDs(prhs[0]);
+	if(nrhs > 1)
+	{
+		if(!mxIsNumeric(prhs[1]) || !mxIsScalar(prhs[1]) || mxGetScalar(prhs[1]) < 0)
+		{
+			MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "InvalidValueError", "The timeout must be a nonnegative scalar in seconds.");
+		}
+		if(std::isfinite(mxGetScalar(prhs[1])))
+		{
+			deadline = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(mxGetScalar(prhs[1])));
+		}
+	}
+	
+	for(uint64_t id : ids)
+	{
+		if(!WaitForJob(g_jobs.at(id), deadline))
+		{
+			break;
+		}
+	}
+	ExportDone(ids, prhs[0], plhs[0]);
+}
+
+void Jobs::Fetch(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[])
+{
+	if(nrhs < 1)
+	{
+		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "NotEnoughArgumentsError", "Not enough arguments. Please supply a job id.");
+	}
+	else if(nrhs > 1)
+	{
+		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "TooManyArgumentsError", "Too many arguments.");
+	}
+	
+	const std::vector<uint64_t> ids = ImportJobIDs(prhs[0]);
+	if(ids.size() != 1)
+	{
+		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "InvalidJobError", "FETCH takes a single job id.");
+	}
+	
+	auto iter = g_jobs.find(ids[0]);
+	WaitForJob(iter->second, std::chrono::steady_clock::time_point::max());
+	std::future<DXTImageArray> job = std::move(iter->second);
+	g_jobs.erase(iter);
+	mexUnlock();
+	
+	/* the MATLAB error is raised outside of the handlers */
+	DXTImageArray result;
+	MEXError::WorkerError worker_error = {0, "", ""};
+	bool is_failed = false;
+	std::string failure;
+	try
+	{
+		result = job.get();
+	}
+	catch(const MEXError::WorkerError& e)
+	{
+		worker_error = e;
+	}
+	catch(const std::exception& e)
+	{
+		is_failed = true;
+		failure = e.what();
+	}
+	
+	if(!worker_error.id.empty())
+	{
+		MEXError::RethrowWorkerError(worker_error);
+	}
+	else if(is_failed)
+	{
+		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_INTERNAL, "JobError", "The background job failed: %s", failure.c_str());
+	}
+	result.ToExport(nlhs, plhs);
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <functional>
+
+#include "mex.h"
+#include "dxtmex_dxtimagearray.hpp"
+
+namespace DXTMEX
+{
+	/* background jobs started by the ASYNC_ directives. each job owns a native copy of its inputs and
+	 * runs on its own thread, so several outstanding jobs overlap their file reads and encodes. */
+	namespace Jobs
+	{
+		using Work = std::function<void(DXTImageArray&)>;
+		
+		/* runs work on arr in the background and returns the job id. main thread only */
+		double Start(DXTImageArray&& arr, Work work);
+		
+		/* POLL(ids) returns whether each job has finished */
+		void Poll(MEXF_SIG);
+		
+		/* WAIT(ids, [timeout]) blocks until the jobs finish or timeout seconds pass, then returns POLL(ids) */
+		void Wait(MEXF_SIG);
+		
+		/* FETCH(id) waits for the job, releases it, and returns its images or raises its error */
+		void Fetch(MEXF_SIG);
+	}
+}
@@ -150,6 +150,20 @@ namespace DXTMEX
 		{MEXToDXT::COLORSPACE::SRGB, "SRGB"}
 	};
 	
+	BiMap<MEXToDXT::LAYOUT> g_layout_map
+	{
+		{MEXToDXT::LAYOUT::DEFAULT, "DEFAULT"},
+		{MEXToDXT::LAYOUT::PLANAR, "PLANAR"},
+		{MEXToDXT::LAYOUT::INTERLEAVED, "INTERLEAVED"}
+	};
+	
+	BiMap<MEXToDXT::INTERMEDIATE> g_intermediate_map
+	{
+		{MEXToDXT::INTERMEDIATE::DEFAULT, "DEFAULT"},
+		{MEXToDXT::INTERMEDIATE::SINGLE, "SINGLE"},
+		{MEXToDXT::INTERMEDIATE::HALF, "HALF"}
+	};
+	
 	BiMap<DXTImage::IMAGE_TYPE> g_imagetype_map{{DXTImage::IMAGE_TYPE::UNKNOWN, "Unknown"},
 	                                                         {DXTImage::IMAGE_TYPE::DDS,     "DDS"},
 	                                                         {DXTImage::IMAGE_TYPE::HDR,     "HDR"},
@@ -73,6 +73,8 @@ namespace DXTMEX
 	extern BiMap<DirectX::TEX_ALPHA_MODE> g_alphamode_map;
 	extern BiMap<DXTImage::IMAGE_TYPE> g_imagetype_map;
 	extern BiMap<MEXToDXT::COLORSPACE> g_colorspace_map;
+	extern BiMap<MEXToDXT::LAYOUT> g_layout_map;
+	extern BiMap<MEXToDXT::INTERMEDIATE> g_intermediate_map;
 	
 }
 
@@ -0,0 +1,810 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include "dxtmex_metrics.hpp"
+#include "dxtmex_parallel.hpp"
+#include "dxtmex_pixel.hpp"
+#include "dxtmex_simd.hpp"
+
+using namespace DXTMEX;
+
+namespace
+{
+	struct Band
+	{
+		size_t result;     /* index of the pair */
+		size_t row;        /* first scanline of the band */
+		size_t rows;
+		double sum_sq[4];
+		float  max_abs[4];
+	};
+
+	/* the same storage without the sRGB curve, so decoding keeps the stored values */
+	DXGI_FORMAT StoredFormat(DXGI_FORMAT fmt)
+	{
+		switch(fmt)
+		{
+			case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB: return DXGI_FORMAT_R8G8B8A8_UNORM;
+			case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB: return DXGI_FORMAT_B8G8R8A8_UNORM;
+			case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB: return DXGI_FORMAT_B8G8R8X8_UNORM;
+			case DXGI_FORMAT_BC1_UNORM_SRGB:      return DXGI_FORMAT_BC1_UNORM;
+			case DXGI_FORMAT_BC2_UNORM_SRGB:      return DXGI_FORMAT_BC2_UNORM;
+			case DXGI_FORMAT_BC3_UNORM_SRGB:      return DXGI_FORMAT_BC3_UNORM;
+			case DXGI_FORMAT_BC7_UNORM_SRGB:      return DXGI_FORMAT_BC7_UNORM;
+			default:                              return fmt;
+		}
+	}
+
+	/* decodes rows [row, row + rows) of img to R32G32B32A32_FLOAT. if is_linear, sRGB formats are taken to linear and
+	 * force_srgb does the same for the others. x2_bias maps [0, 1] to [-1, 1] like DirectX::ComputeMSE. */
+	HRESULT LoadBand(const DirectX::Image& img, size_t row, size_t rows, bool is_linear, bool force_srgb, bool x2_bias, DirectX::ScratchImage& scratch, DirectX::Image& band)
+	{
+		/* rows of a compressed image are rows of blocks */
+		band = img;
+		band.format = is_linear? img.format : StoredFormat(img.format);
+		band.height = rows;
+		band.pixels += (DirectX::IsCompressed(img.format)? row / 4 : row) * img.rowPitch;
+		band.slicePitch = DirectX::ComputeScanlines(img.format, rows) * img.rowPitch;
+
+		const bool is_srgb_forced = is_linear && force_srgb && !DirectX::IsSRGB(img.format);
+		HRESULT band_hres;
+		if(DirectX::IsCompressed(img.format))
+		{
+			band_hres = DirectX::Decompress(band, DXGI_FORMAT_R32G32B32A32_FLOAT, scratch);
+		}
+		else if(img.format != DXGI_FORMAT_R32G32B32A32_FLOAT)
+		{
+			band_hres = DirectX::Convert(band, DXGI_FORMAT_R32G32B32A32_FLOAT, DirectX::TEX_FILTER_DEFAULT, DirectX::TEX_THRESHOLD_DEFAULT, scratch);
+		}
+		else if(is_srgb_forced || x2_bias)
+		{
+			/* float input is read in place unless it has to be changed */
+			band_hres = scratch.Initialize2D(DXGI_FORMAT_R32G32B32A32_FLOAT, band.width, band.height, 1, 1);
+			if(SUCCEEDED(band_hres))
+			{
+				const DirectX::Image* copy = scratch.GetImage(0, 0, 0);
+				for(size_t y = 0; y < band.height; y++)
+				{
+					memcpy(copy->pixels + y * copy->rowPitch, band.pixels + y * band.rowPitch, band.width * 4 * sizeof(float));
+				}
+			}
+		}
+		else
+		{
+			return S_OK;
+		}
+
+		if(FAILED(band_hres))
+		{
+			return band_hres;
+		}
+		band = *scratch.GetImage(0, 0, 0);
+
+		if(is_srgb_forced || x2_bias)
+		{
+			for(size_t y = 0; y < band.height; y++)
+			{
+				auto pixel = reinterpret_cast<float*>(band.pixels + y * band.rowPitch);
+				for(size_t x = 0; x < band.width; x++, pixel += 4)
+				{
+					if(is_srgb_forced)
+					{
+						pixel[0] = DXGIPixel::SRGBToLinearFloat(pixel[0]);
+						pixel[1] = DXGIPixel::SRGBToLinearFloat(pixel[1]);
+						pixel[2] = DXGIPixel::SRGBToLinearFloat(pixel[2]);
+					}
+					if(x2_bias)
+					{
+						for(size_t c = 0; c < 4; c++)
+						{
+							pixel[c] = pixel[c] * 2.0f - 1.0f;
+						}
+					}
+				}
+			}
+		}
+		return S_OK;
+	}
+
+	bool IsBGRX(DXGI_FORMAT fmt)
+	{
+		return fmt == DXGI_FORMAT_B8G8R8X8_UNORM || fmt == DXGI_FORMAT_B8G8R8X8_UNORM_SRGB;
+	}
+
+	void GetIgnoredChannels(const DirectX::Image& img1, const DirectX::Image& img2, DirectX::CMSE_FLAGS cmse_flags, bool (&is_ignored)[4])
+	{
+		is_ignored[0] = (cmse_flags & DirectX::CMSE_IGNORE_RED) != 0;
+		is_ignored[1] = (cmse_flags & DirectX::CMSE_IGNORE_GREEN) != 0;
+		is_ignored[2] = (cmse_flags & DirectX::CMSE_IGNORE_BLUE) != 0;
+
+		/* the X of BGRX holds nothing, DirectX::ComputeMSE skips it too */
+		is_ignored[3] = (cmse_flags & DirectX::CMSE_IGNORE_ALPHA) != 0 || IsBGRX(img1.format) || IsBGRX(img2.format);
+	}
+
+	/* bit c is set if the format stores channel c of RGBA, the others decode to constants */
+	unsigned GetChannelMask(DXGI_FORMAT fmt)
+	{
+		switch(fmt)
+		{
+			case DXGI_FORMAT_A8_UNORM:
+				return 0x8u;
+			case DXGI_FORMAT_R32_FLOAT:
+			case DXGI_FORMAT_R32_UINT:
+			case DXGI_FORMAT_R32_SINT:
+			case DXGI_FORMAT_D32_FLOAT:
+			case DXGI_FORMAT_R24_UNORM_X8_TYPELESS:
+			case DXGI_FORMAT_R16_FLOAT:
+			case DXGI_FORMAT_R16_UNORM:
+			case DXGI_FORMAT_R16_UINT:
+			case DXGI_FORMAT_R16_SNORM:
+			case DXGI_FORMAT_R16_SINT:
+			case DXGI_FORMAT_D16_UNORM:
+			case DXGI_FORMAT_R8_UNORM:
+			case DXGI_FORMAT_R8_UINT:
+			case DXGI_FORMAT_R8_SNORM:
+			case DXGI_FORMAT_R8_SINT:
+			case DXGI_FORMAT_R1_UNORM:
+			case DXGI_FORMAT_BC4_UNORM:
+			case DXGI_FORMAT_BC4_SNORM:
+				return 0x1u;
+			case DXGI_FORMAT_R32G32_FLOAT:
+			case DXGI_FORMAT_R32G32_UINT:
+			case DXGI_FORMAT_R32G32_SINT:
+			case DXGI_FORMAT_R16G16_FLOAT:
+			case DXGI_FORMAT_R16G16_UNORM:
+			case DXGI_FORMAT_R16G16_UINT:
+			case DXGI_FORMAT_R16G16_SNORM:
+			case DXGI_FORMAT_R16G16_SINT:
+			case DXGI_FORMAT_R8G8_UNORM:
+			case DXGI_FORMAT_R8G8_UINT:
+			case DXGI_FORMAT_R8G8_SNORM:
+			case DXGI_FORMAT_R8G8_SINT:
+			case DXGI_FORMAT_BC5_UNORM:
+			case DXGI_FORMAT_BC5_SNORM:
+				return 0x3u;
+			default:
+				return DirectX::HasAlpha(fmt)? 0xFu : 0x7u;
+		}
+	}
+
+	/* channels stored by either image and not ignored */
+	unsigned GetComparedChannels(const DirectX::Image& img1, const DirectX::Image& img2, DirectX::CMSE_FLAGS cmse_flags)
+	{
+		bool is_ignored[4];
+		GetIgnoredChannels(img1, img2, cmse_flags, is_ignored);
+		unsigned mask = GetChannelMask(img1.format) | GetChannelMask(img2.format);
+		for(size_t c = 0; c < 4; c++)
+		{
+			if(is_ignored[c])
+			{
+				mask &= ~(1u << c);
+			}
+		}
+		return mask;
+	}
+
+	/* window and constants of Wang et al., the dynamic range is 1 */
+	constexpr size_t SSIM_RADIUS = 5;
+	constexpr size_t SSIM_TAPS   = 2 * SSIM_RADIUS + 1;
+	constexpr double SSIM_SIGMA  = 1.5;
+	constexpr float  SSIM_C1     = 0.01f * 0.01f;
+	constexpr float  SSIM_C2     = 0.03f * 0.03f;
+
+	/* the halo of a band is decoded twice, so bands are kept tall enough for it to stay small */
+	constexpr size_t SSIM_MIN_BAND_ROWS = 8 * SSIM_RADIUS;
+
+	/* exponents of the scales of MS-SSIM, finest first */
+	constexpr size_t MSSSIM_MAX_SCALES = 5;
+	constexpr double MSSSIM_WEIGHTS[MSSSIM_MAX_SCALES] = {0.0448, 0.2856, 0.3001, 0.2363, 0.1333};
+
+	struct SSIMWindow
+	{
+		float weights[SSIM_TAPS];
+
+		SSIMWindow()
+		{
+			double sum = 0.0;
+			double w[SSIM_TAPS];
+			for(size_t k = 0; k < SSIM_TAPS; k++)
+			{
+				const double d = static_cast<double>(k) - SSIM_RADIUS;
+				w[k] = std::exp(-d * d / (2.0 * SSIM_SIGMA * SSIM_SIGMA));
+				sum += w[k];
+			}
+			for(size_t k = 0; k < SSIM_TAPS; k++)
+			{
+				weights[k] = static_cast<float>(w[k] / sum);
+			}
+		}
+	};
+
+	const SSIMWindow g_window;
+
+	/* the images of one pair at one scale, the first scale is the input and the others are owned */
+	struct SSIMScale
+	{
+		const DirectX::Image* image1;
+		const DirectX::Image* image2;
+		DirectX::ScratchImage owned1;
+		DirectX::ScratchImage owned2;
+		double                mean_ssim[4];
+		double                mean_cs[4];
+	};
+
+	struct SSIMBand
+	{
+		size_t result;     /* index of the pair */
+		size_t row;        /* first scanline of the band */
+		size_t rows;
+		double sum_ssim[4];
+		double sum_cs[4];
+	};
+
+	/* sums the SSIM and contrast-structure terms of the rows of band for each channel in channel_mask, adding to the
+	 * map if it is set. band1 and band2 are the decoded rows from first_row on, with a halo of SSIM_RADIUS around the
+	 * band where the image has it, edges are replicated. next1 and next2 get the 2x2 average of the rows if set. */
+	void ComputeSSIMBand(const DirectX::Image& band1, const DirectX::Image& band2, size_t first_row, size_t height, unsigned channel_mask,
+	                     SSIMBand& band, float* map, DirectX::Image* next1, DirectX::Image* next2)
+	{
+		const size_t width = band1.width;
+		const size_t num_rows = band1.height;
+		const float* w = g_window.weights;
+		size_t num_channels = 0;
+		for(size_t c = 0; c < 4; c++)
+		{
+			num_channels += (channel_mask >> c) & 1u;
+		}
+
+		/* x, y, x^2, y^2 and xy of a row with the edges padded, then filtered across for every row of the band */
+		std::vector<float> padded(5 * (width + 2 * SSIM_RADIUS));
+		std::vector<float> across(5 * num_rows * width);
+		std::vector<float> window(5 * width);
+		for(size_t c = 0; c < 4; c++)
+		{
+			if(!((channel_mask >> c) & 1u))
+			{
+				continue;
+			}
+
+			std::fill(across.begin(), across.end(), 0.0f);
+			for(size_t i = 0; i < num_rows; i++)
+			{
+				auto row1 = reinterpret_cast<const float*>(band1.pixels + i * band1.rowPitch);
+				auto row2 = reinterpret_cast<const float*>(band2.pixels + i * band2.rowPitch);
+				float* px = padded.data();
+				float* py = px + (width + 2 * SSIM_RADIUS);
+				float* pxx = py + (width + 2 * SSIM_RADIUS);
+				float* pyy = pxx + (width + 2 * SSIM_RADIUS);
+				float* pxy = pyy + (width + 2 * SSIM_RADIUS);
+				for(size_t p = 0; p < width + 2 * SSIM_RADIUS; p++)
+				{
+					const size_t x = std::min(p > SSIM_RADIUS? p - SSIM_RADIUS : 0, width - 1);
+					px[p] = row1[4 * x + c];
+					py[p] = row2[4 * x + c];
+					pxx[p] = px[p] * px[p];
+					pyy[p] = py[p] * py[p];
+					pxy[p] = px[p] * py[p];
+				}
+				for(size_t q = 0; q < 5; q++)
+				{
+					float* out = across.data() + (q * num_rows + i) * width;
+					for(size_t k = 0; k < SSIM_TAPS; k++)
+					{
+						SIMD::MultiplyAdd(padded.data() + q * (width + 2 * SSIM_RADIUS) + k, w[k], width, out);
+					}
+				}
+			}
+
+			for(size_t y = band.row; y < band.row + band.rows; y++)
+			{
+				std::fill(window.begin(), window.end(), 0.0f);
+				for(size_t k = 0; k < SSIM_TAPS; k++)
+				{
+					const size_t src_y = std::min(y + k > SSIM_RADIUS? y + k - SSIM_RADIUS : 0, height - 1) - first_row;
+					for(size_t q = 0; q < 5; q++)
+					{
+						SIMD::MultiplyAdd(across.data() + (q * num_rows + src_y) * width, w[k], width, window.data() + q * width);
+					}
+				}
+
+				const float* mu_x = window.data();
+				const float* mu_y = mu_x + width;
+				const float* e_xx = mu_y + width;
+				const float* e_yy = e_xx + width;
+				const float* e_xy = e_yy + width;
+				double row_ssim = 0.0, row_cs = 0.0;
+				for(size_t x = 0; x < width; x++)
+				{
+					const float luminance = (2.0f * mu_x[x] * mu_y[x] + SSIM_C1) / (mu_x[x] * mu_x[x] + mu_y[x] * mu_y[x] + SSIM_C1);
+					const float sigma_xx = e_xx[x] - mu_x[x] * mu_x[x];
+					const float sigma_yy = e_yy[x] - mu_y[x] * mu_y[x];
+					const float sigma_xy = e_xy[x] - mu_x[x] * mu_y[x];
+					const float cs = (2.0f * sigma_xy + SSIM_C2) / (sigma_xx + sigma_yy + SSIM_C2);
+					row_ssim += luminance * cs;
+					row_cs += cs;
+					if(map != nullptr)
+					{
+						map[x * height + y] += luminance * cs / static_cast<float>(num_channels);
+					}
+				}
+				band.sum_ssim[c] += row_ssim;
+				band.sum_cs[c] += row_cs;
+			}
+		}
+
+		if(next1 == nullptr)
+		{
+			return;
+		}
+		for(size_t ny = band.row / 2; ny < std::min((band.row + band.rows) / 2, next1->height); ny++)
+		{
+			DirectX::Image* next[2] = {next1, next2};
+			const DirectX::Image* src[2] = {&band1, &band2};
+			for(size_t n = 0; n < 2; n++)
+			{
+				auto top = reinterpret_cast<const float*>(src[n]->pixels + (2 * ny - first_row) * src[n]->rowPitch);
+				auto bottom = reinterpret_cast<const float*>(src[n]->pixels + (2 * ny + 1 - first_row) * src[n]->rowPitch);
+				auto out = reinterpret_cast<float*>(next[n]->pixels + ny * next[n]->rowPitch);
+				for(size_t nx = 0; nx < next[n]->width; nx++)
+				{
+					for(size_t c = 0; c < 4; c++)
+					{
+						out[4 * nx + c] = 0.25f * (top[8 * nx + c] + top[8 * nx + 4 + c] + bottom[8 * nx + c] + bottom[8 * nx + 4 + c]);
+					}
+				}
+			}
+		}
+	}
+
+	/* the side of a BC block, which is what the report localizes */
+	constexpr size_t REPORT_BLOCK_SIZE = 4;
+
+	/* blocks summarized by one task */
+	constexpr size_t REPORT_CHUNK_BLOCKS = 16384;
+
+	struct ReportChunk
+	{
+		size_t                          result;
+		size_t                          first;      /* range of the column-major map */
+		size_t                          last;
+		double                          sum_mse;
+		double                          sum_sq_mse;
+		std::vector<size_t>             counts;
+		std::vector<Metrics::BlockEntry> worst;
+	};
+
+	/* total order so the report does not depend on the scheduling */
+	bool IsWorseBlock(const Metrics::BlockEntry& a, const Metrics::BlockEntry& b)
+	{
+		if(a.mse != b.mse)
+		{
+			return a.mse > b.mse;
+		}
+		if(a.result != b.result)
+		{
+			return a.result < b.result;
+		}
+		if(a.y != b.y)
+		{
+			return a.y < b.y;
+		}
+		return a.x < b.x;
+	}
+}
+
+HRESULT Metrics::ComputeError(std::vector<ErrorResult>& results, DirectX::CMSE_FLAGS cmse_flags, size_t block_size)
+{
+	std::vector<Band> bands;
+	for(size_t i = 0; i < results.size(); i++)
+	{
+		ErrorResult& result = results[i];
+		const DirectX::Image& img1 = *result.image1;
+		const DirectX::Image& img2 = *result.image2;
+		if(img1.width != img2.width || img1.height != img2.height)
+		{
+			return E_INVALIDARG;
+		}
+
+		/* a band holds whole rows of map blocks and of compressed blocks */
+		const size_t step = std::max<size_t>(block_size, 1);
+		size_t align = step;
+		if(DirectX::IsCompressed(img1.format) || DirectX::IsCompressed(img2.format))
+		{
+			while(align % 4 != 0)
+			{
+				align += step;
+			}
+		}
+		const size_t band_rows = std::max<size_t>((BAND_PIXELS / img1.width) / align, 1) * align;
+		for(size_t row = 0; row < img1.height; row += band_rows)
+		{
+			bands.push_back({i, row, std::min(band_rows, img1.height - row), {0.0, 0.0, 0.0, 0.0}, {0.0f, 0.0f, 0.0f, 0.0f}});
+		}
+
+		result.mse = 0.0;
+		std::fill(result.mseV, result.mseV + 4, 0.0);
+		std::fill(result.max_abs, result.max_abs + 4, 0.0f);
+		result.map_width  = block_size? (img1.width + block_size - 1) / block_size : 0;
+		result.map_height = block_size? (img1.height + block_size - 1) / block_size : 0;
+		result.map.assign(result.map_width * result.map_height, 0.0);
+	}
+
+	/* bands own whole map rows, so they write to the map without sharing */
+	std::atomic<HRESULT> first_failure(S_OK);
+	Parallel::For(bands.size(), [&](size_t i)
+	{
+		Band& band = bands[i];
+		ErrorResult& result = results[band.result];
+		DirectX::ScratchImage scratch1, scratch2;
+		DirectX::Image band1, band2;
+		HRESULT band_hres = LoadBand(*result.image1, band.row, band.rows, true, (cmse_flags & DirectX::CMSE_IMAGE1_SRGB) != 0, (cmse_flags & DirectX::CMSE_IMAGE1_X2_BIAS) != 0, scratch1, band1);
+		if(SUCCEEDED(band_hres))
+		{
+			band_hres = LoadBand(*result.image2, band.row, band.rows, true, (cmse_flags & DirectX::CMSE_IMAGE2_SRGB) != 0, (cmse_flags & DirectX::CMSE_IMAGE2_X2_BIAS) != 0, scratch2, band2);
+		}
+		if(FAILED(band_hres))
+		{
+			HRESULT expected = S_OK;
+			first_failure.compare_exchange_strong(expected, band_hres);
+			return;
+		}
+
+		bool is_ignored[4];
+		GetIgnoredChannels(*result.image1, *result.image2, cmse_flags, is_ignored);
+		for(size_t y = 0; y < band.rows; y++)
+		{
+			auto row1 = reinterpret_cast<const float*>(band1.pixels + y * band1.rowPitch);
+			auto row2 = reinterpret_cast<const float*>(band2.pixels + y * band2.rowPitch);
+			if(block_size == 0)
+			{
+				SIMD::ReduceError(row1, row2, band1.width, band.sum_sq, band.max_abs);
+				continue;
+			}
+
+			double* map_row = result.map.data() + (band.row + y) / block_size;
+			for(size_t x = 0; x < band1.width; x += block_size)
+			{
+				double block_sq[4] = {0.0, 0.0, 0.0, 0.0};
+				SIMD::ReduceError(row1 + 4 * x, row2 + 4 * x, std::min(block_size, band1.width - x), block_sq, band.max_abs);
+				for(size_t c = 0; c < 4; c++)
+				{
+					band.sum_sq[c] += block_sq[c];
+					if(!is_ignored[c])
+					{
+						map_row[(x / block_size) * result.map_height] += block_sq[c];
+					}
+				}
+			}
+		}
+	});
+
+	HRESULT failure = first_failure.load();
+	if(FAILED(failure))
+	{
+		return failure;
+	}
+
+	/* bands are summed in order so the result does not depend on the scheduling */
+	for(const Band& band : bands)
+	{
+		ErrorResult& result = results[band.result];
+		for(size_t c = 0; c < 4; c++)
+		{
+			result.mseV[c] += band.sum_sq[c];
+			result.max_abs[c] = std::max(result.max_abs[c], band.max_abs[c]);
+		}
+	}
+
+	for(ErrorResult& result : results)
+	{
+		const size_t width  = result.image1->width;
+		const size_t height = result.image1->height;
+		bool is_ignored[4];
+		GetIgnoredChannels(*result.image1, *result.image2, cmse_flags, is_ignored);
+		for(size_t c = 0; c < 4; c++)
+		{
+			if(is_ignored[c])
+			{
+				result.mseV[c] = 0.0;
+				result.max_abs[c] = 0.0f;
+				continue;
+			}
+			result.mseV[c] /= static_cast<double>(width * height);
+			result.mse += result.mseV[c];
+		}
+		result.psnr = (result.mse == 0.0)? std::numeric_limits<double>::infinity() : -10.0 * std::log10(result.mse);
+
+		for(size_t bx = 0; bx < result.map_width; bx++)
+		{
+			for(size_t by = 0; by < result.map_height; by++)
+			{
+				const size_t block_pixels = std::min(block_size, width - bx * block_size) * std::min(block_size, height - by * block_size);
+				result.map[bx * result.map_height + by] /= static_cast<double>(block_pixels);
+			}
+		}
+	}
+	return S_OK;
+}
+
+HRESULT Metrics::ComputeSSIM(std::vector<SSIMResult>& results, DirectX::CMSE_FLAGS cmse_flags, bool is_multiscale, bool has_map)
+{
+	std::vector<std::vector<SSIMScale>> scales(results.size());
+	for(size_t i = 0; i < results.size(); i++)
+	{
+		SSIMResult& result = results[i];
+		const DirectX::Image& img1 = *result.image1;
+		const DirectX::Image& img2 = *result.image2;
+		if(img1.width != img2.width || img1.height != img2.height)
+		{
+			return E_INVALIDARG;
+		}
+
+		result.num_scales = 1;
+		while(is_multiscale && result.num_scales < MSSSIM_MAX_SCALES && (std::min(img1.width, img1.height) >> result.num_scales) >= SSIM_TAPS)
+		{
+			result.num_scales++;
+		}
+		scales[i].resize(result.num_scales);
+		scales[i][0].image1 = result.image1;
+		scales[i][0].image2 = result.image2;
+		result.map.assign(has_map? img1.width * img1.height : 0, 0.0f);
+	}
+
+	/* the bands of a scale also downsample it, so scales run one after another with all pairs in parallel */
+	for(size_t s = 0; s < MSSSIM_MAX_SCALES; s++)
+	{
+		std::vector<SSIMBand> bands;
+		for(size_t i = 0; i < results.size(); i++)
+		{
+			if(s >= results[i].num_scales)
+			{
+				continue;
+			}
+
+			SSIMScale& scale = scales[i][s];
+			const DirectX::Image& img1 = *scale.image1;
+			const DirectX::Image& img2 = *scale.image2;
+			std::fill(scale.mean_ssim, scale.mean_ssim + 4, 0.0);
+			std::fill(scale.mean_cs, scale.mean_cs + 4, 0.0);
+			if(s + 1 < results[i].num_scales)
+			{
+				SSIMScale& next = scales[i][s + 1];
+				HRESULT init_hres = next.owned1.Initialize2D(DXGI_FORMAT_R32G32B32A32_FLOAT, img1.width / 2, img1.height / 2, 1, 1);
+				if(SUCCEEDED(init_hres))
+				{
+					init_hres = next.owned2.Initialize2D(DXGI_FORMAT_R32G32B32A32_FLOAT, img1.width / 2, img1.height / 2, 1, 1);
+				}
+				if(FAILED(init_hres))
+				{
+					return init_hres;
+				}
+				next.image1 = next.owned1.GetImage(0, 0, 0);
+				next.image2 = next.owned2.GetImage(0, 0, 0);
+			}
+
+			/* bands start on even rows for the downsampling and on block rows of compressed inputs */
+			const size_t align = (DirectX::IsCompressed(img1.format) || DirectX::IsCompressed(img2.format))? 4 : 2;
+			const size_t band_rows = (std::max(BAND_PIXELS / img1.width, SSIM_MIN_BAND_ROWS) + align - 1) / align * align;
+			for(size_t row = 0; row < img1.height; row += band_rows)
+			{
+				bands.push_back({i, row, std::min(band_rows, img1.height - row), {0.0, 0.0, 0.0, 0.0}, {0.0, 0.0, 0.0, 0.0}});
+			}
+		}
+		if(bands.empty())
+		{
+			break;
+		}
+
+		std::atomic<HRESULT> first_failure(S_OK);
+		Parallel::For(bands.size(), [&](size_t b)
+		{
+			SSIMBand& band = bands[b];
+			SSIMResult& result = results[band.result];
+			std::vector<SSIMScale>& pair_scales = scales[band.result];
+			const DirectX::Image& img1 = *pair_scales[s].image1;
+			const DirectX::Image& img2 = *pair_scales[s].image2;
+
+			size_t first_row = (band.row > SSIM_RADIUS)? band.row - SSIM_RADIUS : 0;
+			if(DirectX::IsCompressed(img1.format) || DirectX::IsCompressed(img2.format))
+			{
+				first_row -= first_row % 4;
+			}
+			const size_t num_rows = std::min(band.row + band.rows + SSIM_RADIUS, img1.height) - first_row;
+
+			/* the bias only applies to the input, the smaller scales are made from converted values */
+			DirectX::ScratchImage scratch1, scratch2;
+			DirectX::Image band1, band2;
+			HRESULT band_hres = LoadBand(img1, first_row, num_rows, false, false, s == 0 && (cmse_flags & DirectX::CMSE_IMAGE1_X2_BIAS) != 0, scratch1, band1);
+			if(SUCCEEDED(band_hres))
+			{
+				band_hres = LoadBand(img2, first_row, num_rows, false, false, s == 0 && (cmse_flags & DirectX::CMSE_IMAGE2_X2_BIAS) != 0, scratch2, band2);
+			}
+			if(FAILED(band_hres))
+			{
+				HRESULT expected = S_OK;
+				first_failure.compare_exchange_strong(expected, band_hres);
+				return;
+			}
+
+			const bool has_next = s + 1 < result.num_scales;
+			ComputeSSIMBand(band1, band2, first_row, img1.height, GetComparedChannels(*result.image1, *result.image2, cmse_flags), band,
+			                (s == 0 && has_map)? result.map.data() : nullptr,
+			                has_next? const_cast<DirectX::Image*>(pair_scales[s + 1].image1) : nullptr,
+			                has_next? const_cast<DirectX::Image*>(pair_scales[s + 1].image2) : nullptr);
+		});
+
+		HRESULT failure = first_failure.load();
+		if(FAILED(failure))
+		{
+			return failure;
+		}
+
+		/* bands are summed in order so the result does not depend on the scheduling */
+		for(const SSIMBand& band : bands)
+		{
+			SSIMScale& scale = scales[band.result][s];
+			for(size_t c = 0; c < 4; c++)
+			{
+				scale.mean_ssim[c] += band.sum_ssim[c];
+				scale.mean_cs[c] += band.sum_cs[c];
+			}
+		}
+		for(size_t i = 0; i < results.size(); i++)
+		{
+			if(s >= results[i].num_scales)
+			{
+				continue;
+			}
+			SSIMScale& scale = scales[i][s];
+			const double num_pixels = static_cast<double>(scale.image1->width * scale.image1->height);
+			for(size_t c = 0; c < 4; c++)
+			{
+				scale.mean_ssim[c] /= num_pixels;
+				scale.mean_cs[c] /= num_pixels;
+			}
+			scale.owned1.Release();
+			scale.owned2.Release();
+		}
+	}
+
+	for(size_t i = 0; i < results.size(); i++)
+	{
+		SSIMResult& result = results[i];
+		const std::vector<SSIMScale>& pair_scales = scales[i];
+		const unsigned channel_mask = GetComparedChannels(*result.image1, *result.image2, cmse_flags);
+		double total_weight = 0.0;
+		for(size_t j = 0; j < result.num_scales; j++)
+		{
+			total_weight += MSSSIM_WEIGHTS[j];
+		}
+
+		size_t num_channels = 0;
+		double sum = 0.0;
+		for(size_t c = 0; c < 4; c++)
+		{
+			if(!((channel_mask >> c) & 1u))
+			{
+				result.ssimV[c] = std::numeric_limits<double>::quiet_NaN();
+				continue;
+			}
+
+			/* negative terms have no fractional power, so multi-scale clamps them to 0 */
+			double value = pair_scales[0].mean_ssim[c];
+			if(is_multiscale)
+			{
+				const size_t last = result.num_scales - 1;
+				value = std::pow(std::max(pair_scales[last].mean_ssim[c], 0.0), MSSSIM_WEIGHTS[last] / total_weight);
+				for(size_t j = 0; j < last; j++)
+				{
+					value *= std::pow(std::max(pair_scales[j].mean_cs[c], 0.0), MSSSIM_WEIGHTS[j] / total_weight);
+				}
+			}
+			result.ssimV[c] = value;
+			sum += value;
+			num_channels++;
+		}
+		result.ssim = (num_channels > 0)? sum / static_cast<double>(num_channels) : std::numeric_limits<double>::quiet_NaN();
+	}
+	return S_OK;
+}
+
+HRESULT Metrics::ComputeBlockReport(std::vector<ErrorResult>& results, DirectX::CMSE_FLAGS cmse_flags, const std::vector<double>& edges, size_t top_k, BlockReport& report)
+{
+	HRESULT hres = Metrics::ComputeError(results, cmse_flags, REPORT_BLOCK_SIZE);
+	if(FAILED(hres))
+	{
+		return hres;
+	}
+
+	std::vector<ReportChunk> chunks;
+	for(size_t i = 0; i < results.size(); i++)
+	{
+		for(size_t first = 0; first < results[i].map.size(); first += REPORT_CHUNK_BLOCKS)
+		{
+			chunks.push_back({i, first, std::min(first + REPORT_CHUNK_BLOCKS, results[i].map.size()), 0.0, 0.0, {}, {}});
+		}
+	}
+
+	/* each chunk keeps a heap of its top_k with the least bad block in front */
+	Parallel::For(chunks.size(), [&](size_t i)
+	{
+		ReportChunk& chunk = chunks[i];
+		const ErrorResult& result = results[chunk.result];
+		chunk.counts.assign(edges.size() + 1, 0);
+		chunk.worst.reserve(std::min(top_k, chunk.last - chunk.first));
+		for(size_t n = chunk.first; n < chunk.last; n++)
+		{
+			const double mse = result.map[n];
+			const double psnr = (mse == 0.0)? std::numeric_limits<double>::infinity() : -10.0 * std::log10(mse);
+			chunk.counts[std::upper_bound(edges.begin(), edges.end(), psnr) - edges.begin()]++;
+			chunk.sum_mse += mse;
+			chunk.sum_sq_mse += mse * mse;
+			if(top_k == 0)
+			{
+				continue;
+			}
+
+			const BlockEntry entry = {chunk.result, (n / result.map_height) * REPORT_BLOCK_SIZE, (n % result.map_height) * REPORT_BLOCK_SIZE, mse};
+			if(chunk.worst.size() < top_k)
+			{
+				chunk.worst.push_back(entry);
+				std::push_heap(chunk.worst.begin(), chunk.worst.end(), IsWorseBlock);
+			}
+			else if(IsWorseBlock(entry, chunk.worst.front()))
+			{
+				std::pop_heap(chunk.worst.begin(), chunk.worst.end(), IsWorseBlock);
+				chunk.worst.back() = entry;
+				std::push_heap(chunk.worst.begin(), chunk.worst.end(), IsWorseBlock);
+			}
+		}
+	});
+
+	report.num_blocks = 0;
+	report.counts.assign(edges.size() + 1, 0);
+	report.worst.clear();
+	double sum_mse = 0.0, sum_sq_mse = 0.0;
+	for(const ReportChunk& chunk : chunks)
+	{
+		for(size_t k = 0; k < report.counts.size(); k++)
+		{
+			report.counts[k] += chunk.counts[k];
+		}
+		report.num_blocks += chunk.last - chunk.first;
+		sum_mse += chunk.sum_mse;
+		sum_sq_mse += chunk.sum_sq_mse;
+		report.worst.insert(report.worst.end(), chunk.worst.begin(), chunk.worst.end());
+	}
+	const size_t num_worst = std::min(top_k, report.worst.size());
+	std::partial_sort(report.worst.begin(), report.worst.begin() + num_worst, report.worst.end(), IsWorseBlock);
+	report.worst.resize(num_worst);
+
+	const double num_blocks = static_cast<double>(std::max<size_t>(report.num_blocks, 1));
+	report.mean_block_mse = sum_mse / num_blocks;
+	report.std_block_mse = std::sqrt(std::max(sum_sq_mse / num_blocks - report.mean_block_mse * report.mean_block_mse, 0.0));
+
+	/* the pairs are weighed by their pixels */
+	double num_pixels = 0.0;
+	report.mse = 0.0;
+	std::fill(report.mseV, report.mseV + 4, 0.0);
+	std::fill(report.max_abs, report.max_abs + 4, 0.0f);
+	for(const ErrorResult& result : results)
+	{
+		const double pixels = static_cast<double>(result.image1->width * result.image1->height);
+		num_pixels += pixels;
+		for(size_t c = 0; c < 4; c++)
+		{
+			report.mseV[c] += result.mseV[c] * pixels;
+			report.max_abs[c] = std::max(report.max_abs[c], result.max_abs[c]);
+		}
+	}
+	for(size_t c = 0; c < 4; c++)
+	{
+		report.mseV[c] /= std::max(num_pixels, 1.0);
+		report.mse += report.mseV[c];
+	}
+	report.psnr = (report.mse == 0.0)? std::numeric_limits<double>::infinity() : -10.0 * std::log10(report.mse);
+	return S_OK;
+}
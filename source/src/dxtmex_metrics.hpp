@@ -0,0 +1,75 @@
+#pragma once
+
+#include <vector>
+
+#include "mex.h"
+#include "DirectXTex.h"
+
+namespace DXTMEX
+{
+	/* image comparison computed natively. every subresource pair of a call is split into row bands which are
+	 * decoded to linear RGBA floats and reduced in parallel, so compressed inputs never exist in full as floats. */
+	namespace Metrics
+	{
+		struct ErrorResult
+		{
+			const DirectX::Image* image1;
+			const DirectX::Image* image2;
+			double                mse;         /* summed over the channels, as DirectX::ComputeMSE reports it */
+			double                mseV[4];
+			double                psnr;        /* of mse with a peak of 1 like TargetPSNR of COMPRESS, Inf if equal */
+			float                 max_abs[4];  /* largest absolute difference per channel */
+			size_t                map_width;   /* blocks */
+			size_t                map_height;
+			std::vector<double>   map;         /* column-major, mse of each block */
+		};
+
+		/* fills in the results for each pair of equally sized images, honoring the cmse_flags like DirectX::ComputeMSE.
+		 * ignored channels report 0. the error map is built in the same pass unless block_size is 0. */
+		HRESULT ComputeError(std::vector<ErrorResult>& results, DirectX::CMSE_FLAGS cmse_flags, size_t block_size);
+
+		struct SSIMResult
+		{
+			const DirectX::Image* image1;
+			const DirectX::Image* image2;
+			double                ssim;        /* mean over the compared channels */
+			double                ssimV[4];    /* NaN for channels which are ignored or in neither format */
+			size_t                num_scales;
+			std::vector<float>    map;         /* column-major, per pixel mean over the compared channels */
+		};
+
+		/* structural similarity of each pair of equally sized images with an 11 tap gaussian window (sigma 1.5),
+		 * comparing the stored values, so sRGB is not linearized. the ignore and X2 bias cmse_flags apply.
+		 * multi-scale uses up to 5 scales, as many as keep the window inside the smallest one, with the weights
+		 * renormalized. the map is of single-scale SSIM and is only built if has_map. */
+		HRESULT ComputeSSIM(std::vector<SSIMResult>& results, DirectX::CMSE_FLAGS cmse_flags, bool is_multiscale, bool has_map);
+
+		struct BlockEntry
+		{
+			size_t result;     /* index of the pair */
+			size_t x;          /* first pixel of the block */
+			size_t y;
+			double mse;
+		};
+
+		struct BlockReport
+		{
+			size_t                  num_blocks;
+			double                  mse;             /* over the pixels of every pair */
+			double                  mseV[4];
+			double                  psnr;
+			float                   max_abs[4];
+			double                  mean_block_mse;  /* every block weighs the same */
+			double                  std_block_mse;
+			std::vector<size_t>     counts;          /* of block psnr, bin i spans [edges[i-1], edges[i]) with open ends */
+			std::vector<BlockEntry> worst;           /* worst first, ties go to the earlier block */
+		};
+
+		/* the error of every 4x4 block of each pair, taken in the same decode and compare pass as ComputeError, then
+		 * summarized over chunks of blocks into a histogram over the ascending psnr edges and the top_k worst blocks */
+		HRESULT ComputeBlockReport(std::vector<ErrorResult>& results, DirectX::CMSE_FLAGS cmse_flags, const std::vector<double>& edges, size_t top_k, BlockReport& report);
+
+		/* pixels per band, rounded to whole rows of blocks */
+		constexpr size_t BAND_PIXELS = 65536;
+	}
+}
@@ -14,11 +14,12 @@
 #include <stdio.h>
 #include <stdarg.h>
 #include <errno.h>
+#include <thread>
 
 #ifndef _WIN32
 #  include <string.h>
 #else
-HRESULT hres = 0;
+thread_local HRESULT hres = 0;
 #endif
 
 #define VALUE_AS_STRING(value) #value
@@ -56,6 +57,8 @@ const char* MEXError::warning_help_message = "";
 
 namespace
 {
+	std::thread::id g_main_thread;
+	
 	/**
 	 * Writes out the severity string.
 	 *
@@ -185,6 +188,12 @@ void MEXError::PrintMexError(const char* file_name, int line, unsigned int error
 	sprintf(id_buffer, MEU_ID_FORMAT, MEXError::g_library_name, error_id);
 	sprintf(full_message, MEU_ERROR_MESSAGE_FORMAT, error_id, file_name, line, error_severity_buffer, error_message_buffer, system_error_string_buffer, MEXError::error_help_message);
 	
+	if(!MEXError::IsMainThread())
+	{
+		/* the callback runs when the error reaches the main thread */
+		throw MEXError::WorkerError{error_severity, id_buffer, full_message};
+	}
+	
 	if(MEXError::error_callback != nullptr)
 	{
 		MEXError::error_callback(error_severity);
@@ -194,6 +203,28 @@ void MEXError::PrintMexError(const char* file_name, int line, unsigned int error
 }
 
 
+void MEXError::SetMainThread()
+{
+	g_main_thread = std::this_thread::get_id();
+}
+
+
+bool MEXError::IsMainThread()
+{
+	return std::this_thread::get_id() == g_main_thread;
+}
+
+
+void MEXError::RethrowWorkerError(const WorkerError& error)
+{
+	if(MEXError::error_callback != nullptr)
+	{
+		MEXError::error_callback(error.severity);
+	}
+	mexErrMsgIdAndTxt(error.id.c_str(), "%s", error.message.c_str());
+}
+
+
 void MEXError::PrintMexWarning(const char* warn_id, const char* warn_message, ...)
 {
 	va_list va;
@@ -9,13 +9,15 @@
 
 #pragma once
 
+#include <string>
+
 #ifdef _WIN32
 #  ifndef WIN32_LEAN_AND_MEAN
 #    define WIN32_LEAN_AND_MEAN
 #  endif
 #  include <windows.h>
    typedef DWORD errcode_T;
-   extern HRESULT hres;
+   extern thread_local HRESULT hres;
 #else
    typedef int errcode_T;
 #  if(((_POSIX_C_SOURCE >= 200112L || _XOPEN_SOURCE >= 600) && !_GNU_SOURCE) || defined(__APPLE__))
@@ -61,6 +63,35 @@ namespace MEXError
 	 */
 	void PrintMexWarning(const char* warn_id, const char* warn_message, ...);
 	
+	
+	/**
+	 * An error raised by PrintMexError off the main thread, where the MATLAB API may not be used.
+	 * The thread which joins the worker rethrows it with RethrowWorkerError.
+	 */
+	struct WorkerError
+	{
+		unsigned int severity;
+		std::string  id;
+		std::string  message;
+	};
+	
+	/**
+	 * Marks the calling thread as the MATLAB thread. Call at the start of the gateway.
+	 */
+	void SetMainThread();
+	
+	/**
+	 * @return Whether the calling thread is the MATLAB thread.
+	 */
+	bool IsMainThread();
+	
+	/**
+	 * Raises an error caught from a worker in MATLAB. Main thread only.
+	 *
+	 * @param error The error thrown by the worker.
+	 */
+	void RethrowWorkerError(const WorkerError& error);
+	
 	extern const char* g_library_name;
 	
 	extern void (*error_callback)(unsigned int);
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "dxtmex_mexerror.hpp"
+#include "dxtmex_progress.hpp"
+#include "dxtmex_stats.hpp"
+#include "dxtmex_trace.hpp"
+
+namespace DXTMEX
+{
+	namespace Parallel
+	{
+		inline size_t GetNumberOfThreads()
+		{
+			return std::max(std::thread::hardware_concurrency(), 1u);
+		}
+		
+		/* raises an exception caught from func once every thread is joined. on the main thread it becomes a MATLAB
+		 * error, elsewhere it is rethrown for the job to collect. */
+		inline void RaiseFailure(std::exception_ptr failure)
+		{
+			if(!MEXError::IsMainThread())
+			{
+				std::rethrow_exception(failure);
+			}
+			
+			/* the MATLAB error is raised outside of the handlers */
+			MEXError::WorkerError worker_error = {0, "", ""};
+			bool is_failed = false;
+			std::string what;
+			try
+			{
+				std::rethrow_exception(failure);
+			}
+			catch(const MEXError::WorkerError& e)
+			{
+				worker_error = e;
+			}
+			catch(const std::exception& e)
+			{
+				is_failed = true;
+				what = e.what();
+			}
+			
+			if(!worker_error.id.empty())
+			{
+				MEXError::RethrowWorkerError(worker_error);
+			}
+			else if(is_failed)
+			{
+				MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_INTERNAL, "WorkerError", "A worker thread failed: %s", what.c_str());
+			}
+		}
+		
+		/* runs func(i) for every i in [0, count) across the hardware threads.
+		 * func must not call into the MATLAB API. when called from the main thread
+		 * it stops handing out work and raises an error once the call is cancelled.
+		 * if func throws, no more work is handed out and the first exception is raised
+		 * on the calling thread after all threads are joined. */
+		template <typename F>
+		void For(size_t count, F&& func)
+		{
+			std::exception_ptr failure;
+			const size_t num_threads = std::min(count, GetNumberOfThreads());
+			Stats::AddThreads(std::max<size_t>(num_threads, 1));
+			if(num_threads <= 1)
+			{
+				try
+				{
+					for(size_t i = 0; i < count && !Progress::Poll(); i++)
+					{
+						Trace::Scope trace_scope("task", "worker");
+						func(i);
+					}
+				}
+				catch(...)
+				{
+					failure = std::current_exception();
+				}
+				if(failure)
+				{
+					RaiseFailure(failure);
+				}
+				Progress::CheckInterrupt();
+				return;
+			}
+			
+			/* background jobs run to completion, only a call on the main thread is cancelled */
+			const bool is_cancellable = MEXError::IsMainThread();
+			const bool is_call_thread = Progress::IsCallThread();
+			std::atomic<size_t> next(0);
+			std::atomic<bool> is_failed(false);
+			std::mutex failure_lock;
+			auto worker = [&](bool is_main)
+			{
+				/* the workers count toward the progress of whichever call started them */
+				Progress::CallScope call_scope(is_call_thread);
+				try
+				{
+					size_t i;
+					while(!is_failed.load() && !(is_main? Progress::Poll() : is_cancellable && Progress::IsCancelled()) && (i = next.fetch_add(1)) < count)
+					{
+						Trace::Scope trace_scope("task", "worker");
+						func(i);
+					}
+				}
+				catch(...)
+				{
+					std::lock_guard<std::mutex> guard(failure_lock);
+					if(!failure)
+					{
+						failure = std::current_exception();
+					}
+					is_failed = true;
+				}
+			};
+			
+			/* if a thread cannot be started the ones running take its share */
+			std::vector<std::thread> threads;
+			threads.reserve(num_threads - 1);
+			for(size_t i = 1; i < num_threads; i++)
+			{
+				try
+				{
+					threads.emplace_back(worker, false);
+				}
+				catch(const std::system_error&)
+				{
+					break;
+				}
+			}
+			worker(true);
+			for(auto& thread : threads)
+			{
+				thread.join();
+			}
+			if(failure)
+			{
+				RaiseFailure(failure);
+			}
+			Progress::CheckInterrupt();
+		}
+	}
+}
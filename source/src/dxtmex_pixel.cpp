@@ -2,6 +2,9 @@
 #include "dxtmex_maps.hpp"
 #include "dxtmex_mexerror.hpp"
 #include "dxtmex_pixel.hpp"
+#include "dxtmex_simd.hpp"
+
+#include <cstring>
 
 using namespace DXTMEX;
 	void DXGIPixel::SetChannels(DXGI_FORMAT fmt)
@@ -739,9 +742,23 @@ using namespace DXTMEX;
 			max_out_idx = (out_idx[i] > max_out_idx)? out_idx[i] : max_out_idx;
 		}
 		
-		const mwSize out_dims[] = {this->_image->height, this->_image->width, max_out_idx + 1};
+		/* planar output is H x W x C, interleaved output is C x W x H */
+		this->_num_out_channels = max_out_idx + 1;
+		mwSize out_dims[] = {this->_image->height, this->_image->width, this->_num_out_channels};
+		if(this->_interleaved)
+		{
+			out_dims[0] = this->_num_out_channels;
+			out_dims[2] = this->_image->height;
+		}
 		mwSize ndim = ARRAYSIZE(out_dims);
 		
+		/* output planes which will not be written by the extractor */
+		bool plane_used[MAX_CHANNELS] = {false};
+		for(i = 0; i < num_idx; i++)
+		{
+			plane_used[out_idx[i]] = true;
+		}
+		
 		/* check channels requested are inside bounds */
 		for(i = 0; i < num_idx; i++)
 		{
@@ -811,12 +828,12 @@ using namespace DXTMEX;
 				case mxSINGLE_CLASS:
 				case mxDOUBLE_CLASS:
 				{
-					out = mxCreateNumericArray(ndim, out_dims, out_class, mxREAL);
+					out = this->CreateOutput(out_dims, ndim, out_class, plane_used);
 					break;
 				}
 				case mxLOGICAL_CLASS:
 				{
-					out = mxCreateLogicalArray(ndim, out_dims);
+					out = this->CreateOutput(out_dims, ndim, mxLOGICAL_CLASS, plane_used);
 					break;
 				}
 				case mxINT64_CLASS:
@@ -851,17 +868,17 @@ using namespace DXTMEX;
 					/* determine MATLAB class width */
 					if(max_width <= 8)
 					{
-						out = mxCreateNumericArray(ndim, out_dims, mxINT8_CLASS, mxREAL);
+						out = this->CreateOutput(out_dims, ndim, mxINT8_CLASS, plane_used);
 						storage_function = &DXGIPixel::ChannelElement<DATATYPE::SNORM, mxInt8>::StoreMX;
 					}
 					else if(max_width <= 16)
 					{
-						out = mxCreateNumericArray(ndim, out_dims, mxINT16_CLASS, mxREAL);
+						out = this->CreateOutput(out_dims, ndim, mxINT16_CLASS, plane_used);
 						storage_function = &DXGIPixel::ChannelElement<DATATYPE::SNORM, mxInt16>::StoreMX;
 					}
 					else
 					{
-						out = mxCreateNumericArray(ndim, out_dims, mxINT32_CLASS, mxREAL);
+						out = this->CreateOutput(out_dims, ndim, mxINT32_CLASS, plane_used);
 						storage_function = &DXGIPixel::ChannelElement<DATATYPE::SNORM, mxInt32>::StoreMX;
 					}
 					break;
@@ -873,35 +890,35 @@ using namespace DXTMEX;
 					/* determine MATLAB class width */
 					if(max_width == 1)
 					{
-						out = mxCreateLogicalArray(ndim, out_dims);
+						out = this->CreateOutput(out_dims, ndim, mxLOGICAL_CLASS, plane_used);
 						storage_function = &DXGIPixel::ChannelElement<DATATYPE::UNORM, mxLogical>::StoreMX;
 					}
 					else if(max_width <= 8)
 					{
-						out = mxCreateNumericArray(ndim, out_dims, mxUINT8_CLASS, mxREAL);
+						out = this->CreateOutput(out_dims, ndim, mxUINT8_CLASS, plane_used);
 						storage_function = &DXGIPixel::ChannelElement<DATATYPE::UNORM, mxUint8>::StoreMX;
 					}
 					else if(max_width <= 16)
 					{
-						out = mxCreateNumericArray(ndim, out_dims, mxUINT16_CLASS, mxREAL);
+						out = this->CreateOutput(out_dims, ndim, mxUINT16_CLASS, plane_used);
 						storage_function = &DXGIPixel::ChannelElement<DATATYPE::UNORM, mxUint16>::StoreMX;
 					}
 					else
 					{
-						out = mxCreateNumericArray(ndim, out_dims, mxUINT32_CLASS, mxREAL);
+						out = this->CreateOutput(out_dims, ndim, mxUINT32_CLASS, plane_used);
 						storage_function = &DXGIPixel::ChannelElement<DATATYPE::UNORM, mxUint32>::StoreMX;
 					}
 					break;
 				}
 				case DATATYPE::FLOAT:
 				{
-					out = mxCreateNumericArray(ndim, out_dims, mxSINGLE_CLASS, mxREAL);
+					out = this->CreateOutput(out_dims, ndim, mxSINGLE_CLASS, plane_used);
 					storage_function = &DXGIPixel::ChannelElement<DATATYPE::FLOAT, mxSingle>::StoreMX;
 					break;
 				}
 				case DATATYPE::SRGB:
 				{
-					out = mxCreateNumericArray(ndim, out_dims, mxUINT8_CLASS, mxREAL);
+					out = this->CreateOutput(out_dims, ndim, mxUINT8_CLASS, plane_used);
 					storage_function = &DXGIPixel::ChannelElement<DATATYPE::SRGB, mxUint8>::StoreMX;
 					break;
 				}
@@ -926,9 +943,13 @@ using namespace DXTMEX;
 						{
 							max_out_idx = (out_idx[i] > max_out_idx)? out_idx[i] : max_out_idx;
 						}
+						else
+						{
+							plane_used[out_idx[i]] = false;
+						}
 					}
 					
-					out = mxCreateNumericArray(ndim, out_dims, mxSINGLE_CLASS, mxREAL);
+					out = this->CreateOutput(out_dims, ndim, mxSINGLE_CLASS, plane_used);
 					
 					auto data = (mxSingle*)mxGetData(out);
 					auto pixels = (uint32_t*)this->_image->pixels;
@@ -961,7 +982,7 @@ using namespace DXTMEX;
 						{
 							if(ch_idx[src_idx] != 3)
 							{
-								data[dst_idx + out_idx[j]*this->_num_pixels] = ((pixel_data & masks[ch_idx[j]]) >> this->_channels[ch_idx[j]].offset)*scalar;
+								data[this->OutputIndex(src_idx, dst_idx, out_idx[j])] = ((pixel_data & masks[ch_idx[j]]) >> this->_channels[ch_idx[j]].offset)*scalar;
 							}
 						}
 						dst_idx += this->_image->height;
@@ -974,7 +995,7 @@ using namespace DXTMEX;
 				}
 				case DATATYPE::XR_BIAS:
 				{
-					out = mxCreateNumericArray(ndim, out_dims, mxSINGLE_CLASS, mxREAL);
+					out = this->CreateOutput(out_dims, ndim, mxSINGLE_CLASS, plane_used);
 					storage_function = &DXGIPixel::ChannelElement<DATATYPE::XR_BIAS, mxSingle>::StoreMX;
 					break;
 				}
@@ -989,22 +1010,22 @@ using namespace DXTMEX;
 					/* determine MATLAB class width */
 					if(max_width == 1)
 					{
-						out = mxCreateLogicalArray(ndim, out_dims);
+						out = this->CreateOutput(out_dims, ndim, mxLOGICAL_CLASS, plane_used);
 						storage_function = &DXGIPixel::ChannelElement<DATATYPE::SINT, mxLogical>::StoreMX;
 					}
 					else if(max_width <= 8)
 					{
-						out = mxCreateNumericArray(ndim, out_dims, mxINT8_CLASS, mxREAL);
+						out = this->CreateOutput(out_dims, ndim, mxINT8_CLASS, plane_used);
 						storage_function = &DXGIPixel::ChannelElement<DATATYPE::SINT, mxInt8>::StoreMX;
 					}
 					else if(max_width <= 16)
 					{
-						out = mxCreateNumericArray(ndim, out_dims, mxINT16_CLASS, mxREAL);
+						out = this->CreateOutput(out_dims, ndim, mxINT16_CLASS, plane_used);
 						storage_function = &DXGIPixel::ChannelElement<DATATYPE::SINT, mxInt16>::StoreMX;
 					}
 					else
 					{
-						out = mxCreateNumericArray(ndim, out_dims, mxINT32_CLASS, mxREAL);
+						out = this->CreateOutput(out_dims, ndim, mxINT32_CLASS, plane_used);
 						storage_function = &DXGIPixel::ChannelElement<DATATYPE::SINT, mxInt32>::StoreMX;
 					}
 					break;
@@ -1016,22 +1037,22 @@ using namespace DXTMEX;
 					/* determine MATLAB class width */
 					if(max_width == 1)
 					{
-						out = mxCreateLogicalArray(ndim, out_dims);
+						out = this->CreateOutput(out_dims, ndim, mxLOGICAL_CLASS, plane_used);
 						storage_function = &DXGIPixel::ChannelElement<DATATYPE::UINT, mxLogical>::StoreMX;
 					}
 					else if(max_width <= 8)
 					{
-						out = mxCreateNumericArray(ndim, out_dims, mxUINT8_CLASS, mxREAL);
+						out = this->CreateOutput(out_dims, ndim, mxUINT8_CLASS, plane_used);
 						storage_function = &DXGIPixel::ChannelElement<DATATYPE::UINT, mxUint8>::StoreMX;
 					}
 					else if(max_width <= 16)
 					{
-						out = mxCreateNumericArray(ndim, out_dims, mxUINT16_CLASS, mxREAL);
+						out = this->CreateOutput(out_dims, ndim, mxUINT16_CLASS, plane_used);
 						storage_function = &DXGIPixel::ChannelElement<DATATYPE::UINT, mxUint16>::StoreMX;
 					}
 					else
 					{
-						out = mxCreateNumericArray(ndim, out_dims, mxUINT32_CLASS, mxREAL);
+						out = this->CreateOutput(out_dims, ndim, mxUINT32_CLASS, plane_used);
 						storage_function = &DXGIPixel::ChannelElement<DATATYPE::UINT, mxUint32>::StoreMX;
 					}
 					break;
@@ -1043,22 +1064,22 @@ using namespace DXTMEX;
 					/* determine MATLAB class width */
 					if(max_width == 1)
 					{
-						out = mxCreateLogicalArray(ndim, out_dims);
+						out = this->CreateOutput(out_dims, ndim, mxLOGICAL_CLASS, plane_used);
 						storage_function = &DXGIPixel::ChannelElement<DATATYPE::TYPELESS, mxLogical>::StoreMX;
 					}
 					else if(max_width <= 8)
 					{
-						out = mxCreateNumericArray(ndim, out_dims, mxUINT8_CLASS, mxREAL);
+						out = this->CreateOutput(out_dims, ndim, mxUINT8_CLASS, plane_used);
 						storage_function = &DXGIPixel::ChannelElement<DATATYPE::TYPELESS, mxUint8>::StoreMX;
 					}
 					else if(max_width <= 16)
 					{
-						out = mxCreateNumericArray(ndim, out_dims, mxUINT16_CLASS, mxREAL);
+						out = this->CreateOutput(out_dims, ndim, mxUINT16_CLASS, plane_used);
 						storage_function = &DXGIPixel::ChannelElement<DATATYPE::TYPELESS, mxUint16>::StoreMX;
 					}
 					else
 					{
-						out = mxCreateNumericArray(ndim, out_dims, mxUINT32_CLASS, mxREAL);
+						out = this->CreateOutput(out_dims, ndim, mxUINT32_CLASS, plane_used);
 						storage_function = &DXGIPixel::ChannelElement<DATATYPE::TYPELESS, mxUint32>::StoreMX;
 					}
 					break;
@@ -1080,6 +1101,30 @@ using namespace DXTMEX;
 		}
 		
 		void* data = mxGetData(out);
+		if(this->_interleaved && this->IsDirectCopy(ch_idx, out_idx, num_idx, mxGetClassID(out)))
+		{
+			/* pixel memory is already in the output order */
+			const size_t row_size = this->_image->width * this->_pixel_byte_width;
+			if(this->_image->rowPitch == row_size)
+			{
+				memcpy(data, this->_image->pixels, row_size * this->_image->height);
+			}
+			else
+			{
+				for(i = 0; i < this->_image->height; i++)
+				{
+					memcpy((uint8_t*)data + i * row_size, this->_image->pixels + i * this->_image->rowPitch, row_size);
+				}
+			}
+			return;
+		}
+		
+		/* reordering without conversion is a transpose */
+		if(!this->_interleaved && this->ExtractPlanar(ch_idx, out_idx, num_idx, mxGetClassID(out), data))
+		{
+			return;
+		}
+		
 		switch(this->_pixel_bit_width)
 		{
 			case 128: /* always uniform width with 4 channels */
@@ -1126,7 +1171,7 @@ using namespace DXTMEX;
 						for(j = 0; j < num_idx; j++)
 						{
 							storage_function(data, 
-										  dst_idx + out_idx[j] * this->_num_pixels, 
+										  this->OutputIndex(src_idx, dst_idx, out_idx[j]), 
 										  extractor.Extract(src_idx, ch_idx[j]),
 										  this->_channels[ch_idx[j]].width);
 						}
@@ -1177,7 +1222,7 @@ using namespace DXTMEX;
 						for(j = 0; j < num_idx; j++)
 						{
 							storage_function(data, 
-										  dst_idx + out_idx[j] * this->_num_pixels, 
+										  this->OutputIndex(src_idx, dst_idx, out_idx[j]), 
 										  extractor.Extract(src_idx, ch_idx[j]),
 										  this->_channels[ch_idx[j]].width);
 						}
@@ -1222,7 +1267,7 @@ using namespace DXTMEX;
 						for(j = 0; j < num_idx; j++)
 						{
 							storage_function(data, 
-										  dst_idx + out_idx[j] * this->_num_pixels, 
+										  this->OutputIndex(src_idx, dst_idx, out_idx[j]), 
 										  extractor.Extract(src_idx, ch_idx[j]),
 										  this->_channels[ch_idx[j]].width);
 						}
@@ -1283,7 +1328,7 @@ using namespace DXTMEX;
 							channel_data = ((page >> (k - 1)) & 1u) != 0;
 							for(l = 0; l < num_idx; l++)
 							{
-								data_l[dst_idx + out_idx[l] * this->_num_pixels] = channel_data;
+								data_l[this->OutputIndex(src_idx, dst_idx, out_idx[l])] = channel_data;
 							}
 						}
 					}
@@ -1301,7 +1346,7 @@ using namespace DXTMEX;
 							channel_data = ((uint8_t)(page >> (k - 1)) & 1u) != 0;
 							for(l = 0; l < num_idx; l++)
 							{
-								data_l[dst_idx + out_idx[l] * this->_num_pixels] = channel_data;
+								data_l[this->OutputIndex(src_idx, dst_idx, out_idx[l])] = channel_data;
 							}
 						}
 					}
@@ -1317,7 +1362,7 @@ using namespace DXTMEX;
 						channel_data = ((uint8_t)(page >> (k - 1)) & 1u) != 0;
 						for(l = 0; l < num_idx; l++)
 						{
-							data_l[dst_idx + out_idx[l] * this->_num_pixels] = channel_data;
+							data_l[this->OutputIndex(src_idx, dst_idx, out_idx[l])] = channel_data;
 						}
 					}
 				}
@@ -1329,6 +1374,173 @@ using namespace DXTMEX;
 		}
 	}
 	
+	mxArray* DXGIPixel::CreateOutput(const mwSize* dims, mwSize ndim, mxClassID out_class, const bool* plane_used)
+	{
+		mwSize i;
+		mxArray* out;
+		if(this->_target != nullptr)
+		{
+			/* fill the supplied array in place. this bypasses copy-on-write, so any variable sharing its data changes too */
+			if(mxGetClassID(this->_target) != out_class || mxIsComplex(this->_target))
+			{
+				MEXError::PrintMexError(MEU_FL,
+				                        MEU_SEVERITY_USER,
+				                        "OutputClassError",
+				                        "The output array class '%s' does not match the class of the matrix for this format.",
+				                        mxGetClassName(this->_target));
+			}
+			
+			const mwSize target_ndim = mxGetNumberOfDimensions(this->_target);
+			const mwSize* target_dims = mxGetDimensions(this->_target);
+			bool size_matches = (target_ndim <= ndim);
+			for(i = 0; i < ndim && size_matches; i++)
+			{
+				size_matches = (((i < target_ndim)? target_dims[i] : 1) == dims[i]);
+			}
+			if(!size_matches)
+			{
+				MEXError::PrintMexError(MEU_FL,
+				                        MEU_SEVERITY_USER,
+				                        "OutputSizeError",
+				                        "The output array must be of size %llux%llux%llu.",
+				                        dims[0], dims[1], dims[2]);
+			}
+			out = this->_target;
+		}
+		else if(out_class == mxLOGICAL_CLASS)
+		{
+			/* already zeroed */
+			return mxCreateLogicalArray(ndim, dims);
+		}
+		else
+		{
+			out = mxCreateUninitNumericArray(ndim, const_cast<mwSize*>(dims), out_class, mxREAL);
+			if(out == nullptr)
+			{
+				return nullptr;
+			}
+		}
+		
+		/* the output is not zeroed, so clear any planes the extractor will skip */
+		if(this->_interleaved)
+		{
+			for(i = 0; i < dims[0]; i++)
+			{
+				if(!plane_used[i])
+				{
+					memset(mxGetData(out), 0, mxGetNumberOfElements(out) * mxGetElementSize(out));
+					break;
+				}
+			}
+		}
+		else
+		{
+			const size_t plane_size = dims[0] * dims[1] * mxGetElementSize(out);
+			for(i = 0; i < dims[2]; i++)
+			{
+				if(!plane_used[i])
+				{
+					memset((char*)mxGetData(out) + i * plane_size, 0, plane_size);
+				}
+			}
+		}
+		return out;
+	}
+	
+	bool DXGIPixel::IsDirectCopy(const size_t* ch_idx, const size_t* out_idx, size_t num_idx, mxClassID out_class)
+	{
+		size_t i;
+		if(!this->_has_uniform_width || !this->_has_uniform_datatype || num_idx != this->_num_channels)
+		{
+			return false;
+		}
+		
+		/* padded formats like B8G8R8X8 cannot be copied */
+		const uint32_t width = this->_channels[0].width;
+		if(width * this->_num_channels != this->_pixel_bit_width)
+		{
+			return false;
+		}
+		
+		for(i = 0; i < num_idx; i++)
+		{
+			if(ch_idx[i] != i || out_idx[i] != i)
+			{
+				return false;
+			}
+		}
+		return this->IsIdentityStorage(out_class);
+	}
+	
+	bool DXGIPixel::IsIdentityStorage(mxClassID out_class)
+	{
+		const uint32_t width = this->_channels[0].width;
+		bool is_signed;
+		uint32_t class_width;
+		switch(out_class)
+		{
+			case mxINT8_CLASS:   is_signed = true;  class_width = 8;  break;
+			case mxUINT8_CLASS:  is_signed = false; class_width = 8;  break;
+			case mxINT16_CLASS:  is_signed = true;  class_width = 16; break;
+			case mxUINT16_CLASS: is_signed = false; class_width = 16; break;
+			case mxINT32_CLASS:  is_signed = true;  class_width = 32; break;
+			case mxUINT32_CLASS: is_signed = false; class_width = 32; break;
+			case mxSINGLE_CLASS: return this->_channels[0].datatype == DATATYPE::FLOAT && width == 32;
+			default:             return false;
+		}
+		
+		if(class_width != width)
+		{
+			return false;
+		}
+		
+		/* the storage functions are identities for these when widths match */
+		switch(this->_channels[0].datatype)
+		{
+			case DATATYPE::TYPELESS: return true;
+			case DATATYPE::UNORM:
+			case DATATYPE::UINT:
+			case DATATYPE::SRGB:     return !is_signed;
+			case DATATYPE::SNORM:
+			case DATATYPE::SINT:     return is_signed;
+			default:                 return false;
+		}
+	}
+	
+	bool DXGIPixel::ExtractPlanar(const size_t* ch_idx, const size_t* out_idx, size_t num_idx, mxClassID out_class, void* data)
+	{
+		size_t i;
+		if(!this->_has_uniform_width || !this->_has_uniform_datatype || !this->IsIdentityStorage(out_class))
+		{
+			return false;
+		}
+		
+		/* padding like the X of B8G8R8X8 is just an element no plane asks for */
+		const uint32_t width = this->_channels[0].width;
+		const size_t elem_size = width / 8u;
+		const size_t elems_per_pixel = this->_pixel_bit_width / width;
+		if(this->_pixel_bit_width % width != 0 || elems_per_pixel > MAX_CHANNELS)
+		{
+			return false;
+		}
+		
+		uint8_t* planes[MAX_CHANNELS] = {nullptr};
+		for(i = 0; i < num_idx; i++)
+		{
+			const uint32_t offset = this->_channels[ch_idx[i]].offset;
+			
+			/* a channel stored to several planes is left to the general path */
+			if(offset % width != 0 || planes[offset / width] != nullptr)
+			{
+				return false;
+			}
+			planes[offset / width] = (uint8_t*)data + out_idx[i] * this->_num_pixels * elem_size;
+		}
+		
+		SIMD::ExtractPlanar(this->_image->pixels, this->_image->rowPitch, this->_image->width, this->_image->height, elems_per_pixel, elem_size, planes);
+		return true;
+	}
+	
 	void DXGIPixel::ExtractRGB(mxArray*& mx_rgb)
 	{
 		size_t ch_idx[MAX_CHANNELS];
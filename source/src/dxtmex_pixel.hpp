@@ -64,6 +64,9 @@ namespace DXTMEX
 		_num_pixels(image->width * image->height),
 		_channels{},
 		_image(image),
+		_target(nullptr),
+		_interleaved(false),
+		_num_out_channels(0),
 		_has_uniform_datatype(false),
 		_has_uniform_width(false)
 		{
@@ -75,6 +78,29 @@ namespace DXTMEX
 			this->_image = image;
 		}
 		
+		/* extract into an existing array instead of allocating a new one */
+		void SetOutput(mxArray* target)
+		{
+			this->_target = target;
+		}
+		
+		/* extract as C x W x H instead of H x W x C */
+		void SetInterleaved(bool interleaved)
+		{
+			this->_interleaved = interleaved;
+		}
+		
+		size_t GetNumChannels() const
+		{
+			return this->_num_channels;
+		}
+		
+		/* only formats with a uniform datatype can be extracted to a single matrix */
+		bool HasUniformDatatype() const
+		{
+			return this->_has_uniform_datatype;
+		}
+		
 		void ExtractChannels(const size_t* ch_idx, const size_t* out_idx, size_t num_idx, mxArray*& out, mxClassID out_class = mxUNKNOWN_CLASS);
 		inline void ExtractChannels(size_t ch_idx, size_t out_idx,  mxArray*& out, mxClassID out_class = mxUNKNOWN_CLASS)
 		{
@@ -106,6 +132,9 @@ namespace DXTMEX
 		const size_t            _num_pixels;
 		PixelChannel            _channels[MAX_CHANNELS];
 		const DirectX::Image*   _image;
+		mxArray*                _target;
+		bool                    _interleaved;
+		size_t                  _num_out_channels;
 		bool                    _has_uniform_datatype;
 		bool                    _has_uniform_width;
 		
@@ -140,6 +169,15 @@ namespace DXTMEX
 		struct ChannelElement;
 		
 		void SetChannels(DXGI_FORMAT);
+		mxArray* CreateOutput(const mwSize* dims, mwSize ndim, mxClassID out_class, const bool* plane_used);
+		bool IsDirectCopy(const size_t* ch_idx, const size_t* out_idx, size_t num_idx, mxClassID out_class);
+		bool IsIdentityStorage(mxClassID out_class);
+		bool ExtractPlanar(const size_t* ch_idx, const size_t* out_idx, size_t num_idx, mxClassID out_class, void* data);
+		
+		inline mwIndex OutputIndex(size_t src_idx, mwIndex dst_idx, size_t out_ch)
+		{
+			return this->_interleaved? src_idx * this->_num_out_channels + out_ch : dst_idx + out_ch * this->_num_pixels;
+		}
 		
 		template <typename T>
 		inline void StoreUniformChannels(const size_t* ch_idx, const size_t* out_idx,  size_t num_idx, void* data, StorageFunction storage_function)
@@ -155,7 +193,7 @@ namespace DXTMEX
 				T* v_pix = reinterpret_cast<T*>(this->_image->pixels + src_idx*this->_pixel_byte_width);
 				for(size_t j = 0; j < num_idx; j++)
 				{
-					storage_function(data, dst_idx + out_idx[j] * this->_num_pixels, *(v_pix + ch_idx[j]), sizeof(T) * 8u);
+					storage_function(data, this->OutputIndex(src_idx, dst_idx, out_idx[j]), *(v_pix + ch_idx[j]), sizeof(T) * 8u);
 				}
 			}
 		}
@@ -0,0 +1,143 @@
+#include <atomic>
+#include <chrono>
+
+#include "dxtmex_progress.hpp"
+#include "dxtmex_mexerror.hpp"
+
+/* undocumented, exported by libut */
+extern "C" bool utIsInterruptPending(void);
+
+using namespace DXTMEX;
+
+namespace
+{
+	std::atomic<bool>   g_is_cancelled(false);
+	std::atomic<size_t> g_done(0);
+	std::atomic<size_t> g_total(0);
+	
+	mxArray*                              g_callback = nullptr;
+	double                                g_interval = Progress::DEFAULT_INTERVAL;
+	std::chrono::steady_clock::time_point g_last_report;
+	
+	/* set on workers started by the current call, the main thread always counts */
+	thread_local bool t_is_call_worker = false;
+	
+	void Report()
+	{
+		mxArray* args[3] = {g_callback, mxCreateDoubleScalar(static_cast<double>(g_done.load())), mxCreateDoubleScalar(static_cast<double>(g_total.load()))};
+		
+		/* an error in the callback cancels the call rather than unwinding past the workers */
+		mxArray* exception = mexCallMATLABWithTrap(0, nullptr, 3, args, "feval");
+		mxDestroyArray(args[1]);
+		mxDestroyArray(args[2]);
+		if(exception != nullptr)
+		{
+			mxDestroyArray(exception);
+			g_is_cancelled = true;
+		}
+		g_last_report = std::chrono::steady_clock::now();
+	}
+}
+
+void Progress::Reset()
+{
+	g_is_cancelled = false;
+	g_done = 0;
+	g_total = 0;
+	if(g_callback != nullptr)
+	{
+		mxDestroyArray(g_callback);
+		g_callback = nullptr;
+	}
+	g_interval = DEFAULT_INTERVAL;
+}
+
+void Progress::SetCallback(const mxArray* callback)
+{
+	if(!mxIsClass(callback, "function_handle"))
+	{
+		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "InvalidCallbackError", "The progress callback must be a function handle.");
+	}
+	if(g_callback != nullptr)
+	{
+		mxDestroyArray(g_callback);
+	}
+	g_callback = mxDuplicateArray(callback);
+	mexMakeArrayPersistent(g_callback);
+	g_last_report = std::chrono::steady_clock::now();
+}
+
+void Progress::SetInterval(double interval)
+{
+	g_interval = interval;
+}
+
+void Progress::AddTotal(size_t count)
+{
+	if(Progress::IsCallThread())
+	{
+		g_total += count;
+	}
+}
+
+void Progress::Advance(size_t count)
+{
+	if(Progress::IsCallThread())
+	{
+		g_done += count;
+	}
+}
+
+bool Progress::IsCallThread()
+{
+	return t_is_call_worker || MEXError::IsMainThread();
+}
+
+Progress::CallScope::CallScope(bool is_call_thread) : _was_call_thread(t_is_call_worker)
+{
+	t_is_call_worker = is_call_thread;
+}
+
+Progress::CallScope::~CallScope()
+{
+	t_is_call_worker = this->_was_call_thread;
+}
+
+bool Progress::IsCancelled()
+{
+	return g_is_cancelled;
+}
+
+bool Progress::Poll()
+{
+	if(!MEXError::IsMainThread())
+	{
+		/* background jobs are not tied to a call, so they are never cancelled */
+		return false;
+	}
+	
+	if(g_is_cancelled)
+	{
+		return true;
+	}
+	
+	if(utIsInterruptPending())
+	{
+		g_is_cancelled = true;
+		return true;
+	}
+	
+	if(g_callback != nullptr && std::chrono::duration<double>(std::chrono::steady_clock::now() - g_last_report).count() >= g_interval)
+	{
+		Report();
+	}
+	return g_is_cancelled;
+}
+
+void Progress::CheckInterrupt()
+{
+	if(Progress::Poll())
+	{
+		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "InterruptedError", "The operation was cancelled.");
+	}
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+
+#include "mex.h"
+
+namespace DXTMEX
+{
+	/* cooperative cancellation and progress reporting for the native loops.
+	 * workers only touch the shared counters, MATLAB is polled from the main thread. */
+	namespace Progress
+	{
+		/* seconds between callbacks unless a rate is given */
+		constexpr double DEFAULT_INTERVAL = 0.5;
+		
+		/* clears the state left by the last call, run at the start of every call on the main thread */
+		void Reset();
+		
+		/* callback is called as callback(done, total) at most once per interval of seconds */
+		void SetCallback(const mxArray* callback);
+		void SetInterval(double interval);
+		
+		/* any thread, but only work done for the current call is counted, so background jobs do not show up in its callback */
+		void AddTotal(size_t count);
+		void Advance(size_t count);
+		bool IsCancelled();
+		
+		/* true on the main thread and on the workers it started for the current call */
+		bool IsCallThread();
+		
+		/* marks a worker thread as working for the current call while in scope, set by Parallel::For from its caller */
+		class CallScope
+		{
+		public:
+			explicit CallScope(bool is_call_thread);
+			~CallScope();
+			CallScope(const CallScope&) = delete;
+			CallScope& operator=(const CallScope&) = delete;
+		private:
+			bool _was_call_thread;
+		};
+		
+		/* checks for Ctrl-C and runs the callback if it is due. returns IsCancelled(), or false off the main thread */
+		bool Poll();
+		
+		/* raises an error if the call was cancelled. workers must have been joined */
+		void CheckInterrupt();
+	}
+}
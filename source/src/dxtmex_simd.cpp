@@ -0,0 +1,548 @@
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#  if defined(_MSC_VER)
+#    include <intrin.h>
+#  else
+#    include <cpuid.h>
+#  endif
+#  include <immintrin.h>
+#  define DXTMEX_USE_X86
+#endif
+
+/* MSVC allows any intrinsic in any function, other compilers need the instruction set per function */
+#if defined(_MSC_VER)
+#  define DXTMEX_TARGET(isa)
+#else
+#  define DXTMEX_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+#include "dxtmex_simd.hpp"
+#include "dxtmex_mexerror.hpp"
+
+using namespace DXTMEX;
+
+namespace
+{
+	/* dst_rows[j][i] = src_rows[i][j] for a square tile */
+	typedef void (*TransposeFunction)(const uint8_t* const* src_rows, uint8_t* const* dst_rows);
+
+	struct TransposeKernel
+	{
+		size_t            tile; /* rows and elements per row */
+		TransposeFunction func;
+	};
+
+	typedef void (*ReduceErrorFunction)(const float* a, const float* b, size_t num_pixels, double* sum_sq, float* max_abs);
+	typedef void (*MultiplyAddFunction)(const float* src, float weight, size_t count, float* dst);
+
+	struct Kernels
+	{
+		TransposeKernel     transpose[3]; /* for 1, 2 and 4 byte elements */
+		ReduceErrorFunction reduce_error;
+		MultiplyAddFunction multiply_add;
+	};
+
+	constexpr size_t MAX_TILE          = 16;
+	constexpr size_t MAX_TILE_ROW_SIZE = 64; /* bytes in a row of any tile */
+	constexpr size_t CACHE_LINE_SIZE   = 64;
+
+	template <typename T, size_t N>
+	void TransposeScalar(const uint8_t* const* src_rows, uint8_t* const* dst_rows)
+	{
+		for(size_t j = 0; j < N; j++)
+		{
+			T* dst = reinterpret_cast<T*>(dst_rows[j]);
+			for(size_t i = 0; i < N; i++)
+			{
+				dst[i] = reinterpret_cast<const T*>(src_rows[i])[j];
+			}
+		}
+	}
+
+	void ReduceErrorScalar(const float* a, const float* b, size_t num_pixels, double* sum_sq, float* max_abs)
+	{
+		for(size_t i = 0; i < num_pixels * 4; i++)
+		{
+			const float diff = a[i] - b[i];
+			const float abs_diff = std::fabs(diff);
+			sum_sq[i % 4] += static_cast<double>(diff) * diff;
+			if(abs_diff > max_abs[i % 4])
+			{
+				max_abs[i % 4] = abs_diff;
+			}
+		}
+	}
+
+	/* separate multiplies and adds round the same in every variant, fused ones would not */
+	void MultiplyAddScalar(const float* src, float weight, size_t count, float* dst)
+	{
+		for(size_t i = 0; i < count; i++)
+		{
+			dst[i] += weight * src[i];
+		}
+	}
+
+#if defined(DXTMEX_USE_X86)
+
+	/* log2(N) perfect shuffles of the rows transpose an N x N tile */
+	DXTMEX_TARGET("sse2")
+	void Transpose8SSE2(const uint8_t* const* src_rows, uint8_t* const* dst_rows)
+	{
+		__m128i a[16], b[16];
+		for(int i = 0; i < 16; i++)
+		{
+			a[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src_rows[i]));
+		}
+		for(int stage = 0; stage < 4; stage++)
+		{
+			for(int i = 0; i < 8; i++)
+			{
+				b[2 * i]     = _mm_unpacklo_epi8(a[i], a[i + 8]);
+				b[2 * i + 1] = _mm_unpackhi_epi8(a[i], a[i + 8]);
+			}
+			std::copy(b, b + 16, a);
+		}
+		for(int j = 0; j < 16; j++)
+		{
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst_rows[j]), a[j]);
+		}
+	}
+
+	DXTMEX_TARGET("sse2")
+	void Transpose16SSE2(const uint8_t* const* src_rows, uint8_t* const* dst_rows)
+	{
+		__m128i a[8], b[8];
+		for(int i = 0; i < 8; i++)
+		{
+			a[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src_rows[i]));
+		}
+		for(int stage = 0; stage < 3; stage++)
+		{
+			for(int i = 0; i < 4; i++)
+			{
+				b[2 * i]     = _mm_unpacklo_epi16(a[i], a[i + 4]);
+				b[2 * i + 1] = _mm_unpackhi_epi16(a[i], a[i + 4]);
+			}
+			std::copy(b, b + 8, a);
+		}
+		for(int j = 0; j < 8; j++)
+		{
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst_rows[j]), a[j]);
+		}
+	}
+
+	DXTMEX_TARGET("sse2")
+	void Transpose32SSE2(const uint8_t* const* src_rows, uint8_t* const* dst_rows)
+	{
+		const __m128i r0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src_rows[0]));
+		const __m128i r1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src_rows[1]));
+		const __m128i r2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src_rows[2]));
+		const __m128i r3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src_rows[3]));
+		const __m128i t0 = _mm_unpacklo_epi32(r0, r1);
+		const __m128i t1 = _mm_unpacklo_epi32(r2, r3);
+		const __m128i t2 = _mm_unpackhi_epi32(r0, r1);
+		const __m128i t3 = _mm_unpackhi_epi32(r2, r3);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst_rows[0]), _mm_unpacklo_epi64(t0, t1));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst_rows[1]), _mm_unpackhi_epi64(t0, t1));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst_rows[2]), _mm_unpacklo_epi64(t2, t3));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst_rows[3]), _mm_unpackhi_epi64(t2, t3));
+	}
+
+	/* one pixel per vector, the lanes are the channels */
+	DXTMEX_TARGET("sse2")
+	void ReduceErrorSSE2(const float* a, const float* b, size_t num_pixels, double* sum_sq, float* max_abs)
+	{
+		const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+		__m128d sum_rg = _mm_loadu_pd(sum_sq);
+		__m128d sum_ba = _mm_loadu_pd(sum_sq + 2);
+		__m128 max = _mm_loadu_ps(max_abs);
+		for(size_t i = 0; i < num_pixels; i++)
+		{
+			const __m128 diff = _mm_sub_ps(_mm_loadu_ps(a + 4 * i), _mm_loadu_ps(b + 4 * i));
+
+			/* maxps returns the second operand for NaN */
+			max = _mm_max_ps(_mm_and_ps(diff, abs_mask), max);
+			const __m128d diff_rg = _mm_cvtps_pd(diff);
+			const __m128d diff_ba = _mm_cvtps_pd(_mm_movehl_ps(diff, diff));
+			sum_rg = _mm_add_pd(sum_rg, _mm_mul_pd(diff_rg, diff_rg));
+			sum_ba = _mm_add_pd(sum_ba, _mm_mul_pd(diff_ba, diff_ba));
+		}
+		_mm_storeu_pd(sum_sq, sum_rg);
+		_mm_storeu_pd(sum_sq + 2, sum_ba);
+		_mm_storeu_ps(max_abs, max);
+	}
+
+	DXTMEX_TARGET("sse2")
+	void MultiplyAddSSE2(const float* src, float weight, size_t count, float* dst)
+	{
+		const __m128 w = _mm_set1_ps(weight);
+		size_t i = 0;
+		for(; i + 4 <= count; i += 4)
+		{
+			_mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), _mm_mul_ps(w, _mm_loadu_ps(src + i))));
+		}
+		MultiplyAddScalar(src + i, weight, count - i, dst + i);
+	}
+
+	DXTMEX_TARGET("avx2")
+	void Transpose32AVX2(const uint8_t* const* src_rows, uint8_t* const* dst_rows)
+	{
+		__m256 r[8];
+		for(int i = 0; i < 8; i++)
+		{
+			r[i] = _mm256_loadu_ps(reinterpret_cast<const float*>(src_rows[i]));
+		}
+
+		/* shuffles only, so the bits of NaNs and denormals pass through */
+		__m256 t[8], s[8];
+		for(int i = 0; i < 4; i++)
+		{
+			t[2 * i]     = _mm256_unpacklo_ps(r[2 * i], r[2 * i + 1]);
+			t[2 * i + 1] = _mm256_unpackhi_ps(r[2 * i], r[2 * i + 1]);
+		}
+		for(int i = 0; i < 2; i++)
+		{
+			s[4 * i]     = _mm256_shuffle_ps(t[4 * i],     t[4 * i + 2], _MM_SHUFFLE(1, 0, 1, 0));
+			s[4 * i + 1] = _mm256_shuffle_ps(t[4 * i],     t[4 * i + 2], _MM_SHUFFLE(3, 2, 3, 2));
+			s[4 * i + 2] = _mm256_shuffle_ps(t[4 * i + 1], t[4 * i + 3], _MM_SHUFFLE(1, 0, 1, 0));
+			s[4 * i + 3] = _mm256_shuffle_ps(t[4 * i + 1], t[4 * i + 3], _MM_SHUFFLE(3, 2, 3, 2));
+		}
+		for(int j = 0; j < 4; j++)
+		{
+			_mm256_storeu_ps(reinterpret_cast<float*>(dst_rows[j]),     _mm256_permute2f128_ps(s[j], s[j + 4], 0x20));
+			_mm256_storeu_ps(reinterpret_cast<float*>(dst_rows[j + 4]), _mm256_permute2f128_ps(s[j], s[j + 4], 0x31));
+		}
+		_mm256_zeroupper();
+	}
+
+	/* two pixels per vector */
+	DXTMEX_TARGET("avx2")
+	void ReduceErrorAVX2(const float* a, const float* b, size_t num_pixels, double* sum_sq, float* max_abs)
+	{
+		const __m256 abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+		__m256d sum_lo = _mm256_loadu_pd(sum_sq);
+		__m256d sum_hi = _mm256_setzero_pd();
+		__m256 max = _mm256_castps128_ps256(_mm_loadu_ps(max_abs));
+		max = _mm256_insertf128_ps(max, _mm_loadu_ps(max_abs), 1);
+		size_t i = 0;
+		for(; i + 2 <= num_pixels; i += 2)
+		{
+			const __m256 diff = _mm256_sub_ps(_mm256_loadu_ps(a + 4 * i), _mm256_loadu_ps(b + 4 * i));
+			max = _mm256_max_ps(_mm256_and_ps(diff, abs_mask), max);
+			const __m256d diff_lo = _mm256_cvtps_pd(_mm256_castps256_ps128(diff));
+			const __m256d diff_hi = _mm256_cvtps_pd(_mm256_extractf128_ps(diff, 1));
+			sum_lo = _mm256_add_pd(sum_lo, _mm256_mul_pd(diff_lo, diff_lo));
+			sum_hi = _mm256_add_pd(sum_hi, _mm256_mul_pd(diff_hi, diff_hi));
+		}
+		_mm256_storeu_pd(sum_sq, _mm256_add_pd(sum_lo, sum_hi));
+		_mm_storeu_ps(max_abs, _mm_max_ps(_mm256_castps256_ps128(max), _mm256_extractf128_ps(max, 1)));
+		_mm256_zeroupper();
+		ReduceErrorScalar(a + 4 * i, b + 4 * i, num_pixels - i, sum_sq, max_abs);
+	}
+
+	DXTMEX_TARGET("avx2")
+	void MultiplyAddAVX2(const float* src, float weight, size_t count, float* dst)
+	{
+		const __m256 w = _mm256_set1_ps(weight);
+		size_t i = 0;
+		for(; i + 8 <= count; i += 8)
+		{
+			_mm256_storeu_ps(dst + i, _mm256_add_ps(_mm256_loadu_ps(dst + i), _mm256_mul_ps(w, _mm256_loadu_ps(src + i))));
+		}
+		_mm256_zeroupper();
+		MultiplyAddScalar(src + i, weight, count - i, dst + i);
+	}
+
+	/* four pixels per vector */
+	DXTMEX_TARGET("avx512f")
+	void ReduceErrorAVX512(const float* a, const float* b, size_t num_pixels, double* sum_sq, float* max_abs)
+	{
+		const __m512 max_init = _mm512_broadcast_f32x4(_mm_loadu_ps(max_abs));
+		__m512d sum_lo = _mm512_setzero_pd();
+		__m512d sum_hi = _mm512_setzero_pd();
+		__m512 max = max_init;
+		size_t i = 0;
+		for(; i + 4 <= num_pixels; i += 4)
+		{
+			const __m512 diff = _mm512_sub_ps(_mm512_loadu_ps(a + 4 * i), _mm512_loadu_ps(b + 4 * i));
+			max = _mm512_max_ps(_mm512_abs_ps(diff), max);
+			const __m512d diff_lo = _mm512_cvtps_pd(_mm512_castps512_ps256(diff));
+			const __m512d diff_hi = _mm512_cvtps_pd(_mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(diff), 1)));
+			sum_lo = _mm512_add_pd(sum_lo, _mm512_mul_pd(diff_lo, diff_lo));
+			sum_hi = _mm512_add_pd(sum_hi, _mm512_mul_pd(diff_hi, diff_hi));
+		}
+
+		/* fold the pixels of each vector onto the channels */
+		alignas(64) double sums[8];
+		alignas(64) float maxes[16];
+		_mm512_store_pd(sums, _mm512_add_pd(sum_lo, sum_hi));
+		_mm512_store_ps(maxes, max);
+		_mm256_zeroupper();
+		for(int c = 0; c < 4; c++)
+		{
+			sum_sq[c] += sums[c] + sums[c + 4];
+			max_abs[c] = std::max(std::max(maxes[c], maxes[c + 4]), std::max(maxes[c + 8], maxes[c + 12]));
+		}
+		ReduceErrorScalar(a + 4 * i, b + 4 * i, num_pixels - i, sum_sq, max_abs);
+	}
+
+	void CPUID(int leaf, int subleaf, uint32_t regs[4])
+	{
+#if defined(_MSC_VER)
+		int info[4];
+		__cpuidex(info, leaf, subleaf);
+		for(int i = 0; i < 4; i++)
+		{
+			regs[i] = static_cast<uint32_t>(info[i]);
+		}
+#else
+		__cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+	}
+
+	/* the register state the OS saves on context switches */
+	uint64_t GetXCR0()
+	{
+#if defined(_MSC_VER)
+		return _xgetbv(0);
+#else
+		uint32_t lo, hi;
+		__asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+		return (static_cast<uint64_t>(hi) << 32) | lo;
+#endif
+	}
+
+#endif
+
+	SIMD::LEVEL DetectLevel()
+	{
+#if defined(DXTMEX_USE_X86)
+		uint32_t regs[4];
+		CPUID(0, 0, regs);
+		const uint32_t max_leaf = regs[0];
+
+		CPUID(1, 0, regs);
+		if(!(regs[3] & (1u << 26)))
+		{
+			return SIMD::LEVEL::SCALAR;
+		}
+
+		const bool has_osxsave = (regs[2] & (1u << 27)) != 0;
+		const bool has_avx = (regs[2] & (1u << 28)) != 0;
+		if(!has_osxsave || !has_avx || max_leaf < 7)
+		{
+			return SIMD::LEVEL::SSE2;
+		}
+
+		/* XMM and YMM state, then opmask and both halves of ZMM */
+		const uint64_t xcr0 = GetXCR0();
+		if((xcr0 & 0x06u) != 0x06u)
+		{
+			return SIMD::LEVEL::SSE2;
+		}
+
+		CPUID(7, 0, regs);
+		if(!(regs[1] & (1u << 5)))
+		{
+			return SIMD::LEVEL::SSE2;
+		}
+		if((regs[1] & (1u << 16)) && (xcr0 & 0xE6u) == 0xE6u)
+		{
+			return SIMD::LEVEL::AVX512;
+		}
+		return SIMD::LEVEL::AVX2;
+#else
+		return SIMD::LEVEL::SCALAR;
+#endif
+	}
+
+	bool EqualsIgnoreCase(const char* a, const char* b)
+	{
+		for(; *a != '\0' && *b != '\0'; a++, b++)
+		{
+			if(tolower(static_cast<unsigned char>(*a)) != tolower(static_cast<unsigned char>(*b)))
+			{
+				return false;
+			}
+		}
+		return *a == *b;
+	}
+
+	/* runs while the MEX file is loaded, so errors cannot be raised here */
+	SIMD::LEVEL SelectLevel()
+	{
+		const SIMD::LEVEL detected = DetectLevel();
+		const char* forced = getenv("DXTMEX_SIMD");
+		if(forced != nullptr)
+		{
+			for(SIMD::LEVEL level : {SIMD::LEVEL::SCALAR, SIMD::LEVEL::SSE2, SIMD::LEVEL::AVX2, SIMD::LEVEL::AVX512})
+			{
+				if(EqualsIgnoreCase(forced, SIMD::GetLevelName(level)))
+				{
+					return std::min(level, detected);
+				}
+			}
+		}
+		return detected;
+	}
+
+	/* levels without a variant of their own inherit the one below */
+	Kernels SelectKernels(SIMD::LEVEL level)
+	{
+		Kernels kernels =
+		{
+			{{8, &TransposeScalar<uint8_t, 8>}, {8, &TransposeScalar<uint16_t, 8>}, {8, &TransposeScalar<uint32_t, 8>}},
+			&ReduceErrorScalar,
+			&MultiplyAddScalar
+		};
+#if defined(DXTMEX_USE_X86)
+		if(level >= SIMD::LEVEL::SSE2)
+		{
+			kernels.transpose[0] = {16, &Transpose8SSE2};
+			kernels.transpose[1] = {8, &Transpose16SSE2};
+			kernels.transpose[2] = {4, &Transpose32SSE2};
+			kernels.reduce_error = &ReduceErrorSSE2;
+			kernels.multiply_add = &MultiplyAddSSE2;
+		}
+		if(level >= SIMD::LEVEL::AVX2)
+		{
+			kernels.transpose[2] = {8, &Transpose32AVX2};
+			kernels.reduce_error = &ReduceErrorAVX2;
+			kernels.multiply_add = &MultiplyAddAVX2;
+		}
+		if(level >= SIMD::LEVEL::AVX512)
+		{
+			kernels.reduce_error = &ReduceErrorAVX512;
+		}
+#endif
+		return kernels;
+	}
+
+	const SIMD::LEVEL g_level = SelectLevel();
+	const Kernels     g_kernels = SelectKernels(g_level);
+
+	const TransposeKernel& GetTransposeKernel(size_t elem_size)
+	{
+		switch(elem_size)
+		{
+			case 1: return g_kernels.transpose[0];
+			case 2: return g_kernels.transpose[1];
+			case 4: return g_kernels.transpose[2];
+			default:
+			{
+				MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_INTERNAL, "UnexpectedElementSizeError", "Unexpected element size %llu for a transpose.", elem_size);
+			}
+		}
+		return g_kernels.transpose[0];
+	}
+
+	/* transposes a rows x cols matrix of elements. src(r, c) is the address of element (r, c) and dst(c, r) the address
+	 * it goes to, rows continue contiguously from both. the tiles are walked in blocks a cache line wide, so every
+	 * line of the destination is filled before moving on. edges are copied one element at a time. */
+	template <typename S, typename D>
+	void Transpose(size_t elem_size, size_t rows, size_t cols, S&& src, D&& dst)
+	{
+		const TransposeKernel& kernel = GetTransposeKernel(elem_size);
+		const size_t tile = kernel.tile;
+		const size_t block = std::max(tile, CACHE_LINE_SIZE / elem_size);
+		const uint8_t* src_rows[MAX_TILE];
+		uint8_t* dst_rows[MAX_TILE];
+		size_t i, j, r0, c0, r1, c1;
+		for(r0 = 0; r0 < rows; r0 += block)
+		{
+			for(c0 = 0; c0 < cols; c0 += block)
+			{
+				for(c1 = c0; c1 < std::min(c0 + block, cols); c1 += tile)
+				{
+					for(r1 = r0; r1 < std::min(r0 + block, rows); r1 += tile)
+					{
+						const size_t tile_rows = std::min(tile, rows - r1);
+						const size_t tile_cols = std::min(tile, cols - c1);
+						if(tile_rows == tile && tile_cols == tile)
+						{
+							for(i = 0; i < tile; i++)
+							{
+								src_rows[i] = src(r1 + i, c1);
+								dst_rows[i] = dst(c1 + i, r1);
+							}
+							kernel.func(src_rows, dst_rows);
+							continue;
+						}
+						for(j = 0; j < tile_cols; j++)
+						{
+							uint8_t* dst_row = dst(c1 + j, r1);
+							for(i = 0; i < tile_rows; i++)
+							{
+								memcpy(dst_row + i * elem_size, src(r1 + i, c1) + j * elem_size, elem_size);
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+SIMD::LEVEL SIMD::GetLevel()
+{
+	return g_level;
+}
+
+const char* SIMD::GetLevelName(LEVEL level)
+{
+	switch(level)
+	{
+		case LEVEL::SCALAR: return "scalar";
+		case LEVEL::SSE2:   return "sse2";
+		case LEVEL::AVX2:   return "avx2";
+		case LEVEL::AVX512: return "avx512";
+	}
+	return "unknown";
+}
+
+void SIMD::ExtractPlanar(const uint8_t* pixels, size_t row_pitch, size_t width, size_t height, size_t elems_per_pixel, size_t elem_size, uint8_t* const* planes)
+{
+	/* skipped elements are written here and never read */
+	uint8_t sink[MAX_TILE_ROW_SIZE];
+	Transpose(elem_size, height, width * elems_per_pixel, [&](size_t y, size_t k)
+	{
+		return pixels + y * row_pitch + k * elem_size;
+	}, [&](size_t k, size_t y)
+	{
+		uint8_t* plane = planes[k % elems_per_pixel];
+		return (plane == nullptr)? sink : plane + ((k / elems_per_pixel) * height + y) * elem_size;
+	});
+}
+
+void SIMD::InsertPlanar(const uint8_t* const* planes, const uint8_t* fill, size_t width, size_t height, size_t elems_per_pixel, size_t elem_size, uint8_t* pixels, size_t row_pitch)
+{
+	/* the planes are the rows of the transposed image, so this is the same transpose in the other direction */
+	uint8_t fill_row[MAX_TILE_ROW_SIZE];
+	for(size_t i = 0; i < MAX_TILE_ROW_SIZE / elem_size; i++)
+	{
+		memcpy(fill_row + i * elem_size, fill, elem_size);
+	}
+	Transpose(elem_size, width * elems_per_pixel, height, [&](size_t k, size_t y)
+	{
+		const uint8_t* plane = planes[k % elems_per_pixel];
+		return (plane == nullptr)? fill_row : plane + ((k / elems_per_pixel) * height + y) * elem_size;
+	}, [&](size_t y, size_t k)
+	{
+		return pixels + y * row_pitch + k * elem_size;
+	});
+}
+
+void SIMD::ReduceError(const float* a, const float* b, size_t num_pixels, double* sum_sq, float* max_abs)
+{
+	g_kernels.reduce_error(a, b, num_pixels, sum_sq, max_abs);
+}
+
+void SIMD::MultiplyAdd(const float* src, float weight, size_t count, float* dst)
+{
+	g_kernels.multiply_add(src, weight, count, dst);
+}
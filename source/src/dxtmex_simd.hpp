@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace DXTMEX
+{
+	/* hot kernels compiled for several instruction sets. the best set the CPU supports is selected once when
+	 * the MEX file is loaded. setting the environment variable DXTMEX_SIMD to scalar, sse2, avx2 or avx512
+	 * before loading forces a lower level for testing, unknown values and unsupported levels are ignored. */
+	namespace SIMD
+	{
+		enum class LEVEL
+		{
+			SCALAR,
+			SSE2,
+			AVX2,
+			AVX512
+		};
+
+		LEVEL GetLevel();
+		const char* GetLevelName(LEVEL level);
+
+		/* deinterleaves a row-major image with elems_per_pixel elements of elem_size (1, 2 or 4) bytes per pixel
+		 * into column-major planes, so planes[e][x * height + y] is element e of pixel (x, y). null planes are skipped. */
+		void ExtractPlanar(const uint8_t* pixels, size_t row_pitch, size_t width, size_t height, size_t elems_per_pixel, size_t elem_size, uint8_t* const* planes);
+
+		/* the inverse of ExtractPlanar. elements with a null plane are set to the single element at fill */
+		void InsertPlanar(const uint8_t* const* planes, const uint8_t* fill, size_t width, size_t height, size_t elems_per_pixel, size_t elem_size, uint8_t* pixels, size_t row_pitch);
+
+		/* adds the squared differences of two interleaved RGBA float rows to sum_sq and raises max_abs to the largest
+		 * absolute difference, both per channel. NaN differences are left out of max_abs. */
+		void ReduceError(const float* a, const float* b, size_t num_pixels, double* sum_sq, float* max_abs);
+
+		/* dst[i] += weight * src[i], rounded identically at every level */
+		void MultiplyAdd(const float* src, float weight, size_t count, float* dst);
+	}
+}
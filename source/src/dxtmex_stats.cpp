@@ -0,0 +1,205 @@
+#include <algorithm>
+#include <map>
+#include <mutex>
+
+#include "dxtmex_stats.hpp"
+
+using namespace DXTMEX;
+
+namespace
+{
+	struct Record
+	{
+		size_t calls;
+		double total_time;
+		double import_time;
+		double export_time;
+		double background_time;
+		size_t bytes_in;
+		size_t bytes_out;
+		size_t arrays_created;
+		size_t subresources;
+		size_t max_threads;
+	};
+
+	std::mutex                                   g_lock;
+	std::map<DXTImageArray::OPERATION, Record>   g_records;
+
+	/* the call being recorded on this thread */
+	thread_local bool                                  t_is_recording = false;
+	thread_local DXTImageArray::OPERATION              t_op = DXTImageArray::OPERATION::NO_OP;
+	thread_local Record                                t_pending;
+	thread_local std::chrono::steady_clock::time_point t_start;
+
+	double SecondsSince(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	/* counts the arrays in a tree and the bytes of their data */
+	void Measure(const mxArray* arr, size_t& num_arrays, size_t& num_bytes)
+	{
+		size_t i;
+		int j;
+		if(arr == nullptr)
+		{
+			return;
+		}
+		num_arrays++;
+		if(mxIsStruct(arr))
+		{
+			for(i = 0; i < mxGetNumberOfElements(arr); i++)
+			{
+				for(j = 0; j < mxGetNumberOfFields(arr); j++)
+				{
+					Measure(mxGetFieldByNumber(arr, i, j), num_arrays, num_bytes);
+				}
+			}
+		}
+		else if(mxIsCell(arr))
+		{
+			for(i = 0; i < mxGetNumberOfElements(arr); i++)
+			{
+				Measure(mxGetCell(arr, i), num_arrays, num_bytes);
+			}
+		}
+		else if(mxIsNumeric(arr) || mxIsChar(arr) || mxIsLogical(arr))
+		{
+			num_bytes += mxGetNumberOfElements(arr) * mxGetElementSize(arr);
+		}
+	}
+
+	void Merge(DXTImageArray::OPERATION op, const Record& pending)
+	{
+		std::lock_guard<std::mutex> guard(g_lock);
+		Record& record = g_records[op];
+		record.calls           += pending.calls;
+		record.total_time      += pending.total_time;
+		record.import_time     += pending.import_time;
+		record.export_time     += pending.export_time;
+		record.background_time += pending.background_time;
+		record.bytes_in        += pending.bytes_in;
+		record.bytes_out       += pending.bytes_out;
+		record.arrays_created  += pending.arrays_created;
+		record.subresources    += pending.subresources;
+		record.max_threads      = std::max(record.max_threads, pending.max_threads);
+	}
+}
+
+void Stats::Begin(DXTImageArray::OPERATION op, int nrhs, const mxArray* prhs[])
+{
+	size_t num_arrays = 0;
+	t_is_recording = true;
+	t_op = op;
+	t_pending = Record();
+	t_start = std::chrono::steady_clock::now();
+	for(int i = 0; i < nrhs; i++)
+	{
+		Measure(prhs[i], num_arrays, t_pending.bytes_in);
+	}
+}
+
+void Stats::End(int nlhs, mxArray* plhs[])
+{
+	if(!t_is_recording)
+	{
+		return;
+	}
+	t_is_recording = false;
+
+	/* the directives which read the stats are left out of them */
+	if(t_op == DXTImageArray::OPERATION::STATS || t_op == DXTImageArray::OPERATION::STATS_RESET)
+	{
+		return;
+	}
+
+	for(int i = 0; i < std::max(nlhs, 1); i++)
+	{
+		Measure(plhs[i], t_pending.arrays_created, t_pending.bytes_out);
+	}
+	t_pending.calls = 1;
+	t_pending.total_time = SecondsSince(t_start);
+	Merge(t_op, t_pending);
+}
+
+void Stats::AddSubresources(size_t count)
+{
+	t_pending.subresources += count;
+}
+
+void Stats::AddThreads(size_t count)
+{
+	t_pending.max_threads = std::max(t_pending.max_threads, count);
+}
+
+DXTImageArray::OPERATION Stats::GetOperation()
+{
+	return t_op;
+}
+
+Stats::Timer::~Timer()
+{
+	const double elapsed = SecondsSince(this->_start);
+	switch(this->_phase)
+	{
+		case PHASE::IMPORT:
+		{
+			t_pending.import_time += elapsed;
+			break;
+		}
+		case PHASE::EXPORT:
+		{
+			t_pending.export_time += elapsed;
+			break;
+		}
+	}
+}
+
+Stats::BackgroundScope::BackgroundScope(DXTImageArray::OPERATION op) : _start(std::chrono::steady_clock::now())
+{
+	t_is_recording = true;
+	t_op = op;
+	t_pending = Record();
+}
+
+Stats::BackgroundScope::~BackgroundScope()
+{
+	t_is_recording = false;
+	t_pending.background_time = SecondsSince(this->_start);
+	Merge(t_op, t_pending);
+}
+
+void Stats::Export(int, mxArray* plhs[])
+{
+	size_t i = 0;
+	const char* fieldnames[] = {"Directive", "Calls", "TotalTime", "ImportTime", "KernelTime", "ExportTime", "BackgroundTime",
+	                            "BytesIn", "BytesOut", "ArraysCreated", "Subresources", "MaxThreads"};
+	std::lock_guard<std::mutex> guard(g_lock);
+	plhs[0] = mxCreateStructMatrix(g_records.size(), 1, ARRAYSIZE(fieldnames), fieldnames);
+	for(const auto& entry : g_records)
+	{
+		const Record& record = entry.second;
+
+		/* whatever is not marshalling is the work of the directive itself */
+		const double kernel_time = std::max(record.total_time - record.import_time - record.export_time, 0.0);
+		mxSetField(plhs[0], i, "Directive",      mxCreateString(DXTImageArray::GetOperationName(entry.first)));
+		mxSetField(plhs[0], i, "Calls",          mxCreateDoubleScalar(static_cast<double>(record.calls)));
+		mxSetField(plhs[0], i, "TotalTime",      mxCreateDoubleScalar(record.total_time));
+		mxSetField(plhs[0], i, "ImportTime",     mxCreateDoubleScalar(record.import_time));
+		mxSetField(plhs[0], i, "KernelTime",     mxCreateDoubleScalar(kernel_time));
+		mxSetField(plhs[0], i, "ExportTime",     mxCreateDoubleScalar(record.export_time));
+		mxSetField(plhs[0], i, "BackgroundTime", mxCreateDoubleScalar(record.background_time));
+		mxSetField(plhs[0], i, "BytesIn",        mxCreateDoubleScalar(static_cast<double>(record.bytes_in)));
+		mxSetField(plhs[0], i, "BytesOut",       mxCreateDoubleScalar(static_cast<double>(record.bytes_out)));
+		mxSetField(plhs[0], i, "ArraysCreated",  mxCreateDoubleScalar(static_cast<double>(record.arrays_created)));
+		mxSetField(plhs[0], i, "Subresources",   mxCreateDoubleScalar(static_cast<double>(record.subresources)));
+		mxSetField(plhs[0], i, "MaxThreads",     mxCreateDoubleScalar(static_cast<double>(record.max_threads)));
+		i++;
+	}
+}
+
+void Stats::Reset()
+{
+	std::lock_guard<std::mutex> guard(g_lock);
+	g_records.clear();
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <chrono>
+
+#include "mex.h"
+#include "dxtmex_dxtimagearray.hpp"
+
+namespace DXTMEX
+{
+	/* timers and counters accumulated per directive, returned by STATS and cleared by STATS_RESET.
+	 * a call records into its own thread and is merged when it returns, so calls which error are left out. */
+	namespace Stats
+	{
+		enum class PHASE
+		{
+			IMPORT,
+			EXPORT
+		};
+
+		/* main thread only, measures the inputs */
+		void Begin(DXTImageArray::OPERATION op, MEXF_IN);
+
+		/* main thread only, measures the outputs and merges the call */
+		void End(MEXF_OUT);
+
+		/* any thread which is recording */
+		void AddSubresources(size_t count);
+		void AddThreads(size_t count);
+
+		/* the directive recorded on this thread, for handing to a background job */
+		DXTImageArray::OPERATION GetOperation();
+
+		/* adds the time spent in its scope to a phase of the call */
+		class Timer
+		{
+		public:
+			explicit Timer(PHASE phase) : _phase(phase), _start(std::chrono::steady_clock::now()) {};
+			~Timer();
+		private:
+			PHASE                                 _phase;
+			std::chrono::steady_clock::time_point _start;
+		};
+
+		/* records a background job as background time of the directive which started it */
+		class BackgroundScope
+		{
+		public:
+			explicit BackgroundScope(DXTImageArray::OPERATION op);
+			~BackgroundScope();
+		private:
+			std::chrono::steady_clock::time_point _start;
+		};
+
+		void Export(MEXF_OUT);
+		void Reset();
+	}
+}
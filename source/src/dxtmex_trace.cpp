@@ -0,0 +1,240 @@
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "dxtmex_trace.hpp"
+#include "dxtmex_mexerror.hpp"
+
+using namespace DXTMEX;
+
+std::atomic<unsigned> Trace::Detail::g_session(0);
+
+namespace
+{
+	struct Event
+	{
+		const char*                           name;
+		const char*                           category;
+		std::chrono::steady_clock::time_point start;
+		std::chrono::steady_clock::time_point end;
+	};
+
+	/* single producer, the owning thread publishes each event with a release store of count */
+	struct Chunk
+	{
+		static constexpr size_t SIZE = 256;
+		Event                   events[SIZE];
+		std::atomic<size_t>     count{0};
+		std::atomic<Chunk*>     next{nullptr};
+	};
+
+	struct ThreadBuffer
+	{
+		size_t            tid;
+		bool              is_main;
+		Chunk*            head;     /* oldest chunk which was not drained, owned by the reader */
+		size_t            num_read; /* events of head which were drained */
+		Chunk*            tail;     /* owned by the writer */
+		std::atomic<bool> is_retired{false};
+	};
+
+	/* taken when a thread records its first event and when draining, never while recording */
+	std::mutex                 g_registry_lock;
+	std::vector<ThreadBuffer*> g_buffers;
+	size_t                     g_next_tid = 1;
+
+	std::wstring                          g_path;
+	std::chrono::steady_clock::time_point g_epoch;
+
+	/* marks the buffer of an exited thread so the next drain can free it */
+	struct ThreadHandle
+	{
+		ThreadBuffer* buffer = nullptr;
+		~ThreadHandle()
+		{
+			if(this->buffer != nullptr)
+			{
+				this->buffer->is_retired.store(true, std::memory_order_release);
+			}
+		}
+	};
+	thread_local ThreadHandle t_handle;
+
+	ThreadBuffer* GetThreadBuffer()
+	{
+		if(t_handle.buffer == nullptr)
+		{
+			ThreadBuffer* buffer = new ThreadBuffer;
+			buffer->is_main  = MEXError::IsMainThread();
+			buffer->head     = new Chunk;
+			buffer->num_read = 0;
+			buffer->tail     = buffer->head;
+			std::lock_guard<std::mutex> guard(g_registry_lock);
+			buffer->tid = g_next_tid++;
+			g_buffers.push_back(buffer);
+			t_handle.buffer = buffer;
+		}
+		return t_handle.buffer;
+	}
+
+	struct DrainedEvent
+	{
+		Event  event;
+		size_t tid;
+	};
+
+	/* takes every published event and frees what the writers no longer touch. main thread only */
+	void Drain(std::vector<DrainedEvent>& out, std::vector<std::pair<size_t, bool>>& threads)
+	{
+		std::lock_guard<std::mutex> guard(g_registry_lock);
+		for(auto iter = g_buffers.begin(); iter != g_buffers.end();)
+		{
+			ThreadBuffer* buffer = *iter;
+			const bool is_retired = buffer->is_retired.load(std::memory_order_acquire);
+			bool is_drained = false;
+			while(!is_drained)
+			{
+				const size_t count = buffer->head->count.load(std::memory_order_acquire);
+				for(size_t i = buffer->num_read; i < count; i++)
+				{
+					out.push_back({buffer->head->events[i], buffer->tid});
+				}
+				buffer->num_read = count;
+
+				Chunk* next = buffer->head->next.load(std::memory_order_acquire);
+				if(next == nullptr)
+				{
+					is_drained = true;
+				}
+				else
+				{
+					/* the writer moved on, so this chunk is ours */
+					delete buffer->head;
+					buffer->head = next;
+					buffer->num_read = 0;
+				}
+			}
+			threads.emplace_back(buffer->tid, buffer->is_main);
+
+			if(is_retired)
+			{
+				delete buffer->head;
+				delete buffer;
+				iter = g_buffers.erase(iter);
+			}
+			else
+			{
+				++iter;
+			}
+		}
+	}
+
+	double Microseconds(std::chrono::steady_clock::duration duration)
+	{
+		return std::chrono::duration<double, std::micro>(duration).count();
+	}
+}
+
+void Trace::Detail::Record(const char* name, const char* category, std::chrono::steady_clock::time_point start, unsigned session)
+{
+	const auto end = std::chrono::steady_clock::now();
+	if(g_session.load(std::memory_order_acquire) != session)
+	{
+		return;
+	}
+
+	ThreadBuffer* buffer = GetThreadBuffer();
+	size_t count = buffer->tail->count.load(std::memory_order_relaxed);
+	if(count == Chunk::SIZE)
+	{
+		Chunk* chunk = new Chunk;
+		buffer->tail->next.store(chunk, std::memory_order_release);
+		buffer->tail = chunk;
+		count = 0;
+	}
+	buffer->tail->events[count] = {name, category, start, end};
+	buffer->tail->count.store(count + 1, std::memory_order_release);
+}
+
+void Trace::Start(int nrhs, const mxArray* prhs[])
+{
+	if(nrhs < 1)
+	{
+		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "NotEnoughInputsError", "Not enough arguments. Please supply a file name.");
+	}
+	else if(nrhs > 1)
+	{
+		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "TooManyInputsError", "Too many arguments.");
+	}
+
+	if(Detail::g_session.load() & 1u)
+	{
+		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "TraceActiveError", "A trace is already being recorded. Call TRACE_STOP first.");
+	}
+	DXTImageArray::ImportFilename(prhs[0], g_path);
+
+	/* throw away whatever raced in after the last stop */
+	std::vector<DrainedEvent> stale;
+	std::vector<std::pair<size_t, bool>> threads;
+	Drain(stale, threads);
+
+	g_epoch = std::chrono::steady_clock::now();
+	Detail::g_session.fetch_add(1, std::memory_order_release);
+}
+
+void Trace::Stop(int nrhs, const mxArray*[])
+{
+	if(nrhs > 0)
+	{
+		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "TooManyInputsError", "Too many arguments.");
+	}
+
+	if(!(Detail::g_session.load() & 1u))
+	{
+		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER, "TraceInactiveError", "No trace is being recorded. Call TRACE_START first.");
+	}
+	Detail::g_session.fetch_add(1, std::memory_order_release);
+
+	/* jobs which are still running may miss the end of the trace, their later events are dropped */
+	std::vector<DrainedEvent> events;
+	std::vector<std::pair<size_t, bool>> threads;
+	Drain(events, threads);
+	std::sort(events.begin(), events.end(), [](const DrainedEvent& a, const DrainedEvent& b) {return a.event.start < b.event.start;});
+
+	std::ofstream out;
+	out.open(g_path, std::ios::out | std::ios::trunc);
+	if(!out.is_open())
+	{
+		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER | MEU_SEVERITY_SYSTEM, "FileOpenError", "Could not open the trace file for writing.");
+	}
+
+	out << std::fixed << std::setprecision(3);
+	out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	bool is_first = true;
+	for(const auto& thread : threads)
+	{
+		out << (is_first? "" : ",\n")
+		    << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread.first
+		    << ",\"args\":{\"name\":\"" << (thread.second? "MATLAB" : "worker ") << (thread.second? "" : std::to_string(thread.first)) << "\"}}";
+		is_first = false;
+	}
+	for(const DrainedEvent& drained : events)
+	{
+		const Event& event = drained.event;
+		out << (is_first? "" : ",\n")
+		    << "{\"name\":\"" << event.name << "\",\"cat\":\"" << event.category << "\",\"ph\":\"X\""
+		    << ",\"ts\":" << Microseconds(event.start - g_epoch) << ",\"dur\":" << Microseconds(event.end - event.start)
+		    << ",\"pid\":1,\"tid\":" << drained.tid << "}";
+		is_first = false;
+	}
+	out << "\n]}\n";
+
+	out.close();
+	if(out.fail())
+	{
+		MEXError::PrintMexError(MEU_FL, MEU_SEVERITY_USER | MEU_SEVERITY_SYSTEM, "FileWriteError", "There was an error while writing the trace file.");
+	}
+}
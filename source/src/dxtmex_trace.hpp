@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+
+#include "mex.h"
+#include "dxtmex_dxtimagearray.hpp"
+
+namespace DXTMEX
+{
+	/* opt-in timeline of directives, DirectXTex calls, file access and worker tasks. TRACE_START(path) begins
+	 * recording into per-thread buffers, TRACE_STOP writes them to path as Chrome trace JSON (chrome://tracing, Perfetto). */
+	namespace Trace
+	{
+		void Start(MEXF_IN);
+		void Stop(MEXF_IN);
+
+		namespace Detail
+		{
+			extern std::atomic<unsigned> g_session;  /* odd while recording */
+			void Record(const char* name, const char* category, std::chrono::steady_clock::time_point start, unsigned session);
+		}
+
+		/* records a complete event for its lifetime. name and category must be string literals or otherwise outlive the trace */
+		class Scope
+		{
+		public:
+			Scope(const char* name, const char* category) : _name(name), _category(category), _session(Detail::g_session.load(std::memory_order_relaxed))
+			{
+				if(this->_session & 1u)
+				{
+					this->_start = std::chrono::steady_clock::now();
+				}
+			}
+
+			~Scope()
+			{
+				if(this->_session & 1u)
+				{
+					Detail::Record(this->_name, this->_category, this->_start, this->_session);
+				}
+			}
+
+		private:
+			const char*                           _name;
+			const char*                           _category;
+			unsigned                              _session;
+			std::chrono::steady_clock::time_point _start;
+		};
+	}
+}
@@ -0,0 +1,27 @@
+% flipping or rotating a block compressed image twice should give back the
+% original bytes when every block can be permuted, and close to it otherwise
+d = readdds(fullfile('dds', 'DDS_a8b8g8r8.dds'));
+d = d.resize(128, 96);
+
+flips = {@(x) x.fliphorz, @(x) x.flipvert, @(x) x.rotate(180)};
+flip_names = {'fliphorz', 'flipvert', 'rotate(180)'};
+
+% BC7 with BC7_QUICK only uses mode 6, which can always be permuted
+exact = {{'BC1_UNORM'}, {'BC2_UNORM'}, {'BC3_UNORM'}, {'BC4_UNORM'}, {'BC5_UNORM'}, {'BC7_UNORM', 'BC7_QUICK', true}};
+for i = 1:numel(exact)
+	c = d.compress(exact{i}{:});
+	for j = 1:numel(flips)
+		f = flips{j}(flips{j}(c));
+		assert(isequal(f.Images(1).Pixels, c.Images(1).Pixels), ...
+			'%s twice changed the bytes of %s', flip_names{j}, exact{i}{1});
+	end
+end
+
+% blocks in the other BC7 modes are re-encoded, so only check the error
+c = d.compress('BC7_UNORM');
+for j = 1:numel(flips)
+	f = flips{j}(flips{j}(c));
+	[~, ~, psnr] = DXTImage.computeMSE(f, c);
+	assert(all(psnr(:) > 40), '%s twice of BC7_UNORM has a psnr of %g', flip_names{j}, min(psnr(:)));
+end
+disp('testfliprotate passed');